@@ -0,0 +1,93 @@
+// Copyright (c) embedded ocean GmbH
+#include "AbstractPointRange.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/utils/core/Uuid.hpp>
+
+#include <array>
+#include <functional>
+#include <string_view>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+namespace
+{
+
+	/// @brief The suffixes appended to the name of a point to get the names of the attributes of its fields, in the order of the
+	/// enumerators of AbstractPointRange::Field
+	constexpr std::array<std::string_view, AbstractPointRange::kFieldCount> kFieldSuffixes {
+		""sv, ".quality"sv, ".error"sv, ".updateTime"sv, ".changeTime"sv
+	};
+
+} // namespace
+
+auto AbstractPointRange::publish() -> void
+{
+	// Generate all the names first, because the attributes refer to them, so the vector must not be reallocated afterwards
+	_attributeNames.reserve(size() * kFieldCount);
+	for (std::size_t index = 0; index < size(); ++index)
+	{
+		const auto pointName = name(index);
+		for (auto &&suffix : kFieldSuffixes)
+		{
+			_attributeNames.push_back(pointName + std::string(suffix));
+		}
+	}
+
+	// Create the attributes
+	_attributes.reserve(_attributeNames.size());
+	for (std::size_t index = 0; index < _attributeNames.size(); ++index)
+	{
+		const auto &attributeType = [&]() -> const data::DataType & {
+			switch (Field(index % kFieldCount))
+			{
+			case Field::Value:
+				return dataType(index / kFieldCount);
+			case Field::Quality:
+				return model::Attribute::kQuality.dataType();
+			case Field::Error:
+				return data::DataType::kErrorCode;
+			case Field::UpdateTime:
+			case Field::ChangeTime:
+			default:
+				return data::DataType::kTimeStamp;
+			}
+		}();
+
+		/// @todo assign each attribute a unique UUID, e.g. by deriving it from the UUID of the I/O component and the name of the attribute
+		_attributes.emplace_back("deadbeef-dead-beef-dead-beefdeadbeef"_uuid, std::string_view(_attributeNames[index]),
+			model::Attribute::Access::ReadOnly, attributeType);
+	}
+}
+
+auto AbstractPointRange::forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool
+{
+	for (auto &&attribute : _attributes)
+	{
+		if (function(attribute))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+auto AbstractPointRange::makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle>
+{
+	// The attributes of the points do not have unique UUIDs, so we identify them by their address instead
+	const auto first = _attributes.data();
+	const auto last = first + _attributes.size();
+	if (std::less<>()(&attribute, first) || !std::less<>()(&attribute, last))
+	{
+		return std::nullopt;
+	}
+
+	const auto index = std::size_t(&attribute - first);
+	return pointReadHandle(index / kFieldCount, Field(index % kFieldCount));
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
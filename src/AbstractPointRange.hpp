@@ -0,0 +1,211 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "AbstractTemplateInputHandler.hpp"
+#include "Transport.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/data/ReadHandle.hpp>
+#include <xentara/model/Attribute.hpp>
+#include <xentara/model/ForEachAttributeFunction.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief Base class for a compact declaration of a range of inputs.
+///
+/// A range is either a number of equally spaced inputs of the same data type (see PointRange), or a block of registers
+/// described by a device profile (see ProfileRange).
+///
+/// A point range replaces a large number of individual input elements in the model file. The range is declared as part
+/// of the configuration of the I/O component, and is expanded into the individual points at load time. The states of
+/// all the points are stored in a single data block, and the whole range is read using the "read" task of the I/O component.
+/// The points are published as attributes of the I/O component. The value of each point uses the name generated by name(), and
+/// its quality, error, and time stamps use the name of the point followed by a dot and the name of the corresponding standard
+/// attribute, e.g. "temperature3.quality".
+/// @todo rename this class to something more descriptive
+class AbstractPointRange
+{
+public:
+	/// @brief The layout of a point range, as loaded from the configuration
+	struct Layout final
+	{
+		/// @brief The pattern used to generate the names of the points.
+		///
+		/// The placeholder "{}" is replaced by the index of the point within the range.
+		std::string _namePattern;
+		/// @brief The address of the first point
+		std::uint64_t _baseAddress { 0 };
+		/// @brief The number of points
+		std::size_t _count { 0 };
+		/// @brief The distance between the addresses of two consecutive points
+		std::uint64_t _stride { 1 };
+	};
+
+	/// @brief Constructor that sets the layout
+	AbstractPointRange(Layout layout) : _layout(std::move(layout))
+	{
+	}
+
+	/// @brief Virtual destructor
+	/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+	/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+	/// instantiable by accident as a result of refactoring.
+	virtual ~AbstractPointRange() = 0;
+
+	/// @brief Returns the number of points in the range
+	auto size() const noexcept -> std::size_t
+	{
+		return _layout._count;
+	}
+
+	/// @brief Returns the address of a point
+	/// @param index The index of the point within the range
+	auto address(std::size_t index) const noexcept -> std::uint64_t
+	{
+		return _layout._baseAddress + index * _layout._stride;
+	}
+
+	/// @brief Checks whether the range is essential.
+	///
+	/// Essential ranges are read even while the circuit breaker of the I/O component is open.
+	auto essential() const noexcept -> bool
+	{
+		return _essential;
+	}
+
+	/// @brief Sets whether the range is essential
+	auto setEssential(bool essential) noexcept -> void
+	{
+		_essential = essential;
+	}
+
+	/// @brief Generates the name of a point
+	///
+	/// The default implementation replaces the placeholder in the name pattern with the index of the point.
+	/// @param index The index of the point within the range
+	virtual auto name(std::size_t index) const -> std::string;
+
+	/// @brief Returns the data type of a point
+	/// @param index The index of the point within the range
+	virtual auto dataType(std::size_t index) const -> const data::DataType & = 0;
+
+	/// @brief The fields of a point that are published as attributes
+	enum class Field
+	{
+		/// @brief The value
+		Value,
+		/// @brief The quality
+		Quality,
+		/// @brief The read error
+		Error,
+		/// @brief The update time stamp
+		UpdateTime,
+		/// @brief The change time stamp
+		ChangeTime
+	};
+
+	/// @brief The number of fields published for each point
+	static constexpr std::size_t kFieldCount = 5;
+
+	/// @brief Creates the attributes the points are published under.
+	///
+	/// This function must only be called while the configuration is being loaded, once the layout of the range is final.
+	auto publish() -> void;
+
+	/// @brief Returns the names of all the attributes of the points. publish() must have been called.
+	auto attributeNames() const noexcept -> std::span<const std::string>
+	{
+		return _attributeNames;
+	}
+
+	/// @brief Iterates over the attributes of the points
+	/// @param function The function that should be called for each attribute
+	/// @return The return value of the last function call
+	auto forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool;
+
+	/// @brief Creates a read handle for an attribute of a point
+	/// @param attribute The attribute to create the handle for
+	/// @return A read handle for the attribute, or std::nullopt if the attribute does not belong to a point of this range
+	auto makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle>;
+
+	/// @brief Realizes the states of all the points
+	virtual auto realize() -> void = 0;
+
+	/// @brief Assigns all the points slots in the snapshot of the I/O component, so that their last known values survive a restart.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	virtual auto enableSnapshot(Snapshot &snapshot) -> void = 0;
+
+	/// @brief Enables detecting when the values of the points have not been updated for longer than the default maximum age of
+	/// the I/O component.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the index entries from
+	/// @param index The staleness index of the I/O component
+	virtual auto enableStaleness(Arena &arena, StalenessIndex &index) -> void = 0;
+
+	/// @brief Returns the number of requests needed to read all the points
+	virtual auto requestCount() const noexcept -> std::size_t = 0;
+	/// @brief Adds the requests needed to read all the points to a batch
+	///
+	/// The batch must have room for at least requestCount() requests.
+	virtual auto queueRead(Transport::Batch &batch) -> void = 0;
+	/// @brief Decodes the responses to the requests added by queueRead() and updates the states of the points accordingly.
+	/// @param lease A lease on the session the batch was sent over
+	/// @param batch The batch. This must have been submitted successfully.
+	virtual auto read(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		AbstractTemplateInputHandler::ErrorSink &errorSink) -> void = 0;
+	/// @brief Updates the states of all the points without specifying a value.
+	///
+	/// The states of all the points are updated using a single commit.
+	/// @param timeStamp The update time stamp
+	/// @param error The error code
+	virtual auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+
+protected:
+	/// @brief Creates a read handle for a field of a point
+	/// @param index The index of the point within the range
+	/// @param field The field
+	virtual auto pointReadHandle(std::size_t index, Field field) const noexcept -> data::ReadHandle = 0;
+
+	/// @brief The layout of the range
+	Layout _layout;
+
+private:
+	/// @brief Whether the range is read even while the circuit breaker of the I/O component is open
+	bool _essential { false };
+
+	/// @brief The names of the attributes. The attributes refer to these strings, so this must not be modified after publish().
+	std::vector<std::string> _attributeNames;
+	/// @brief The attributes of the points. Each point has kFieldCount consecutive attributes, in the order of the enumerators
+	/// of Field. The attributes are identified by their address, so this must not be modified after publish().
+	std::vector<model::Attribute> _attributes;
+};
+
+inline AbstractPointRange::~AbstractPointRange() = default;
+
+inline auto AbstractPointRange::name(std::size_t index) const -> std::string
+{
+	// Replace the placeholder with the index. The pattern was checked to contain the placeholder when it was loaded.
+	auto name = _layout._namePattern;
+	if (const auto placeholder = name.find("{}"sv); placeholder != std::string::npos)
+	{
+		name.replace(placeholder, 2, std::to_string(index));
+	}
+
+	return name;
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -1,6 +1,12 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "Arena.hpp"
+#include "History.hpp"
+#include "Session.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
+
 #include <xentara/data/DataType.hpp>
 #include <xentara/data/ReadHandle.hpp>
 #include <xentara/model/Attribute.hpp>
@@ -34,7 +40,8 @@ public:
 		virtual ~ErrorSink() = 0;
 
 		/// @brief Called when a read error occurs
-		virtual auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+		/// @param lease The lease on the session the error occurred on
+		virtual auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
 	};
 
 	/// @brief Virtual destructor
@@ -70,11 +77,41 @@ public:
 
 	/// @brief Realizes the handler
 	virtual auto realize() -> void = 0;
+
+	/// @brief Enables recording a history of the values read.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the history from
+	/// @param size The size of the history buffer, in bytes
+	/// @return true on success, or false if no history can be recorded for the data type
+	virtual auto enableHistory(Arena &arena, std::size_t size) -> bool = 0;
+	/// @brief Calls a function for each sample in the history that was recorded at or after a certain time
+	/// @param since The time stamp of the oldest sample of interest
+	/// @param function The function to call
+	/// @return true if the history was read, or false if no history is being recorded
+	virtual auto readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool = 0;
+
+	/// @brief Assigns the value a slot in the snapshot of the I/O component, so that the last known value survives a restart.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	virtual auto enableSnapshot(Snapshot &snapshot) -> void = 0;
+
+	/// @brief Enables detecting when the value has not been updated for too long.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the index entry from
+	/// @param index The staleness index of the I/O component
+	/// @param maxAge The maximum age of the value, or std::nullopt to use the default maximum age of the I/O component
+	virtual auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void = 0;
 		
 	/// @brief Attempts to read the data from the I/O component and updates the handler accordingly.
-	virtual auto read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;
+	/// @param lease A lease on the session to use
+	virtual auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;
 	/// @brief Updates the state without specifying a value
-	virtual auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+	/// @param timeStamp The update time stamp
+	/// @param error The error code
+	/// @param raiseEvents Whether to raise the *changed* event if anything changed
+	virtual auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void = 0;
 };
 
 inline AbstractTemplateInputHandler::~AbstractTemplateInputHandler() = default;
@@ -1,6 +1,12 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "Arena.hpp"
+#include "Session.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
+#include "Transport.hpp"
+
 #include <xentara/data/DataType.hpp>
 #include <xentara/data/ReadHandle.hpp>
 #include <xentara/data/WriteHandle.hpp>
@@ -35,9 +41,11 @@ public:
 		virtual ~ErrorSink() = 0;
 
 		/// @brief Called when a read error occurs
-		virtual auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+		/// @param lease The lease on the session the error occurred on
+		virtual auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
 		/// @brief Called when a write error occurs
-		virtual auto handleWriteError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+		/// @param lease The lease on the session the error occurred on
+		virtual auto handleWriteError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
 	};
 
 	/// @brief Virtual destructor
@@ -85,14 +93,60 @@ public:
 
 	/// @brief Realizes the handler
 	virtual auto realize() -> void = 0;
+
+	/// @brief Assigns the value read back from the device a slot in the snapshot of the I/O component, so that the last known
+	/// value survives a restart.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	virtual auto enableSnapshot(Snapshot &snapshot) -> void = 0;
+
+	/// @brief Enables detecting when the value read back from the device has not been updated for too long.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the index entry from
+	/// @param index The staleness index of the I/O component
+	/// @param maxAge The maximum age of the value, or std::nullopt to use the default maximum age of the I/O component
+	virtual auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void = 0;
+
+	/// @brief Enables skipping writes of values that are equal to the last value acknowledged by the device.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param rewriteInterval The time after which an unchanged value is written again anyway
+	/// @return true on success, or false if writes cannot be skipped for this kind of output
+	virtual auto enableWriteOnChange(std::chrono::milliseconds rewriteInterval) -> bool = 0;
 		
 	/// @brief Attempts to read the data from the I/O component and updates the handler accordingly.
-	virtual auto read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;
+	/// @param lease A lease on the session to use
+	virtual auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;
 	/// @brief Updates the read state without specifying a value
-	virtual auto updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
+	/// @param timeStamp The update time stamp
+	/// @param error The error code
+	/// @param raiseEvents Whether to raise the *changed* event if anything changed
+	virtual auto updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void = 0;
 
 	/// @brief Attempts to write any pending value to the I/O component and updates the state accordingly.
-	virtual auto write(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;	
+	/// @param lease A lease on the session to use
+	virtual auto write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void = 0;	
+	/// @brief Adds the request needed to write any pending value to a batch.
+	///
+	/// At most one request is added. If there is no pending value, no request is added.
+	/// @param lease A lease on the session the batch will be sent over
+	/// @param batch The batch
+	/// @param timeStamp The time stamp to use if the value is not written after all
+	/// @return true if the value is written as part of the batch, in which case finishWrite() or abortWrite() must be called once
+	/// the batch is done, or false if the handler cannot write values in batches, and write() must be used instead.
+	virtual auto queueWrite(const Session::Lease &lease, Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		ErrorSink &errorSink) -> bool = 0;
+	/// @brief Decodes the response to the request added by queueWrite(), if any, and updates the state accordingly.
+	/// @param lease A lease on the session the batch was sent over
+	/// @param batch The batch. This must have been submitted successfully.
+	virtual auto finishWrite(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		ErrorSink &errorSink) -> void = 0;
+	/// @brief Updates the state after the batch the request added by queueWrite() was in could not be submitted
+	/// @param lease A lease on the session the batch was to be sent over
+	/// @param error The error that occurred
+	virtual auto abortWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error,
+		ErrorSink &errorSink) -> void = 0;
 	/// @brief Updates the write state
 	virtual auto updateWriteState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void = 0;
 };
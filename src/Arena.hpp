@@ -0,0 +1,155 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A monotonic memory arena for objects that live as long as their I/O component.
+///
+/// The arena allocates objects back to back in large chunks, in the order in which they are created. This keeps the
+/// handlers of the data points of an I/O component close together in memory, and avoids the per-allocation overhead
+/// of the heap. Memory is never released individually. All objects are destroyed together, in reverse order of creation,
+/// when the arena is destroyed.
+///
+/// @note The arena is not thread-safe. Objects must only be created while the configuration is being loaded.
+class Arena final : private utils::tools::Unique
+{
+public:
+	/// @brief The default size of the first chunk
+	static constexpr std::size_t kDefaultInitialSize = 64 * 1024;
+
+	/// @brief Constructor
+	/// @param initialSize The size of the first chunk. Subsequent chunks grow geometrically.
+	explicit Arena(std::size_t initialSize = kDefaultInitialSize) : _memory(initialSize)
+	{
+	}
+
+	/// @brief Destructor. Destroys all objects in reverse order of creation
+	~Arena();
+
+	/// @brief Creates an object in the arena
+	/// @return A reference to the object. The object is owned by the arena.
+	template <typename Object, typename... Arguments>
+	auto make(Arguments &&...arguments) -> Object &;
+
+	/// @brief Creates a contiguous array of default constructed objects in the arena
+	/// @return A span referring to the objects. The objects are owned by the arena.
+	template <typename Object>
+	auto makeArray(std::size_t count) -> std::span<Object>;
+
+private:
+	/// @brief A record used to destroy objects when the arena is destroyed.
+	///
+	/// The records are allocated in the arena itself, and form a singly linked list in reverse order of creation.
+	struct Cleanup final
+	{
+		/// @brief The function used to destroy the objects
+		void (*_destroy)(void *objects, std::size_t count) noexcept;
+		/// @brief The first object to destroy
+		void *_objects;
+		/// @brief The number of objects
+		std::size_t _count;
+		/// @brief The record for the objects that were created before these ones
+		Cleanup *_next;
+	};
+
+	/// @brief Destroys an array of objects of a certain type
+	template <typename Object>
+	static auto destroy(void *objects, std::size_t count) noexcept -> void
+	{
+		std::destroy_n(static_cast<Object *>(objects), count);
+	}
+
+	/// @brief Allocates memory for the cleanup record of objects of a certain type
+	/// @return The memory for the record, or nullptr if the objects do not need destroying
+	template <typename Object>
+	auto allocateCleanup() -> void *;
+
+	/// @brief Registers objects for destruction
+	/// @param cleanup The memory returned by allocateCleanup(), or nullptr if the objects do not need destroying
+	template <typename Object>
+	auto registerCleanup(void *cleanup, Object *objects, std::size_t count) noexcept -> void;
+
+	/// @brief The memory resource the objects are allocated from
+	std::pmr::monotonic_buffer_resource _memory;
+
+	/// @brief The last cleanup record, or nullptr if there are no objects that need destroying
+	Cleanup *_cleanups { nullptr };
+};
+
+inline Arena::~Arena()
+{
+	// Destroy all the objects in reverse order of creation. The memory itself is released by the memory resource.
+	for (auto cleanup = _cleanups; cleanup; cleanup = cleanup->_next)
+	{
+		cleanup->_destroy(cleanup->_objects, cleanup->_count);
+	}
+}
+
+template <typename Object, typename... Arguments>
+auto Arena::make(Arguments &&...arguments) -> Object &
+{
+	// Allocate the cleanup record first, so that the object will never be left without one
+	auto cleanup = allocateCleanup<Object>();
+
+	// Allocate and construct the object
+	auto memory = _memory.allocate(sizeof(Object), alignof(Object));
+	auto object = ::new (memory) Object(std::forward<Arguments>(arguments)...);
+
+	// Register the object for destruction
+	registerCleanup(cleanup, object, 1);
+
+	return *object;
+}
+
+template <typename Object>
+auto Arena::makeArray(std::size_t count) -> std::span<Object>
+{
+	// Allocate the cleanup record first, so that the objects will never be left without one
+	auto cleanup = allocateCleanup<Object>();
+
+	// Allocate and construct the objects
+	auto memory = _memory.allocate(sizeof(Object) * count, alignof(Object));
+	auto objects = static_cast<Object *>(memory);
+	std::uninitialized_value_construct_n(objects, count);
+
+	// Register the objects for destruction
+	registerCleanup(cleanup, objects, count);
+
+	return { objects, count };
+}
+
+template <typename Object>
+auto Arena::allocateCleanup() -> void *
+{
+	// Trivially destructible objects need no cleanup
+	if constexpr (std::is_trivially_destructible_v<Object>)
+	{
+		return nullptr;
+	}
+	else
+	{
+		return _memory.allocate(sizeof(Cleanup), alignof(Cleanup));
+	}
+}
+
+template <typename Object>
+auto Arena::registerCleanup(void *cleanup, Object *objects, std::size_t count) noexcept -> void
+{
+	if (cleanup)
+	{
+		_cleanups = ::new (cleanup) Cleanup { &destroy<Object>, objects, count, _cleanups };
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
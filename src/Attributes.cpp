@@ -15,10 +15,25 @@ const model::Attribute kError { model::Attribute::kError, model::Attribute::Acce
 
 const model::Attribute kWriteError { model::Attribute::kWriteError, model::Attribute::Access::ReadOnly, data::DataType::kErrorCode };
 
+/// @todo assign a unique UUID
+const model::Attribute kWriteLatency { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "writeLatency"sv, model::Attribute::Access::ReadOnly, data::DataType::kFloatingPoint };
+
+/// @todo assign a unique UUID
+const model::Attribute kMaxWriteLatency { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "maxWriteLatency"sv, model::Attribute::Access::ReadOnly, data::DataType::kFloatingPoint };
+
 /// @todo assign a unique UUID
 const model::Attribute kConnectionTime { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "connectionTime"sv, model::Attribute::Access::ReadOnly, data::DataType::kTimeStamp };
 
 /// @todo assign a unique UUID
 const model::Attribute kDeviceError { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "error"sv, model::Attribute::Access::ReadOnly, data::DataType::kErrorCode };
 
+/// @todo assign a unique UUID
+const model::Attribute kIoJitter { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "ioJitter"sv, model::Attribute::Access::ReadOnly, data::DataType::kFloatingPoint };
+
+/// @todo assign a unique UUID
+const model::Attribute kCircuitOpen { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "circuitOpen"sv, model::Attribute::Access::ReadOnly, data::DataType::kBoolean };
+
+/// @todo assign a unique UUID
+const model::Attribute kDumpTrace { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "dumpTrace"sv, model::Attribute::Access::WriteOnly, data::DataType::kBoolean };
+
 } // namespace xentara::plugins::templateDriver::attributes
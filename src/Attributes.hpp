@@ -12,10 +12,21 @@ namespace xentara::plugins::templateDriver::attributes
 extern const model::Attribute kError;
 /// @brief A Xentara attribute containing a write error code for a data point
 extern const model::Attribute kWriteError;
+/// @brief A Xentara attribute containing the latency of the last write of a data point, in seconds
+extern const model::Attribute kWriteLatency;
+/// @brief A Xentara attribute containing the highest latency of any write of a data point so far, in seconds
+extern const model::Attribute kMaxWriteLatency;
 
 /// @brief A Xentara attribute containing the connection time for an I/O component
 extern const model::Attribute kConnectionTime;
 /// @brief A Xentara attribute containing an error code for an I/O component
 extern const model::Attribute kDeviceError;
+/// @brief A Xentara attribute containing the jitter of the delay between the start of a read cycle of an I/O component and the
+/// sending of its first request, in seconds
+extern const model::Attribute kIoJitter;
+/// @brief A Xentara attribute that is true while the circuit breaker of an I/O component is open
+extern const model::Attribute kCircuitOpen;
+/// @brief A Xentara attribute that writes the recorded trace of the driver to the trace file of an I/O component when set to true
+extern const model::Attribute kDumpTrace;
 
 } // namespace xentara::plugins::templateDriver::attributes
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief The address of a single bit within a word on the device
+/// @todo change the address format to the one used by the device
+struct BitAddress final
+{
+	/// @brief The address of the word
+	std::uint64_t _word { 0 };
+	/// @brief The index of the bit within the word, starting with the least significant bit at 0
+	std::size_t _bit { 0 };
+
+	/// @brief Parses an address of the form "word.bit"
+	/// @param text The text to parse
+	/// @return The address, or std::nullopt if the text is malformed
+	static auto parse(std::string_view text) noexcept -> std::optional<BitAddress>
+	{
+		BitAddress address;
+		const auto end = text.data() + text.size();
+
+		// Parse the word address
+		const auto [wordEnd, wordError] = std::from_chars(text.data(), end, address._word);
+		if (wordError != std::errc() || wordEnd == end || *wordEnd != '.')
+		{
+			return std::nullopt;
+		}
+
+		// Parse the bit index, which must make up the rest of the text
+		const auto [bitEnd, bitError] = std::from_chars(wordEnd + 1, end, address._bit);
+		if (bitError != std::errc() || bitEnd != end)
+		{
+			return std::nullopt;
+		}
+
+		return address;
+	}
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
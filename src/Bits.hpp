@@ -0,0 +1,53 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__BMI2__)
+#	include <immintrin.h>
+#endif
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Gathers the bits of a word selected by a mask into the low bits of the result.
+///
+/// This is the operation performed by the x86 *pext* instruction, which is used if the target supports it. The lowest bit
+/// selected by the mask ends up in bit 0 of the result, the next one in bit 1, and so on.
+/// @param word The word to extract the bits from
+/// @param mask The bits to extract
+template <std::unsigned_integral Word>
+constexpr auto extractBits(Word word, Word mask) noexcept -> Word
+{
+#if defined(__BMI2__)
+	if (!std::is_constant_evaluated())
+	{
+		if constexpr (sizeof(Word) <= sizeof(std::uint32_t))
+		{
+			return Word(_pext_u32(word, mask));
+		}
+		else
+		{
+			return Word(_pext_u64(word, mask));
+		}
+	}
+#endif
+
+	// Walk the set bits of the mask from the lowest to the highest
+	Word result = 0;
+	for (Word bit = 1; mask != 0; bit <<= 1)
+	{
+		// Isolate the lowest bit of the mask
+		const Word lowest = mask & Word(-mask);
+		if (word & lowest)
+		{
+			result |= bit;
+		}
+		mask ^= lowest;
+	}
+	return result;
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,156 @@
+// Copyright (c) embedded ocean GmbH
+#include "CircuitBreaker.hpp"
+
+#include <algorithm>
+
+namespace xentara::plugins::templateDriver
+{
+
+auto CircuitBreaker::enable(const Options &options, StateFunction function) -> void
+{
+	_options = options;
+	_bucketDuration = std::max<Clock::duration>(std::chrono::duration_cast<Clock::duration>(options._window) / kBucketCount, Clock::duration(1));
+	_stateFunction = std::move(function);
+	_enabled = true;
+}
+
+auto CircuitBreaker::admitEnabled(bool essential) noexcept -> Admission
+{
+	std::scoped_lock lock { _mutex };
+
+	switch (_state.load(std::memory_order_relaxed))
+	{
+	case State::Closed:
+		++currentBucket()._reads;
+		return Admission::Admitted;
+
+	case State::Open:
+		// Let a single non-essential read through as a probe once the probe interval has elapsed
+		if (!essential && _probeDeadline.passed())
+		{
+			transition(State::HalfOpen);
+			++currentBucket()._reads;
+			return Admission::Probe;
+		}
+		[[fallthrough]];
+
+	case State::HalfOpen:
+	default:
+		if (essential)
+		{
+			++currentBucket()._reads;
+			return Admission::Admitted;
+		}
+		return Admission::Rejected;
+	}
+}
+
+auto CircuitBreaker::recordError() noexcept -> void
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	std::scoped_lock lock { _mutex };
+
+	auto &current = currentBucket();
+	++current._errors;
+
+	switch (_state.load(std::memory_order_relaxed))
+	{
+	case State::Closed:
+		{
+			// Sum up the counts of the buckets that are still within the window
+			std::size_t reads = 0;
+			std::size_t errors = 0;
+			for (auto &&bucket : _buckets)
+			{
+				if (current._epoch - bucket._epoch < kBucketCount)
+				{
+					reads += bucket._reads;
+					errors += bucket._errors;
+				}
+			}
+
+			if (reads >= _options._minimumReads && double(errors) >= _options._errorRate * double(reads))
+			{
+				open();
+			}
+		}
+		break;
+
+	// The device is still failing, so wait for another probe interval
+	case State::HalfOpen:
+		open();
+		break;
+
+	case State::Open:
+	default:
+		break;
+	}
+}
+
+auto CircuitBreaker::finishProbe(bool completed) noexcept -> void
+{
+	std::scoped_lock lock { _mutex };
+
+	// If an error was recorded since the probe was admitted, the breaker has already been opened again
+	if (_state.load(std::memory_order_relaxed) != State::HalfOpen)
+	{
+		return;
+	}
+
+	// A probe that was never read tells us nothing, so try again after another probe interval
+	if (!completed)
+	{
+		open();
+		return;
+	}
+
+	// Start over with an empty window, so that the errors that opened the breaker don't open it again right away
+	_buckets = {};
+	transition(State::Closed);
+}
+
+auto CircuitBreaker::currentBucket() noexcept -> Bucket &
+{
+	const auto epoch = std::uint64_t(Clock::now().time_since_epoch() / _bucketDuration);
+	auto &bucket = _buckets[epoch % kBucketCount];
+	if (bucket._epoch != epoch)
+	{
+		bucket = { epoch, 0, 0 };
+	}
+	return bucket;
+}
+
+auto CircuitBreaker::open() noexcept -> void
+{
+	try
+	{
+		_probeDeadline.arm(TimingWheel::shared(), _options._probeInterval);
+	}
+	catch (...)
+	{
+		// If the deadline could not be armed, it counts as passed, so the next read will be a probe
+	}
+	transition(State::Open);
+}
+
+auto CircuitBreaker::transition(State state) noexcept -> void
+{
+	_state.store(state, std::memory_order_relaxed);
+	if (_stateFunction)
+	{
+		try
+		{
+			_stateFunction(state);
+		}
+		catch (...)
+		{
+			// The state has changed regardless
+		}
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
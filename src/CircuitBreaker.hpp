@@ -0,0 +1,171 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "TimingWheel.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief A circuit breaker that stops non-essential reads while a device is responding with too many errors.
+///
+/// The breaker counts the reads and read errors over a sliding window. While the breaker is *closed*, all reads are performed.
+/// If the error rate exceeds a threshold, the breaker *opens*, and only essential reads are performed, so that an overloaded
+/// device is given a chance to recover. Once per probe interval, a single non-essential read is let through as a *probe*
+/// (the breaker is *half open* while the probe is in progress). If the probe succeeds, the breaker closes again, otherwise it
+/// stays open for another probe interval.
+///
+/// The breaker is disabled by default, in which case all reads are performed without any bookkeeping.
+class CircuitBreaker final : private utils::tools::Unique
+{
+public:
+	/// @brief The clock used for the window
+	using Clock = TimingWheel::Clock;
+
+	/// @brief The state of the breaker
+	enum class State
+	{
+		/// @brief All reads are performed
+		Closed,
+		/// @brief Only essential reads are performed
+		Open,
+		/// @brief Only essential reads are performed, and a probe is in progress
+		HalfOpen
+	};
+
+	/// @brief The result of asking the breaker whether a read may be performed
+	enum class Admission
+	{
+		/// @brief The read must be skipped
+		Rejected,
+		/// @brief The read may be performed
+		Admitted,
+		/// @brief The read may be performed as a probe. The caller must call finishProbe() once the read is done.
+		Probe
+	};
+
+	/// @brief The configuration of the breaker
+	struct Options final
+	{
+		/// @brief The fraction of reads that must fail within the window for the breaker to open
+		double _errorRate { 0.5 };
+		/// @brief The number of reads that must have been performed within the window before the breaker can open
+		std::size_t _minimumReads { 20 };
+		/// @brief The length of the sliding window
+		std::chrono::milliseconds _window { 10s };
+		/// @brief The time between probes while the breaker is open
+		std::chrono::milliseconds _probeInterval { 5s };
+	};
+
+	/// @brief A function that is called whenever the state of the breaker changes.
+	///
+	/// The function is called with the internal lock held, so the calls are always made in the order of the transitions.
+	using StateFunction = std::function<void(State state)>;
+
+	/// @brief Enables the breaker.
+	///
+	/// This must be called before any reads are performed.
+	/// @param options The configuration
+	/// @param function The function to call when the state changes
+	auto enable(const Options &options, StateFunction function) -> void;
+
+	/// @brief Checks whether the breaker is enabled
+	auto enabled() const noexcept -> bool
+	{
+		return _enabled;
+	}
+
+	/// @brief Returns the current state
+	auto state() const noexcept -> State
+	{
+		return _state.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Asks whether a read may be performed, and counts it if it may.
+	/// @param essential Whether the read is essential. Essential reads are always admitted.
+	auto admit(bool essential) noexcept -> Admission
+	{
+		// Don't do any bookkeeping if the breaker is disabled
+		if (!_enabled)
+		{
+			return Admission::Admitted;
+		}
+
+		return admitEnabled(essential);
+	}
+
+	/// @brief Counts a read error. This may open the breaker.
+	auto recordError() noexcept -> void;
+
+	/// @brief Finishes a probe admitted using admit().
+	/// @param completed Whether the probe was actually read. If an error was recorded in the meantime, the breaker will already
+	/// have been opened again, and the probe does not close it, even if it was read.
+	auto finishProbe(bool completed) noexcept -> void;
+
+private:
+	/// @brief The number of buckets the window is divided into
+	static constexpr std::size_t kBucketCount = 10;
+
+	/// @brief The counts for a part of the window
+	struct Bucket final
+	{
+		/// @brief The index of the part of the window, counted in bucket durations since the epoch of the clock
+		std::uint64_t _epoch { 0 };
+		/// @brief The number of reads admitted
+		std::size_t _reads { 0 };
+		/// @brief The number of errors
+		std::size_t _errors { 0 };
+	};
+
+	/// @brief Implementation of admit() for an enabled breaker
+	auto admitEnabled(bool essential) noexcept -> Admission;
+
+	/// @brief Returns the bucket for the current time, resetting it if it contains the counts of an older part of the window.
+	///
+	/// The caller must hold _mutex.
+	auto currentBucket() noexcept -> Bucket &;
+
+	/// @brief Opens the breaker, and schedules the next probe.
+	///
+	/// The caller must hold _mutex.
+	auto open() noexcept -> void;
+
+	/// @brief Changes the state, and calls the state function.
+	///
+	/// The caller must hold _mutex.
+	auto transition(State state) noexcept -> void;
+
+	/// @brief Whether the breaker is enabled
+	bool _enabled { false };
+	/// @brief The configuration
+	Options _options;
+	/// @brief The length of the part of the window covered by a bucket
+	Clock::duration _bucketDuration { 1s };
+	/// @brief The function to call when the state changes
+	StateFunction _stateFunction;
+
+	/// @brief The current state.
+	///
+	/// This may only be modified while holding _mutex, but can be read at any time.
+	std::atomic<State> _state { State::Closed };
+	/// @brief The buckets, used as a ring indexed by the epoch. This must only be accessed while holding _mutex.
+	std::array<Bucket, kBucketCount> _buckets {};
+	/// @brief The deadline for the next probe while the breaker is open
+	TimingWheel::Deadline _probeDeadline;
+
+	/// @brief A mutex protecting the buckets and the transitions
+	std::mutex _mutex;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
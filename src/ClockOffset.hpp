@@ -0,0 +1,80 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A continuous estimate of the offset between the clock of a device and the clock of the host.
+///
+/// Each sample pairs a time reported by the device with the time the host received it. The difference between the two is
+/// the clock offset plus the transmission delay. Since the delay can only ever make the difference larger, the estimate
+/// follows smaller samples immediately, and larger samples only slowly. This filters out delay jitter, while still tracking
+/// any drift between the two clocks.
+///
+/// The estimator is lock-free, and samples can be added from any thread.
+class ClockOffset final
+{
+public:
+	/// @brief The clock used for both time stamps
+	using Clock = std::chrono::system_clock;
+
+	/// @brief The fraction of the difference by which the estimate follows a sample that is larger than the estimate,
+	/// as a power of two.
+	static constexpr int kDriftShift = 6;
+
+	/// @brief Adds a sample
+	/// @param deviceTime The time reported by the device
+	/// @param hostTime The time the host received the report
+	auto addSample(Clock::time_point deviceTime, Clock::time_point hostTime) noexcept -> void;
+
+	/// @brief Checks whether an estimate is available
+	auto valid() const noexcept -> bool
+	{
+		return _offset.load(std::memory_order_relaxed) != kInvalid;
+	}
+
+	/// @brief Returns the estimated offset of the host clock relative to the device clock
+	/// @return The offset, or zero if no samples have been added yet
+	auto offset() const noexcept -> Clock::duration
+	{
+		const auto offset = _offset.load(std::memory_order_relaxed);
+		return Clock::duration(offset != kInvalid ? offset : 0);
+	}
+
+	/// @brief Converts a time reported by the device to host time
+	auto toHostTime(Clock::time_point deviceTime) const noexcept -> Clock::time_point
+	{
+		return deviceTime + offset();
+	}
+
+private:
+	/// @brief The value of _offset that marks the estimate as invalid
+	static constexpr Clock::rep kInvalid = std::numeric_limits<Clock::rep>::min();
+
+	/// @brief The estimated offset, in clock ticks, or kInvalid if no sample was added yet
+	std::atomic<Clock::rep> _offset { kInvalid };
+};
+
+inline auto ClockOffset::addSample(Clock::time_point deviceTime, Clock::time_point hostTime) noexcept -> void
+{
+	const auto sample = (hostTime - deviceTime).count();
+
+	auto current = _offset.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		// Use the first sample as is. After that, take smaller samples immediately, because they contain less delay,
+		// and only move slowly towards larger ones, to follow drift without picking up jitter.
+		const auto next = (current == kInvalid || sample <= current) ? sample : current + ((sample - current) >> kDriftShift);
+		if (next == current || _offset.compare_exchange_weak(current, next, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
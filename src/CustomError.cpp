@@ -47,6 +47,15 @@ namespace
 		case CustomError::NoData:
 			return "no data was read yet"s;
 
+		case CustomError::Timeout:
+			return "the device did not respond in time"s;
+
+		case CustomError::LastKnownValue:
+			return "the value is the last known value from before a restart"s;
+
+		case CustomError::Stale:
+			return "the value has not been updated for longer than its maximum age"s;
+
 		/// @todo Add messages for other error codes
 
 		case CustomError::UnknownError:
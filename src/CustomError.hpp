@@ -19,6 +19,12 @@ enum class CustomError
 	NotConnected,
 	/// @brief No data has been read yet.
 	NoData,
+	/// @brief The device did not respond in time.
+	Timeout,
+	/// @brief The value was restored from before a restart, and has not been read since.
+	LastKnownValue,
+	/// @brief The value has not been read successfully for longer than its maximum age.
+	Stale,
 
 	/// @brief An unknown error occurred
 	UnknownError = 999
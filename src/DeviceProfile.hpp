@@ -0,0 +1,170 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "PointState.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief The byte order of a register
+enum class ByteOrder
+{
+	/// @brief The most significant byte comes first
+	BigEndian,
+	/// @brief The least significant byte comes first
+	LittleEndian
+};
+
+/// @brief A register in the register map of a device profile.
+///
+/// The type, offset, and byte order of the register are template parameters, so that the decoder can be fully inlined
+/// with all offsets known at compile time.
+/// @tparam ValueType The data type of the register
+/// @tparam kOffset The offset of the register within the block read from the device, in bytes
+/// @tparam kByteOrder The byte order of the register
+template <typename ValueType, std::size_t kOffset, ByteOrder kByteOrder = ByteOrder::BigEndian>
+	requires std::integral<ValueType> || std::floating_point<ValueType>
+struct Register final
+{
+	/// @brief The data type of the register
+	using Value = ValueType;
+
+	/// @brief The offset of the byte after the register
+	static constexpr std::size_t kEnd = kOffset + sizeof(ValueType);
+
+	/// @brief Decodes the register from a block read from the device
+	/// @param block The block. This must be at least kEnd bytes long.
+	static auto decode(const std::byte *block) noexcept -> ValueType
+	{
+		if constexpr (std::is_same_v<ValueType, bool>)
+		{
+			return block[kOffset] != std::byte(0);
+		}
+		else
+		{
+			// Load the raw bits as an unsigned integer of the same size, so they can be byte swapped
+			using Bits = decltype(unsignedOfSize<sizeof(ValueType)>());
+			Bits bits;
+			std::memcpy(&bits, block + kOffset, sizeof(Bits));
+			if constexpr (sizeof(Bits) > 1 && (kByteOrder == ByteOrder::BigEndian) != (std::endian::native == std::endian::big))
+			{
+				bits = byteSwap(bits);
+			}
+
+			return std::bit_cast<ValueType>(bits);
+		}
+	}
+
+	/// @brief The name of the register. This is used to generate the name of the point.
+	std::string_view _name;
+
+private:
+	/// @brief Returns an unsigned integer with a certain size. This is only used to determine the type.
+	template <std::size_t kSize>
+	static constexpr auto unsignedOfSize() noexcept
+	{
+		if constexpr (kSize == 1)
+		{
+			return std::uint8_t();
+		}
+		else if constexpr (kSize == 2)
+		{
+			return std::uint16_t();
+		}
+		else if constexpr (kSize == 4)
+		{
+			return std::uint32_t();
+		}
+		else
+		{
+			static_assert(kSize == 8, "unsupported register size");
+			return std::uint64_t();
+		}
+	}
+
+	/// @brief Reverses the bytes of an unsigned integer. Compilers turn this into a single instruction.
+	template <std::unsigned_integral Bits>
+	static constexpr auto byteSwap(Bits bits) noexcept -> Bits
+	{
+		Bits result = 0;
+		for (std::size_t index = 0; index < sizeof(Bits); ++index)
+		{
+			result = Bits((result << 8) | ((bits >> (index * 8)) & 0xff));
+		}
+		return result;
+	}
+};
+
+/// @brief The register map of a fixed device family, described as a compile-time table.
+///
+/// Device profiles are used as template arguments of ProfileRange, which reads all the registers as a single block
+/// and decodes them using a fully inlined decoder.
+/// @tparam Registers The registers, as instances of Register
+template <typename... Registers>
+class DeviceProfile final
+{
+public:
+	/// @brief The number of registers
+	static constexpr std::size_t kRegisterCount = sizeof...(Registers);
+	/// @brief The size of the block containing all the registers, in bytes
+	static constexpr std::size_t kBlockSize = std::max({ std::size_t(0), Registers::kEnd... });
+
+	/// @brief The type of a tuple containing the value of each register
+	using Values = std::tuple<typename Registers::Value...>;
+	/// @brief The type of the data block containing the states of all the registers
+	using States = PointStates<typename Registers::Value...>;
+	/// @brief The type of the state of a single register within States
+	template <std::size_t kIndex>
+	using State = PointStateAt<kIndex, typename Registers::Value...>;
+
+	/// @brief Constructor
+	/// @param name The name used to select the profile in the configuration
+	/// @param registers The registers
+	constexpr DeviceProfile(std::string_view name, Registers... registers) noexcept : _name(name), _registers(registers...)
+	{
+	}
+
+	/// @brief Returns the name of the profile
+	constexpr auto name() const noexcept -> std::string_view
+	{
+		return _name;
+	}
+
+	/// @brief Returns the names of all the registers
+	constexpr auto registerNames() const noexcept -> std::array<std::string_view, kRegisterCount>
+	{
+		return std::apply([](const auto &...registers) { return std::array<std::string_view, kRegisterCount> { registers._name... }; },
+			_registers);
+	}
+
+	/// @brief Decodes all the registers from a block read from the device
+	/// @param block The block. This must be at least kBlockSize bytes long.
+	/// @param function A function that is called with the index of each register as an std::integral_constant, and its value
+	template <typename Function>
+	static auto decode(const std::byte *block, Function &&function) -> void
+	{
+		[&]<std::size_t... kIndices>(std::index_sequence<kIndices...>) {
+			(function(std::integral_constant<std::size_t, kIndices>(), Registers::decode(block)), ...);
+		}(std::index_sequence_for<Registers...>());
+	}
+
+private:
+	/// @brief The name of the profile
+	std::string_view _name;
+	/// @brief The registers
+	std::tuple<Registers...> _registers;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
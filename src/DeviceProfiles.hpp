@@ -0,0 +1,29 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "DeviceProfile.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief An example profile for a power meter.
+///
+/// The registers are read as a single block starting at the base address of the range.
+/// @todo replace this with the register maps of the device families supported by the driver
+inline constexpr DeviceProfile kExamplePowerMeter {
+	"examplePowerMeter"sv,
+	Register<std::uint16_t, 0> { "status"sv },
+	Register<float, 2> { "voltage"sv },
+	Register<float, 6> { "current"sv },
+	Register<float, 10> { "activePower"sv },
+	Register<std::uint32_t, 14> { "energy"sv },
+	Register<std::int16_t, 18, ByteOrder::LittleEndian> { "temperature"sv },
+	Register<bool, 20> { "alarm"sv }
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,143 @@
+// Copyright (c) embedded ocean GmbH
+#ifndef _WIN32
+
+#include "EpollTransport.hpp"
+
+#include "CustomError.hpp"
+#include "Trace.hpp"
+
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace xentara::plugins::templateDriver
+{
+
+EpollTransport::EpollTransport(int socket) : _socket(socket)
+{
+	// Switch the socket to non-blocking mode
+	const auto flags = ::fcntl(_socket, F_GETFL);
+	if (flags < 0 || ::fcntl(_socket, F_SETFL, flags | O_NONBLOCK) < 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not switch socket to non-blocking mode");
+	}
+
+	// Create the epoll instance
+	_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll < 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not create epoll instance");
+	}
+
+	// Register the socket. We modify the events we are interested in as needed.
+	::epoll_event event { .events = 0, .data = { .fd = _socket } };
+	if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, _socket, &event) < 0)
+	{
+		const auto error = errno;
+		::close(_epoll);
+		throw std::system_error(error, std::system_category(), "could not register socket with epoll");
+	}
+}
+
+EpollTransport::~EpollTransport()
+{
+	::close(_epoll);
+}
+
+auto EpollTransport::exchange(std::span<const Exchange> exchanges) -> void
+{
+	const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+
+	// Send all the requests first, so that the device can process them back to back
+	{
+		Trace::Span span { "send", "io" };
+		for (std::size_t index = 0; index < exchanges.size(); ++index)
+		{
+			const auto request = requestBuffer(index).first(exchanges[index]._requestSize);
+			for (std::size_t sent = 0; sent < request.size();)
+			{
+				const auto result = ::send(_socket, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+				if (result >= 0)
+				{
+					sent += std::size_t(result);
+				}
+				else if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					waitFor(EPOLLOUT, deadline);
+				}
+				else if (errno != EINTR)
+				{
+					throw std::system_error(errno, std::system_category(), "could not send request");
+				}
+			}
+		}
+	}
+
+	// Receive the responses directly into the response buffers. Stream sockets deliver them in the order the requests were sent.
+	{
+		Trace::Span span { "receive", "io" };
+		for (std::size_t index = 0; index < exchanges.size(); ++index)
+		{
+			const auto response = responseBuffer(index).first(exchanges[index]._responseSize);
+			for (std::size_t received = 0; received < response.size();)
+			{
+				const auto result = ::recv(_socket, response.data() + received, response.size() - received, 0);
+				if (result > 0)
+				{
+					received += std::size_t(result);
+				}
+				else if (result == 0)
+				{
+					throw std::system_error(ECONNRESET, std::system_category(), "connection closed by device");
+				}
+				else if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					waitFor(EPOLLIN, deadline);
+				}
+				else if (errno != EINTR)
+				{
+					throw std::system_error(errno, std::system_category(), "could not receive response");
+				}
+			}
+		}
+	}
+}
+
+auto EpollTransport::waitFor(std::uint32_t events, std::chrono::steady_clock::time_point deadline) -> void
+{
+	// Select the events we are waiting for
+	::epoll_event event { .events = events, .data = { .fd = _socket } };
+	if (::epoll_ctl(_epoll, EPOLL_CTL_MOD, _socket, &event) < 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not modify epoll events");
+	}
+
+	for (;;)
+	{
+		// Calculate the remaining time, rounding up so that we never wait for zero milliseconds before the deadline
+		const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+		if (remaining <= std::chrono::milliseconds::zero())
+		{
+			throw std::system_error(CustomError::Timeout, "timeout waiting for device");
+		}
+
+		::epoll_event ready;
+		const auto result = ::epoll_wait(_epoll, &ready, 1, int(remaining.count()));
+		if (result > 0)
+		{
+			return;
+		}
+		else if (result < 0 && errno != EINTR)
+		{
+			throw std::system_error(errno, std::system_category(), "could not wait for socket");
+		}
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
+
+#endif // _WIN32
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#ifndef _WIN32
+
+#include "Transport.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A transport that uses non-blocking socket calls and epoll.
+///
+/// This is the fallback for kernels that do not support io_uring. All the requests of a batch are sent before any of the
+/// responses are received, so the device can process them back to back, but each send and receive is a separate system call.
+class EpollTransport final : public Transport
+{
+public:
+	/// @brief Constructor
+	/// @param socket A connected stream socket. The socket is switched to non-blocking mode.
+	/// @throw std::system_error if the epoll instance could not be created
+	explicit EpollTransport(int socket);
+
+	/// @brief Destructor
+	~EpollTransport();
+
+protected:
+	/// @name Virtual Overrides for Transport
+	/// @{
+
+	auto exchange(std::span<const Exchange> exchanges) -> void final;
+
+	/// @}
+
+private:
+	/// @brief Waits until the socket is ready for an operation
+	/// @param events The epoll events to wait for
+	/// @param deadline The time at which to give up
+	auto waitFor(std::uint32_t events, std::chrono::steady_clock::time_point deadline) -> void;
+
+	/// @brief The socket
+	int _socket;
+	/// @brief The epoll instance
+	int _epoll { -1 };
+};
+
+} // namespace xentara::plugins::templateDriver
+
+#endif // _WIN32
\ No newline at end of file
@@ -17,4 +17,10 @@ const process::Event::Role kRead { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid,
 /// @todo assign a unique UUID
 const process::Event::Role kWritten { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "written"sv };
 
+/// @todo assign a unique UUID
+const process::Event::Role kCircuitOpened { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "circuitOpened"sv };
+
+/// @todo assign a unique UUID
+const process::Event::Role kCircuitClosed { "deadbeef-dead-beef-dead-beefdeadbeef"_uuid, "circuitClosed"sv };
+
 } // namespace xentara::plugins::templateDriver::events
\ No newline at end of file
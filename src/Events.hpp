@@ -12,4 +12,9 @@ extern const process::Event::Role kRead;
 /// @brief A Xentara event that is raised when a data point was written
 extern const process::Event::Role kWritten;
 
+/// @brief A Xentara event that is raised when the circuit breaker of an I/O component opens
+extern const process::Event::Role kCircuitOpened;
+/// @brief A Xentara event that is raised when the circuit breaker of an I/O component closes again
+extern const process::Event::Role kCircuitClosed;
+
 } // namespace xentara::plugins::templateDriver::events
\ No newline at end of file
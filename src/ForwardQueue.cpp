@@ -0,0 +1,204 @@
+// Copyright (c) embedded ocean GmbH
+#include "ForwardQueue.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+namespace
+{
+
+	/// @brief Identifies the file format. This must be changed whenever the layout of the file changes.
+	constexpr std::uint64_t kMagic = 0x3130'5146'4452'5458; // "XTRDFQ01" in little endian
+
+	/// @brief The FNV-1a prime used to compute the fingerprint of the entries
+	constexpr std::uint64_t kFingerprintPrime = 0x100000001b3;
+
+} // namespace
+
+auto ForwardQueue::parseOverflowPolicy(std::string_view keyword) noexcept -> std::optional<OverflowPolicy>
+{
+	if (keyword == "dropOldest"sv)
+	{
+		return OverflowPolicy::DropOldest;
+	}
+	else if (keyword == "dropNewest"sv)
+	{
+		return OverflowPolicy::DropNewest;
+	}
+
+	return std::nullopt;
+}
+
+auto ForwardQueue::attach(Entry &entry, std::uint32_t type) -> std::uint32_t
+{
+	const auto index = std::uint32_t(_entries.size());
+	_entries.push_back(entry);
+
+	// Include the type of the entry in the fingerprint
+	_layout = (_layout ^ type) * kFingerprintPrime;
+
+	return index;
+}
+
+auto ForwardQueue::open(const std::filesystem::path &path, std::size_t capacity, OverflowPolicy overflowPolicy) -> void
+{
+	_overflowPolicy = overflowPolicy;
+
+	// Round the capacity up to a whole number of record headers
+	capacity = (capacity + sizeof(RecordHeader) - 1) / sizeof(RecordHeader) * sizeof(RecordHeader);
+
+	_file.open(path, sizeof(Header) + capacity);
+	_header = reinterpret_cast<Header *>(_file.bytes().data());
+	_ring = _file.bytes().subspan(sizeof(Header));
+
+	// Keep the records of the previous run only if the file was written with the same configuration, and the positions make sense.
+	// Otherwise, we have no way of knowing which outputs the records belong to.
+	auto &header = *_header;
+	const auto valid = header._magic == kMagic &&
+		header._layout == _layout &&
+		header._capacity == capacity &&
+		header._head <= header._tail &&
+		header._tail - header._head <= capacity &&
+		header._head % sizeof(RecordHeader) == 0 &&
+		header._tail % sizeof(RecordHeader) == 0;
+	if (!valid)
+	{
+		header = { kMagic, _layout, capacity, 0, 0, 0 };
+	}
+
+	// The component is not up yet, so start holding
+	_holding.store(true, std::memory_order_relaxed);
+}
+
+auto ForwardQueue::hold() noexcept -> void
+{
+	std::scoped_lock lock { _mutex };
+
+	// Only hold values if there is a file to hold them in
+	if (_header)
+	{
+		_holding.store(true, std::memory_order_relaxed);
+	}
+}
+
+auto ForwardQueue::tryPush(std::uint32_t entry, std::span<const std::byte> record) noexcept -> bool
+{
+	std::scoped_lock lock { _mutex };
+
+	// Check again under the lock, because the queue might have been emptied in the meantime
+	if (!_holding.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	auto &header = *_header;
+	const auto footprint = ForwardQueue::footprint(record.size());
+
+	// Make room for the record
+	if (footprint > _ring.size())
+	{
+		++header._dropped;
+		return true;
+	}
+	while (_ring.size() - (header._tail - header._head) < footprint)
+	{
+		if (_overflowPolicy == OverflowPolicy::DropNewest)
+		{
+			++header._dropped;
+			return true;
+		}
+
+		header._head += ForwardQueue::footprint(recordHeader(header._head)._size);
+		++header._dropped;
+	}
+
+	// Write the record before publishing it by moving the tail, so that a record is never seen half-written after a restart
+	const RecordHeader recordHeader { std::uint32_t(record.size()), entry };
+	copyIn(header._tail, std::as_bytes(std::span(&recordHeader, 1)));
+	copyIn(header._tail + sizeof(RecordHeader), record);
+	header._tail += footprint;
+
+	return true;
+}
+
+auto ForwardQueue::replay(const ReplayFunction &function) -> bool
+{
+	// Only one thread may replay at a time, so the records are not written twice
+	std::unique_lock replayLock { _replayMutex, std::try_to_lock };
+	if (!replayLock)
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		// Copy the oldest record out of the ring, so that values can be appended while it is being written
+		std::unique_lock lock { _mutex };
+		if (!_header)
+		{
+			return true;
+		}
+		auto &header = *_header;
+		if (header._head == header._tail)
+		{
+			// The queue has run empty, so values can be written directly again. This is done under the lock, so no
+			// value can be appended after we checked.
+			_holding.store(false, std::memory_order_relaxed);
+			return true;
+		}
+		const auto position = header._head;
+		const auto recordHeader = this->recordHeader(position);
+		_replayBuffer.resize(recordHeader._size);
+		copyOut(position + sizeof(RecordHeader), _replayBuffer);
+		lock.unlock();
+
+		// Write the value. Records of unknown entries can only come from a corrupted file, and are skipped.
+		if (recordHeader._entry < _entries.size() && !function(_entries[recordHeader._entry], _replayBuffer))
+		{
+			return false;
+		}
+
+		// Remove the record, unless it was discarded due to overflow while it was being written
+		lock.lock();
+		if (header._head == position)
+		{
+			header._head += footprint(recordHeader._size);
+		}
+	}
+}
+
+auto ForwardQueue::dropped() const noexcept -> std::uint64_t
+{
+	std::scoped_lock lock { _mutex };
+	return _header ? _header->_dropped : 0;
+}
+
+auto ForwardQueue::copyIn(std::uint64_t position, std::span<const std::byte> data) noexcept -> void
+{
+	const auto offset = std::size_t(position % _ring.size());
+	const auto first = std::min(data.size(), _ring.size() - offset);
+	std::memcpy(_ring.data() + offset, data.data(), first);
+	std::memcpy(_ring.data(), data.data() + first, data.size() - first);
+}
+
+auto ForwardQueue::copyOut(std::uint64_t position, std::span<std::byte> data) const noexcept -> void
+{
+	const auto offset = std::size_t(position % _ring.size());
+	const auto first = std::min(data.size(), _ring.size() - offset);
+	std::memcpy(data.data(), _ring.data() + offset, first);
+	std::memcpy(data.data() + first, _ring.data(), data.size() - first);
+}
+
+auto ForwardQueue::recordHeader(std::uint64_t position) const noexcept -> RecordHeader
+{
+	RecordHeader header;
+	copyOut(position, std::as_writable_bytes(std::span(&header, 1)));
+	return header;
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,187 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Session.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A persistent FIFO that holds output values while the I/O component is down.
+///
+/// The queue is stored in a memory-mapped file of a fixed size, so that values that could not be written survive a restart of
+/// Xentara. Records are appended to the file using ordinary memory stores, so appending a value costs no system call at all.
+///
+/// While the queue is *holding*, outputs append their values to the queue instead of writing them. When the I/O component comes
+/// back up, the records are replayed to the device in order, and the queue stops holding once it is empty.
+class ForwardQueue final : private utils::tools::Unique
+{
+public:
+	/// @brief What to do when a record does not fit into the queue
+	enum class OverflowPolicy
+	{
+		/// @brief Discard the oldest records until the new one fits
+		DropOldest,
+		/// @brief Discard the new record
+		DropNewest
+	};
+
+	/// @brief Base class for objects that can store values in the queue
+	class Entry
+	{
+	public:
+		/// @brief Virtual destructor
+		/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+		/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+		/// instantiable by accident as a result of refactoring.
+		virtual ~Entry() = 0;
+
+		/// @brief Writes a value stored in the queue to the device
+		/// @param lease A lease on the session to use
+		/// @param record The value, as it was passed to tryPush()
+		/// @param timeStamp The time stamp to use for the write
+		/// @return The error that occurred, or a default constructed std::error_code object on success
+		virtual auto replay(const Session::Lease &lease, std::span<const std::byte> record, std::chrono::system_clock::time_point timeStamp)
+			-> std::error_code = 0;
+	};
+
+	/// @brief A function that is called for each record when replaying the queue.
+	///
+	/// The function must return true if the record was dealt with, or false if it must stay in the queue.
+	using ReplayFunction = std::function<bool(Entry &entry, std::span<const std::byte> record)>;
+
+	/// @brief Parses an overflow policy from a configuration keyword
+	/// @return The policy, or std::nullopt if the keyword is unknown
+	static auto parseOverflowPolicy(std::string_view keyword) noexcept -> std::optional<OverflowPolicy>;
+
+	/// @brief Registers an entry.
+	///
+	/// All entries must be registered before the queue is opened, because the records identify their entry by the order of
+	/// registration.
+	/// @param entry The entry
+	/// @param type A value identifying the encoding of the records of the entry. If the configuration changes so that the
+	/// entries or their types no longer match the ones the file was written with, the file is discarded.
+	/// @return The index of the entry
+	auto attach(Entry &entry, std::uint32_t type) -> std::uint32_t;
+
+	/// @brief Opens or creates the file, and starts holding.
+	///
+	/// Records from a previous run are kept if the file matches the configuration.
+	/// @param path The path of the file
+	/// @param capacity The size of the queue, in bytes
+	/// @param overflowPolicy What to do if a record does not fit into the queue
+	auto open(const std::filesystem::path &path, std::size_t capacity, OverflowPolicy overflowPolicy) -> void;
+
+	/// @brief Checks whether the queue is holding.
+	///
+	/// This is a cheap check that can be used before tryPush(). Since it may be outdated by the time tryPush() is called,
+	/// tryPush() checks again.
+	auto holding() const noexcept -> bool
+	{
+		return _holding.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Starts holding values, if the queue is open
+	auto hold() noexcept -> void;
+
+	/// @brief Appends a record, if the queue is holding
+	/// @param entry The index of the entry, as returned by attach()
+	/// @param record The encoded value
+	/// @return true if the record was taken over by the queue (even if it was discarded due to overflow), or false if the queue
+	/// is not holding, and the value must be written normally.
+	auto tryPush(std::uint32_t entry, std::span<const std::byte> record) noexcept -> bool;
+
+	/// @brief Replays the records in the order they were appended.
+	///
+	/// Replaying stops as soon as the function returns false. If the queue runs empty, it stops holding. If another thread is
+	/// already replaying the queue, this function returns immediately.
+	/// @return true if the queue was emptied, or false if the function stopped the replay
+	auto replay(const ReplayFunction &function) -> bool;
+
+	/// @brief Returns the number of records discarded due to overflow since the file was created
+	auto dropped() const noexcept -> std::uint64_t;
+
+private:
+	/// @brief The header at the start of the file
+	struct Header final
+	{
+		/// @brief Identifies the file format
+		std::uint64_t _magic;
+		/// @brief The fingerprint of the entries the file was written with
+		std::uint64_t _layout;
+		/// @brief The size of the ring following the header
+		std::uint64_t _capacity;
+		/// @brief The position of the oldest record. Positions increase monotonically, and are taken modulo the capacity.
+		std::uint64_t _head;
+		/// @brief The position after the newest record
+		std::uint64_t _tail;
+		/// @brief The number of records discarded due to overflow
+		std::uint64_t _dropped;
+	};
+
+	/// @brief The header of a record. Records are aligned to the size of this header, so a header never wraps around.
+	struct RecordHeader final
+	{
+		/// @brief The size of the record, excluding the header and padding
+		std::uint32_t _size;
+		/// @brief The index of the entry the record belongs to
+		std::uint32_t _entry;
+	};
+
+	/// @brief Returns the space a record takes up in the ring, including the header and padding
+	static constexpr auto footprint(std::size_t size) noexcept -> std::uint64_t
+	{
+		return sizeof(RecordHeader) + (size + sizeof(RecordHeader) - 1) / sizeof(RecordHeader) * sizeof(RecordHeader);
+	}
+
+	/// @brief Copies data into the ring, wrapping around at the end
+	auto copyIn(std::uint64_t position, std::span<const std::byte> data) noexcept -> void;
+	/// @brief Copies data out of the ring, wrapping around at the end
+	auto copyOut(std::uint64_t position, std::span<std::byte> data) const noexcept -> void;
+	/// @brief Reads the header of the record at a position
+	auto recordHeader(std::uint64_t position) const noexcept -> RecordHeader;
+
+	/// @brief The registered entries, by index
+	std::vector<std::reference_wrapper<Entry>> _entries;
+	/// @brief The fingerprint of the registered entries
+	std::uint64_t _layout { 0xcbf29ce484222325 };
+
+	/// @brief What to do if a record does not fit
+	OverflowPolicy _overflowPolicy { OverflowPolicy::DropOldest };
+
+	/// @brief The file
+	MappedFile _file;
+	/// @brief The header in the file, or nullptr if the queue is not open
+	Header *_header { nullptr };
+	/// @brief The ring in the file
+	std::span<std::byte> _ring;
+
+	/// @brief Whether values are currently being held
+	std::atomic<bool> _holding { false };
+
+	/// @brief A mutex protecting the header and the ring
+	mutable std::mutex _mutex;
+	/// @brief A mutex held while replaying
+	std::mutex _replayMutex;
+	/// @brief A buffer the current record is copied into while replaying. Only used while holding _replayMutex.
+	std::vector<std::byte> _replayBuffer;
+};
+
+inline ForwardQueue::Entry::~Entry() = default;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,375 @@
+// Copyright (c) embedded ocean GmbH
+#include "History.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace xentara::plugins::templateDriver
+{
+
+namespace
+{
+
+	/// @brief The widths of the buckets used to store the change in the interval between time stamps
+	constexpr std::array<int, 3> kIntervalWidths { 16, 24, 32 };
+	/// @brief The widths of the buckets used to store the difference between integer values
+	constexpr std::array<int, 3> kDeltaWidths { 8, 16, 32 };
+
+	/// @brief Maps signed values to unsigned values, so that numbers close to zero have many leading zeros
+	constexpr auto zigZag(std::int64_t value) noexcept -> std::uint64_t
+	{
+		return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+	}
+
+	/// @brief Reverses zigZag()
+	constexpr auto unZigZag(std::uint64_t value) noexcept -> std::int64_t
+	{
+		return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);
+	}
+
+	/// @brief Returns a mask with the lowest bits set
+	constexpr auto lowBits(int count) noexcept -> std::uint64_t
+	{
+		return count >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1;
+	}
+
+} // namespace
+
+template <typename ValueType>
+class History<ValueType>::Writer final
+{
+public:
+	/// @brief Constructor
+	/// @param words The words of the block
+	/// @param position The position of the first bit to write
+	Writer(std::span<std::uint64_t> words, std::size_t position) noexcept : _words(words), _position(position)
+	{
+	}
+
+	/// @brief Writes the lowest bits of a value
+	auto write(std::uint64_t value, int count) noexcept -> void
+	{
+		value &= lowBits(count);
+		const auto word = _position / 64;
+		const auto offset = int(_position % 64);
+		_words[word] |= value << offset;
+		if (offset + count > 64)
+		{
+			_words[word + 1] |= value >> (64 - offset);
+		}
+		_position += std::size_t(count);
+	}
+
+	/// @brief Writes an unsigned value using the smallest of a set of bucket widths that fits.
+	///
+	/// Zero is written as a single 0 bit. The other buckets are selected using the prefixes 10, 110, and 1110, and
+	/// 1111 selects a full 64 bit value.
+	auto writeBucketed(std::uint64_t value, const std::array<int, 3> &widths) noexcept -> void
+	{
+		if (value == 0)
+		{
+			write(0b0, 1);
+			return;
+		}
+		for (std::size_t bucket = 0; bucket < widths.size(); ++bucket)
+		{
+			if (value <= lowBits(widths[bucket]))
+			{
+				// The prefix is a 0 bit preceded by bucket + 1 1 bits. The first bit written ends up lowest.
+				write(lowBits(int(bucket) + 1), int(bucket) + 2);
+				write(value, widths[bucket]);
+				return;
+			}
+		}
+		write(0b1111, 4);
+		write(value, 64);
+	}
+
+	/// @brief Returns the position of the next bit to write
+	auto position() const noexcept -> std::size_t
+	{
+		return _position;
+	}
+
+private:
+	/// @brief The words of the block
+	std::span<std::uint64_t> _words;
+	/// @brief The position of the next bit to write
+	std::size_t _position;
+};
+
+template <typename ValueType>
+class History<ValueType>::Reader final
+{
+public:
+	/// @brief Constructor
+	/// @param words The words of the block
+	Reader(std::span<const std::uint64_t> words) noexcept : _words(words)
+	{
+	}
+
+	/// @brief Reads a number of bits
+	auto read(int count) noexcept -> std::uint64_t
+	{
+		const auto word = _position / 64;
+		const auto offset = int(_position % 64);
+		auto value = _words[word] >> offset;
+		if (offset + count > 64)
+		{
+			value |= _words[word + 1] << (64 - offset);
+		}
+		_position += std::size_t(count);
+		return value & lowBits(count);
+	}
+
+	/// @brief Reads a value written using Writer::writeBucketed()
+	auto readBucketed(const std::array<int, 3> &widths) noexcept -> std::uint64_t
+	{
+		for (std::size_t bucket = 0; bucket <= widths.size(); ++bucket)
+		{
+			if (read(1) == 0)
+			{
+				return bucket == 0 ? 0 : read(widths[bucket - 1]);
+			}
+		}
+		return read(64);
+	}
+
+private:
+	/// @brief The words of the block
+	std::span<const std::uint64_t> _words;
+	/// @brief The position of the next bit to read
+	std::size_t _position { 0 };
+};
+
+template <typename ValueType>
+History<ValueType>::History(Arena &arena, std::size_t size)
+{
+	const auto blockCount = std::max<std::size_t>((size + kBlockSize - 1) / kBlockSize, 2);
+	_words = arena.makeArray<std::uint64_t>(blockCount * kBlockWords);
+	_blocks = arena.makeArray<Block>(blockCount);
+}
+
+template <typename ValueType>
+auto History<ValueType>::toBits(ValueType value) noexcept -> std::uint64_t
+{
+	if constexpr (std::floating_point<ValueType>)
+	{
+		using Bits = std::conditional_t<sizeof(ValueType) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+		return std::bit_cast<Bits>(value);
+	}
+	else
+	{
+		// Signed values are sign extended, so that small negative differences stay small
+		return std::uint64_t(value);
+	}
+}
+
+template <typename ValueType>
+auto History<ValueType>::fromBits(std::uint64_t bits) noexcept -> ValueType
+{
+	if constexpr (std::floating_point<ValueType>)
+	{
+		using Bits = std::conditional_t<sizeof(ValueType) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+		return std::bit_cast<ValueType>(Bits(bits));
+	}
+	else
+	{
+		return ValueType(bits);
+	}
+}
+
+template <typename ValueType>
+auto History<ValueType>::record(std::chrono::system_clock::time_point timeStamp, std::optional<ValueType> value) -> void
+{
+	std::scoped_lock lock(_mutex);
+
+	// Move on to the next block if the current one might not have room for the sample. This discards the oldest block.
+	auto *block = &_blocks[_current];
+	if (block->_sampleCount != 0 && kBlockWords * 64 - block->_bitCount < kMaxSampleBits)
+	{
+		_current = (_current + 1) % _blocks.size();
+		block = &_blocks[_current];
+		*block = {};
+		std::ranges::fill(blockWords(_current), 0);
+	}
+
+	Writer writer(blockWords(_current), block->_bitCount);
+	const auto time = timeStamp.time_since_epoch().count();
+
+	// The first sample of each block is stored uncompressed, so that the block can be decoded on its own
+	if (block->_sampleCount == 0)
+	{
+		_context = {};
+		writer.write(std::uint64_t(time), 64);
+	}
+	// Store the change in the interval between samples, which is zero for perfectly periodic samples
+	else
+	{
+		const auto interval = time - _context._time;
+		writer.writeBucketed(zigZag(interval - _context._interval), kIntervalWidths);
+		_context._interval = interval;
+	}
+	_context._time = time;
+
+	// Store whether there is a value
+	writer.write(value ? 1 : 0, 1);
+	if (value)
+	{
+		const auto bits = toBits(*value);
+
+		// Booleans always take a single bit
+		if constexpr (std::same_as<ValueType, bool>)
+		{
+			writer.write(bits, 1);
+		}
+		// Integers are stored as the difference to the previous value
+		else if constexpr (std::integral<ValueType>)
+		{
+			writer.writeBucketed(zigZag(std::int64_t(bits - _context._bits)), kDeltaWidths);
+		}
+		// Floating point values are stored as the meaningful bits of the XOR with the previous value
+		else
+		{
+			const auto difference = bits ^ _context._bits;
+			if (difference == 0)
+			{
+				writer.write(0b0, 1);
+			}
+			else
+			{
+				writer.write(0b1, 1);
+				const auto leading = std::countl_zero(difference);
+				const auto trailing = std::countr_zero(difference);
+
+				// Reuse the window of the previous value if the meaningful bits fit into it
+				if (leading >= _context._leading && trailing >= _context._trailing)
+				{
+					writer.write(0b0, 1);
+					writer.write(difference >> _context._trailing, 64 - _context._leading - _context._trailing);
+				}
+				// Otherwise, store a new window
+				else
+				{
+					const auto length = 64 - leading - trailing;
+					writer.write(0b1, 1);
+					writer.write(std::uint64_t(leading), 6);
+					writer.write(std::uint64_t(length - 1), 6);
+					writer.write(difference >> trailing, length);
+					_context._leading = leading;
+					_context._trailing = trailing;
+				}
+			}
+		}
+
+		_context._bits = bits;
+	}
+
+	block->_bitCount = writer.position();
+	++block->_sampleCount;
+	block->_last = timeStamp;
+}
+
+template <typename ValueType>
+auto History<ValueType>::read(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> void
+{
+	std::scoped_lock lock(_mutex);
+
+	// Go through the blocks from the oldest to the newest. The oldest block is the one after the current one.
+	for (std::size_t offset = 1; offset <= _blocks.size(); ++offset)
+	{
+		const auto index = (_current + offset) % _blocks.size();
+		const auto &block = _blocks[index];
+
+		// Skip empty blocks, and blocks that only contain older samples
+		if (block._sampleCount == 0 || block._last < since)
+		{
+			continue;
+		}
+
+		// Decode the samples, tracking the same state as the encoder
+		Reader reader(blockWords(index));
+		Context context;
+		for (std::size_t sample = 0; sample < block._sampleCount; ++sample)
+		{
+			if (sample == 0)
+			{
+				context._time = std::chrono::system_clock::rep(reader.read(64));
+			}
+			else
+			{
+				context._interval += unZigZag(reader.readBucketed(kIntervalWidths));
+				context._time += context._interval;
+			}
+			const auto timeStamp = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(context._time));
+
+			std::optional<ValueType> value;
+			if (reader.read(1) != 0)
+			{
+				if constexpr (std::same_as<ValueType, bool>)
+				{
+					context._bits = reader.read(1);
+				}
+				else if constexpr (std::integral<ValueType>)
+				{
+					context._bits += std::uint64_t(unZigZag(reader.readBucketed(kDeltaWidths)));
+				}
+				else if (reader.read(1) != 0)
+				{
+					if (reader.read(1) != 0)
+					{
+						context._leading = int(reader.read(6));
+						const auto length = int(reader.read(6)) + 1;
+						context._trailing = 64 - context._leading - length;
+					}
+					context._bits ^= reader.read(64 - context._leading - context._trailing) << context._trailing;
+				}
+				value = fromBits(context._bits);
+			}
+
+			if (timeStamp < since)
+			{
+				continue;
+			}
+
+			// Widen the value to the common type
+			if (!value)
+			{
+				function(timeStamp, std::monostate());
+			}
+			else if constexpr (std::same_as<ValueType, bool>)
+			{
+				function(timeStamp, *value);
+			}
+			else if constexpr (std::signed_integral<ValueType>)
+			{
+				function(timeStamp, std::int64_t(*value));
+			}
+			else if constexpr (std::unsigned_integral<ValueType>)
+			{
+				function(timeStamp, std::uint64_t(*value));
+			}
+			else
+			{
+				function(timeStamp, double(*value));
+			}
+		}
+	}
+}
+
+/// @class xentara::plugins::templateDriver::History
+/// @todo change list of template instantiations to the supported types
+template class History<bool>;
+template class History<std::uint8_t>;
+template class History<std::uint16_t>;
+template class History<std::uint32_t>;
+template class History<std::uint64_t>;
+template class History<std::int8_t>;
+template class History<std::int16_t>;
+template class History<std::int32_t>;
+template class History<std::int64_t>;
+template class History<float>;
+template class History<double>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
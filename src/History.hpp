@@ -0,0 +1,144 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "Arena.hpp"
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <variant>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief The value of a sample in the history of a data point, widened to a common type.
+///
+/// Holds std::monostate if the sample did not have a valid value.
+using HistoryValue = std::variant<std::monostate, bool, std::int64_t, std::uint64_t, double>;
+
+/// @brief A function that is called for each sample in the history of a data point
+using HistoryFunction = std::function<void(std::chrono::system_clock::time_point timeStamp, const HistoryValue &value)>;
+
+/// @brief Checks whether a history can be recorded for values of a certain type
+template <typename ValueType>
+concept HistoryValueType = std::integral<ValueType> || std::floating_point<ValueType>;
+
+/// @brief A compressed ring buffer containing the recent values of a data point.
+///
+/// The samples are compressed using the scheme used by Facebook's Gorilla time series database: time stamps are stored as
+/// the difference between consecutive intervals, floating point values as the XOR with the previous value, and integers as
+/// the difference to the previous value, each using a variable number of bits. Periodically polled signals that change
+/// slowly thus take only a few bits per sample.
+///
+/// The buffer is divided into blocks that are compressed independently. When the newest block is full, the oldest block is
+/// discarded and reused, so the history always covers the most recent samples that fit into the buffer.
+///
+/// Recording and reading are thread-safe.
+/// @tparam ValueType The type of the values
+template <typename ValueType>
+class History final
+{
+	// Make sure the values can be compressed
+	static_assert(HistoryValueType<ValueType>, "history is only supported for numeric and boolean values");
+
+public:
+	/// @brief The size of a block, in bytes
+	static constexpr std::size_t kBlockSize = 256;
+
+	/// @brief Constructor that allocates the buffer
+	/// @param arena The arena to allocate the buffer from
+	/// @param size The size of the buffer, in bytes. This is rounded up to a whole number of blocks, and at least two blocks
+	/// are allocated, so that the history never becomes empty when the oldest block is discarded.
+	History(Arena &arena, std::size_t size);
+
+	/// @brief Records a sample
+	/// @param timeStamp The time stamp of the sample
+	/// @param value The value, or std::nullopt if no valid value was read
+	auto record(std::chrono::system_clock::time_point timeStamp, std::optional<ValueType> value) -> void;
+
+	/// @brief Calls a function for each sample recorded at or after a certain time, in the order they were recorded
+	/// @param since The time stamp of the oldest sample of interest
+	/// @param function The function to call
+	auto read(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> void;
+
+private:
+	/// @brief The number of 64 bit words in a block
+	static constexpr std::size_t kBlockWords = kBlockSize / sizeof(std::uint64_t);
+	/// @brief The maximum number of bits needed to encode a sample
+	static constexpr std::size_t kMaxSampleBits = 160;
+
+	/// @brief Bookkeeping information for a block
+	struct Block final
+	{
+		/// @brief The number of bits used
+		std::size_t _bitCount { 0 };
+		/// @brief The number of samples in the block
+		std::size_t _sampleCount { 0 };
+		/// @brief The time stamp of the last sample in the block
+		std::chrono::system_clock::time_point _last;
+	};
+
+	/// @brief The state shared between consecutive samples of a block. The encoder and the decoder track the same state.
+	struct Context final
+	{
+		/// @brief The time stamp of the previous sample
+		std::chrono::system_clock::rep _time { 0 };
+		/// @brief The interval between the two previous samples
+		std::chrono::system_clock::rep _interval { 0 };
+		/// @brief The raw bits of the previous valid value
+		std::uint64_t _bits { 0 };
+		/// @brief The number of leading zeros of the last XOR window, or 64 if there is none
+		int _leading { 64 };
+		/// @brief The number of trailing zeros of the last XOR window
+		int _trailing { 0 };
+	};
+
+	/// @brief Writes bits into a block
+	class Writer;
+	/// @brief Reads bits from a block
+	class Reader;
+
+	/// @brief Converts a value to its raw bits
+	static auto toBits(ValueType value) noexcept -> std::uint64_t;
+	/// @brief Converts raw bits back to a value
+	static auto fromBits(std::uint64_t bits) noexcept -> ValueType;
+
+	/// @brief Returns the words of a block
+	auto blockWords(std::size_t index) const noexcept -> std::span<std::uint64_t>
+	{
+		return _words.subspan(index * kBlockWords, kBlockWords);
+	}
+
+	/// @brief The words of all the blocks
+	std::span<std::uint64_t> _words;
+	/// @brief The bookkeeping information for all the blocks
+	std::span<Block> _blocks;
+	/// @brief The index of the block samples are currently added to
+	std::size_t _current { 0 };
+	/// @brief The encoder state for the current block
+	Context _context;
+
+	/// @brief A mutex protecting the buffer
+	mutable std::mutex _mutex;
+};
+
+/// @class xentara::plugins::templateDriver::History
+/// @todo change list of extern template statements to the supported types
+extern template class History<bool>;
+extern template class History<std::uint8_t>;
+extern template class History<std::uint16_t>;
+extern template class History<std::uint32_t>;
+extern template class History<std::uint64_t>;
+extern template class History<std::int8_t>;
+extern template class History<std::int16_t>;
+extern template class History<std::int32_t>;
+extern template class History<std::int64_t>;
+extern template class History<float>;
+extern template class History<double>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
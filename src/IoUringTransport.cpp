@@ -0,0 +1,223 @@
+// Copyright (c) embedded ocean GmbH
+#ifdef XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
+
+#include "IoUringTransport.hpp"
+
+#include "CustomError.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <system_error>
+
+#include <errno.h>
+#include <sys/uio.h>
+
+namespace xentara::plugins::templateDriver
+{
+
+IoUringTransport::IoUringTransport(int socket) : _socket(socket)
+{
+	// Create the ring
+	if (const auto result = ::io_uring_queue_init(kQueueDepth, &_ring, 0); result < 0)
+	{
+		throw std::system_error(-result, std::system_category(), "could not create io_uring");
+	}
+
+	// Register the buffers. The request buffers get the indices 0 to kMaxBatchSize - 1, and the response buffers the indices
+	// kMaxBatchSize to 2 * kMaxBatchSize - 1.
+	std::array<::iovec, 2 * kMaxBatchSize> buffers;
+	for (std::size_t index = 0; index < kMaxBatchSize; ++index)
+	{
+		buffers[index] = { requestBuffer(index).data(), kBufferSize };
+		buffers[kMaxBatchSize + index] = { responseBuffer(index).data(), kBufferSize };
+	}
+	if (const auto result = ::io_uring_register_buffers(&_ring, buffers.data(), unsigned(buffers.size())); result < 0)
+	{
+		::io_uring_queue_exit(&_ring);
+		throw std::system_error(-result, std::system_category(), "could not register io_uring buffers");
+	}
+}
+
+IoUringTransport::~IoUringTransport()
+{
+	// This also cancels any operations still in flight
+	::io_uring_queue_exit(&_ring);
+}
+
+auto IoUringTransport::exchange(std::span<const Exchange> exchanges) -> void
+{
+	// If the operations of a previous exchange could not be cancelled, the kernel may still be using the buffers
+	if (_broken)
+	{
+		throw std::system_error(EBADF, std::system_category(), "transport unusable after timeout");
+	}
+
+	// The operations are all the sends, followed by all the receives. Stream sockets deliver the responses in the order the
+	// requests were sent.
+	const auto operationCount = 2 * exchanges.size();
+	const auto operationBuffer = [&](std::size_t operation) -> std::span<std::byte>
+	{
+		if (operation < exchanges.size())
+		{
+			return requestBuffer(operation).first(exchanges[operation]._requestSize);
+		}
+		const auto index = operation - exchanges.size();
+		return responseBuffer(index).first(exchanges[index]._responseSize);
+	};
+	// The registered buffer index of an operation
+	const auto bufferIndex = [&](std::size_t operation) -> int
+	{
+		return int(operation < exchanges.size() ? operation : kMaxBatchSize + operation - exchanges.size());
+	};
+
+	// The number of bytes transferred by each operation so far
+	std::array<std::size_t, kQueueDepth> progress {};
+
+	const auto deadline = std::chrono::steady_clock::now() + kTimeout;
+	for (std::size_t first = 0; first < operationCount;)
+	{
+		// Queue all the remaining operations as a single linked chain, so that they are executed in order.
+		unsigned queued = 0;
+		std::array<bool, kQueueDepth> inFlight {};
+		::io_uring_sqe *submission = nullptr;
+		for (auto operation = first; operation < operationCount; ++operation)
+		{
+			// Skip operations that are already complete, or that have nothing to transfer
+			const auto buffer = operationBuffer(operation).subspan(progress[operation]);
+			if (buffer.empty())
+			{
+				continue;
+			}
+
+			// There is always room for all the operations, because all completions are reaped before the next round
+			submission = ::io_uring_get_sqe(&_ring);
+			if (operation < exchanges.size())
+			{
+				::io_uring_prep_write_fixed(submission, _socket, buffer.data(), unsigned(buffer.size()), 0, bufferIndex(operation));
+			}
+			else
+			{
+				::io_uring_prep_read_fixed(submission, _socket, buffer.data(), unsigned(buffer.size()), 0, bufferIndex(operation));
+			}
+			::io_uring_sqe_set_data64(submission, operation);
+			submission->flags |= IOSQE_IO_LINK;
+			inFlight[operation] = true;
+
+			++queued;
+		}
+		// The last operation ends the chain
+		if (submission)
+		{
+			submission->flags &= ~IOSQE_IO_LINK;
+		}
+		else
+		{
+			break;
+		}
+
+		// Submit the chain, and wait for all the completions, using a single system call
+		const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+		::__kernel_timespec timeout {
+			.tv_sec = std::max<std::int64_t>(remaining.count(), 0) / 1'000'000'000,
+			.tv_nsec = std::max<std::int64_t>(remaining.count(), 0) % 1'000'000'000 };
+		::io_uring_cqe *completion = nullptr;
+		if (const auto result = ::io_uring_submit_and_wait_timeout(&_ring, &completion, queued, &timeout, nullptr); result < 0 && result != -ETIME)
+		{
+			_broken = true;
+			throw std::system_error(-result, std::system_category(), "could not submit io_uring operations");
+		}
+
+		// Reap the completions
+		unsigned completed = 0;
+		int error = 0;
+		unsigned head;
+		io_uring_for_each_cqe(&_ring, head, completion)
+		{
+			++completed;
+			const auto operation = std::size_t(::io_uring_cqe_get_data64(completion));
+			const auto result = completion->res;
+			inFlight[operation] = false;
+			if (result > 0)
+			{
+				progress[operation] += std::size_t(result);
+			}
+			// A receive of zero bytes means that the device closed the connection
+			else if (result == 0 && operation >= exchanges.size() && !error)
+			{
+				error = ECONNRESET;
+			}
+			// Operations that were cancelled because an earlier one in the chain was short are simply submitted again
+			else if (result < 0 && result != -ECANCELED && !error)
+			{
+				error = -result;
+			}
+		}
+		::io_uring_cq_advance(&_ring, completed);
+
+		// If not all operations have completed, we timed out with operations still in flight
+		if (completed < queued)
+		{
+			cancel(inFlight, queued - completed);
+			throw std::system_error(CustomError::Timeout, "timeout waiting for device");
+		}
+		if (error)
+		{
+			throw std::system_error(error, std::system_category(), "could not exchange data with device");
+		}
+
+		// Skip the operations that are complete. A short send or receive breaks the chain, so the rest are submitted again.
+		while (first < operationCount && progress[first] == operationBuffer(first).size())
+		{
+			++first;
+		}
+	}
+}
+
+auto IoUringTransport::cancel(std::span<const bool> inFlight, unsigned count) noexcept -> void
+{
+	// Cancel each operation that is still in flight. The cancellations are tagged, so we can tell their completions apart.
+	for (std::size_t operation = 0; operation < inFlight.size(); ++operation)
+	{
+		if (inFlight[operation])
+		{
+			auto submission = ::io_uring_get_sqe(&_ring);
+			::io_uring_prep_cancel64(submission, operation, 0);
+			::io_uring_sqe_set_data64(submission, kCancelTag);
+		}
+	}
+
+	// Wait for the completions of both the operations and the cancellations. The cancellations themselves can only time out
+	// if something is badly wrong.
+	auto remaining = 2 * count;
+	::__kernel_timespec timeout { .tv_sec = std::chrono::duration_cast<std::chrono::seconds>(kTimeout).count(), .tv_nsec = 0 };
+	while (remaining > 0)
+	{
+		::io_uring_cqe *completion = nullptr;
+		if (const auto result = ::io_uring_submit_and_wait_timeout(&_ring, &completion, remaining, &timeout, nullptr);
+			result < 0 && result != -ETIME && result != -EINTR)
+		{
+			break;
+		}
+
+		unsigned completed = 0;
+		unsigned head;
+		io_uring_for_each_cqe(&_ring, head, completion)
+		{
+			++completed;
+		}
+		::io_uring_cq_advance(&_ring, completed);
+		if (completed == 0)
+		{
+			break;
+		}
+		remaining -= std::min(completed, remaining);
+	}
+
+	// If not everything completed, the kernel may still write into the buffers, so the transport must not be used again
+	_broken = remaining > 0;
+}
+
+} // namespace xentara::plugins::templateDriver
+
+#endif // XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
\ No newline at end of file
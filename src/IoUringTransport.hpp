@@ -0,0 +1,63 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#ifdef XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
+
+#include "Transport.hpp"
+
+#include <liburing.h>
+
+#include <cstdint>
+#include <span>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A transport that uses io_uring with registered buffers.
+///
+/// All the sends and receives of a batch are submitted as a single linked chain, using a single system call. The request
+/// and response buffers are registered with the kernel when the transport is created, so the kernel need not map them for
+/// each operation.
+class IoUringTransport final : public Transport
+{
+public:
+	/// @brief Constructor
+	/// @param socket A connected stream socket
+	/// @throw std::system_error if the kernel does not support io_uring, or the buffers could not be registered
+	explicit IoUringTransport(int socket);
+
+	/// @brief Destructor
+	~IoUringTransport();
+
+protected:
+	/// @name Virtual Overrides for Transport
+	/// @{
+
+	auto exchange(std::span<const Exchange> exchanges) -> void final;
+
+	/// @}
+
+private:
+	/// @brief The number of entries in the submission queue. This must be enough for a send and a receive for each exchange.
+	static constexpr unsigned kQueueDepth = 2 * kMaxBatchSize;
+	/// @brief The user data used to tag cancellation requests
+	static constexpr std::uint64_t kCancelTag = ~std::uint64_t(0);
+
+	/// @brief Cancels the operations still in flight after a timeout, and waits for them to finish
+	/// @param inFlight Which operations are still in flight, by operation index
+	/// @param count The number of operations still in flight
+	auto cancel(std::span<const bool> inFlight, unsigned count) noexcept -> void;
+
+	/// @brief The socket
+	int _socket;
+	/// @brief The ring
+	::io_uring _ring;
+	/// @brief Set if operations that timed out could not be cancelled.
+	///
+	/// In that case the kernel may still be accessing the buffers, so the transport must not be used again.
+	bool _broken { false };
+};
+
+} // namespace xentara::plugins::templateDriver
+
+#endif // XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
\ No newline at end of file
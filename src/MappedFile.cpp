@@ -0,0 +1,75 @@
+// Copyright (c) embedded ocean GmbH
+#include "MappedFile.hpp"
+
+#include <string>
+#include <system_error>
+
+#ifndef _WIN32
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+#ifndef _WIN32
+
+MappedFile::~MappedFile()
+{
+	if (!_bytes.empty())
+	{
+		::munmap(_bytes.data(), _bytes.size());
+	}
+}
+
+auto MappedFile::open(const std::filesystem::path &path, std::size_t size) -> void
+{
+	const auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not open "s + path.string());
+	}
+
+	// Recreate the contents if the file does not have the correct size. Truncating the file to zero first discards the old contents.
+	struct ::stat status;
+	const auto resized = ::fstat(fd, &status) == 0 &&
+		(std::size_t(status.st_size) == size || (::ftruncate(fd, 0) == 0 && ::ftruncate(fd, ::off_t(size)) == 0));
+	if (!resized)
+	{
+		const auto error = errno;
+		::close(fd);
+		throw std::system_error(error, std::system_category(), "could not resize "s + path.string());
+	}
+
+	// Map the file. We never call msync(), because the kernel writes back the dirty pages by itself.
+	auto *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	const auto error = errno;
+	::close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		throw std::system_error(error, std::system_category(), "could not map "s + path.string());
+	}
+
+	_bytes = { static_cast<std::byte *>(mapping), size };
+}
+
+#else // _WIN32
+
+MappedFile::~MappedFile()
+{
+}
+
+auto MappedFile::open(const std::filesystem::path &path, std::size_t size) -> void
+{
+	/// @todo implement using CreateFileMappingW() and MapViewOfFile()
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "memory-mapped files are not supported on this platform");
+}
+
+#endif // _WIN32
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A file of a fixed size that is mapped into memory for reading and writing.
+///
+/// Changes are made using ordinary memory stores, and are written back to disk by the operating system in the background.
+/// Changes therefore survive a termination of the process, but changes made shortly before a power failure may be lost.
+class MappedFile final : private utils::tools::Unique
+{
+public:
+	/// @brief Default constructor that does not map any file
+	MappedFile() noexcept = default;
+
+	/// @brief Destructor that unmaps the file
+	~MappedFile();
+
+	/// @brief Opens or creates a file and maps it into memory.
+	///
+	/// If the file exists and has the requested size, its contents are kept. Otherwise, the file is filled with zeros.
+	/// @param path The path of the file
+	/// @param size The size of the file, in bytes
+	/// @throw std::system_error if the file could not be mapped
+	auto open(const std::filesystem::path &path, std::size_t size) -> void;
+
+	/// @brief Checks whether a file is mapped
+	auto isOpen() const noexcept -> bool
+	{
+		return !_bytes.empty();
+	}
+
+	/// @brief Returns the contents of the file
+	auto bytes() const noexcept -> std::span<std::byte>
+	{
+		return _bytes;
+	}
+
+private:
+	/// @brief The mapped contents of the file
+	std::span<std::byte> _bytes;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
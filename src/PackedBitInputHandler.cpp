@@ -0,0 +1,77 @@
+// Copyright (c) embedded ocean GmbH
+#include "PackedBitInputHandler.hpp"
+
+#include "TemplateInputHandler.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/data/ReadHandle.hpp>
+#include <xentara/model/Attribute.hpp>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+auto PackedBitInputHandler::dataType() const -> const data::DataType &
+{
+	// The input has the same data type as an ordinary boolean input
+	return TemplateInputHandler<bool>::kValueAttribute.dataType();
+}
+
+auto PackedBitInputHandler::forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool
+{
+	return
+		// Handle the value attribute separately
+		function(TemplateInputHandler<bool>::kValueAttribute) ||
+
+		// Handle the state attributes
+		_state.forEachAttribute(function);
+}
+
+auto PackedBitInputHandler::forEachEvent(const model::ForEachEventFunction &function, std::shared_ptr<void> parent) -> bool
+{
+	return
+		// Handle the state events
+		_state.forEachEvent(function, parent);
+}
+
+auto PackedBitInputHandler::makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle>
+{
+	// Handle the value attribute separately
+	if (attribute == TemplateInputHandler<bool>::kValueAttribute)
+	{
+		return _state.valueReadHandle();
+	}
+
+	// Handle the state attributes
+	if (auto handle = _state.makeReadHandle(attribute))
+	{
+		return handle;
+	}
+
+	return std::nullopt;
+}
+
+auto PackedBitInputHandler::realize() -> void
+{
+	// Realize the state object
+	_state.realize();
+}
+
+auto PackedBitInputHandler::read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+{
+	// Let the word read the value for all its bits. The word updates our state, even on error.
+	if (const auto error = _word.get().read(lease, timeStamp))
+	{
+		// Notify the error sink
+		errorSink.handleReadError(lease, timeStamp, error);
+	}
+}
+
+auto PackedBitInputHandler::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents)
+	-> void
+{
+	_state.update(timeStamp, utils::eh::unexpected(error), raiseEvents);
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
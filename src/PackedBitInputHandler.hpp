@@ -0,0 +1,83 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "AbstractTemplateInputHandler.hpp"
+#include "PackedInputWord.hpp"
+#include "ReadState.hpp"
+
+#include <cstddef>
+#include <functional>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief Functionality for a boolean TemplateInput that refers to a single bit of a word on the device.
+///
+/// The value is read by the packed word the bit belongs to, which reads the word once for all the inputs attached to it.
+class PackedBitInputHandler final : public AbstractTemplateInputHandler
+{
+public:
+	/// @brief Constructor
+	/// @param word The word the bit belongs to. The handler must be attached to the word using attach() afterwards.
+	explicit PackedBitInputHandler(std::reference_wrapper<PackedInputWord> word) noexcept : _word(word)
+	{
+	}
+
+	/// @brief Attaches the handler to a bit of its word
+	/// @param bit The index of the bit
+	/// @return true on success, or false if another input already uses the bit
+	auto attach(std::size_t bit) noexcept -> bool
+	{
+		return _word.get().attach(bit, _state);
+	}
+
+	/// @name Virtual Overrides for AbstractTemplateInputHandler
+	/// @{
+
+	auto dataType() const -> const data::DataType & final;
+
+	auto forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool final;
+
+	auto forEachEvent(const model::ForEachEventFunction &function, std::shared_ptr<void> parent) -> bool final;
+
+	auto makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle> final;
+
+	auto realize() -> void final;
+
+	auto enableHistory(Arena &arena, std::size_t size) -> bool final
+	{
+		return _state.enableHistory(arena, size);
+	}
+
+	auto readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool final
+	{
+		return _state.readHistory(since, function);
+	}
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final
+	{
+		_state.enableSnapshot(snapshot);
+	}
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void final
+	{
+		_state.enableStaleness(arena, index, maxAge);
+	}
+
+	auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
+
+	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void final;
+
+	///@}
+
+private:
+	/// @brief The word the bit belongs to
+	std::reference_wrapper<PackedInputWord> _word;
+
+	/// @brief The state. This is updated by the word.
+	ReadState<bool> _state;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
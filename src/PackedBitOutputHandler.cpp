@@ -0,0 +1,144 @@
+// Copyright (c) embedded ocean GmbH
+#include "PackedBitOutputHandler.hpp"
+
+#include "TemplateOutputHandler.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/data/ReadHandle.hpp>
+#include <xentara/data/WriteHandle.hpp>
+#include <xentara/model/Attribute.hpp>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+auto PackedBitOutputHandler::attach(std::size_t bit) noexcept -> bool
+{
+	auto &word = _word.get();
+
+	// Attach ourselves for writing, and our read state for reading back the value
+	if (!word.attach(bit, *this) || !word.readBack().attach(bit, _readState))
+	{
+		return false;
+	}
+
+	_bit = bit;
+	return true;
+}
+
+auto PackedBitOutputHandler::written(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	if (error)
+	{
+		_writeState.update(timeStamp, error);
+		return;
+	}
+
+	// The device has acknowledged the value, so this is the end of the write latency.
+	const auto scheduledTime = _scheduledTime.load(std::memory_order_relaxed);
+	_writeState.update(timeStamp, std::error_code(), std::chrono::steady_clock::now() - scheduledTime);
+}
+
+auto PackedBitOutputHandler::dataType() const -> const data::DataType &
+{
+	// The output has the same data type as an ordinary boolean output
+	return TemplateOutputHandler<bool>::kValueAttribute.dataType();
+}
+
+auto PackedBitOutputHandler::forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool
+{
+	return
+		// Handle the value attribute separately
+		function(TemplateOutputHandler<bool>::kValueAttribute) ||
+
+		// Handle the read state attributes
+		_readState.forEachAttribute(function) ||
+		// Handle the write state attributes
+		_writeState.forEachAttribute(function);
+}
+
+auto PackedBitOutputHandler::forEachEvent(const model::ForEachEventFunction &function, std::shared_ptr<void> parent) -> bool
+{
+	return
+		// Handle the read state events
+		_readState.forEachEvent(function, parent) ||
+		// Handle the write state events
+		_writeState.forEachEvent(function, parent);
+}
+
+auto PackedBitOutputHandler::makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle>
+{
+	// Handle the value attribute separately
+	if (attribute == TemplateOutputHandler<bool>::kValueAttribute)
+	{
+		return _readState.valueReadHandle();
+	}
+
+	// Handle the read state attributes
+	if (auto handle = _readState.makeReadHandle(attribute))
+	{
+		return handle;
+	}
+	// Handle the write state attributes
+	if (auto handle = _writeState.makeReadHandle(attribute))
+	{
+		return handle;
+	}
+
+	return std::nullopt;
+}
+
+auto PackedBitOutputHandler::makeWriteHandle(const model::Attribute &attribute, std::shared_ptr<void> parent) noexcept
+	-> std::optional<data::WriteHandle>
+{
+	// Handle the value attribute, which is the only writable attribute
+	if (attribute == TemplateOutputHandler<bool>::kValueAttribute)
+	{
+		// Make a shared pointer that refers to this handler
+		std::shared_ptr<PackedBitOutputHandler> sharedThis(parent, this);
+
+		// This creates a write handle of type bool that calls scheduleOutputValue() on sharedThis.
+		// (There are two sets of braces needed here: one for data::WriteHandle, and one for std::optional)
+		return {{ std::in_place_type<bool>, &PackedBitOutputHandler::scheduleOutputValue, sharedThis }};
+	}
+
+	return std::nullopt;
+}
+
+auto PackedBitOutputHandler::realize() -> void
+{
+	// Realize the state objects
+	_readState.realize();
+	_writeState.realize();
+}
+
+auto PackedBitOutputHandler::read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+{
+	// Let the read-back word read the value for all its bits. The word updates our read state, even on error.
+	if (const auto error = _word.get().readBack().read(lease, timeStamp))
+	{
+		// Notify the error sink
+		errorSink.handleReadError(lease, timeStamp, error);
+	}
+}
+
+auto PackedBitOutputHandler::updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents)
+	-> void
+{
+	_readState.update(timeStamp, utils::eh::unexpected(error), raiseEvents);
+}
+
+auto PackedBitOutputHandler::write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &/*errorSink*/)
+	-> void
+{
+	// Let the word write the pending changes of all its bits. The word updates our write state and notifies our error sink itself.
+	_word.get().write(lease, timeStamp);
+}
+
+auto PackedBitOutputHandler::updateWriteState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	_writeState.update(timeStamp, error);
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,137 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "AbstractTemplateOutputHandler.hpp"
+#include "PackedOutputWord.hpp"
+#include "ReadState.hpp"
+#include "WriteState.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief Functionality for a boolean TemplateOutput that refers to a single bit of a word on the device.
+///
+/// Values are not written individually, but recorded in the packed word the bit belongs to, which writes the changes of all
+/// its bits together.
+class PackedBitOutputHandler final : public AbstractTemplateOutputHandler
+{
+public:
+	/// @brief Constructor
+	/// @param word The word the bit belongs to. The handler must be attached to the word using attach() afterwards.
+	/// @param errorSink The error sink to notify of write errors detected by the word
+	PackedBitOutputHandler(std::reference_wrapper<PackedOutputWord> word, ErrorSink &errorSink) noexcept :
+		_word(word),
+		_errorSink(errorSink)
+	{
+	}
+
+	/// @brief Attaches the handler to a bit of its word
+	/// @param bit The index of the bit
+	/// @return true on success, or false if another output already uses the bit
+	auto attach(std::size_t bit) noexcept -> bool;
+
+	/// @brief Called by the word after the bit was written
+	/// @param timeStamp The time stamp of the write
+	/// @param error The error code, or a default constructed std::error_code object if the write succeeded
+	auto written(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void;
+
+	/// @brief Returns the error sink to notify of write errors
+	auto errorSink() const noexcept -> ErrorSink &
+	{
+		return _errorSink;
+	}
+
+	/// @name Virtual Overrides for AbstractTemplateOutputHandler
+	/// @{
+
+	auto dataType() const -> const data::DataType & final;
+
+	auto forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool final;
+
+	auto forEachEvent(const model::ForEachEventFunction &function, std::shared_ptr<void> parent) -> bool final;
+
+	auto makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle> final;
+
+	auto makeWriteHandle(const model::Attribute &attribute, std::shared_ptr<void> parent) noexcept -> std::optional<data::WriteHandle> final;
+
+	auto realize() -> void final;
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final
+	{
+		_readState.enableSnapshot(snapshot);
+	}
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void final
+	{
+		_readState.enableStaleness(arena, index, maxAge);
+	}
+
+	/// @note Writes of bits cannot be skipped, because the word is written as a whole
+	auto enableWriteOnChange(std::chrono::milliseconds /*rewriteInterval*/) -> bool final
+	{
+		return false;
+	}
+
+	auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
+
+	auto updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void final;
+
+	auto write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
+
+	auto queueWrite(const Session::Lease & /*lease*/, Transport::Batch & /*batch*/, std::chrono::system_clock::time_point /*timeStamp*/,
+		ErrorSink & /*errorSink*/) -> bool final
+	{
+		// The changes are written by the word, which adds itself to the write lane
+		return false;
+	}
+
+	auto finishWrite(const Session::Lease & /*lease*/, const Transport::Batch & /*batch*/,
+		std::chrono::system_clock::time_point /*timeStamp*/, ErrorSink & /*errorSink*/) -> void final
+	{
+	}
+
+	auto abortWrite(const Session::Lease & /*lease*/, std::chrono::system_clock::time_point /*timeStamp*/, std::error_code /*error*/,
+		ErrorSink & /*errorSink*/) -> void final
+	{
+	}
+
+	auto updateWriteState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+
+	///@}
+
+private:
+	/// @brief Schedules a value to be written.
+	///
+	/// This function is called by the value write handle.
+	auto scheduleOutputValue(bool value) noexcept
+	{
+		// Store the time before recording the change, so that whoever writes the change sees the time as well
+		_scheduledTime.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+		_word.get().schedule(_bit, value);
+	}
+
+	/// @brief The word the bit belongs to
+	std::reference_wrapper<PackedOutputWord> _word;
+	/// @brief The index of the bit within the word
+	std::size_t _bit { 0 };
+
+	/// @brief The error sink to notify of write errors
+	std::reference_wrapper<ErrorSink> _errorSink;
+
+	/// @brief The read state. This is updated by the read-back word.
+	ReadState<bool> _readState;
+	/// @brief The write state
+	WriteState _writeState;
+
+	/// @brief The time the last value was scheduled
+	std::atomic<std::chrono::steady_clock::time_point> _scheduledTime;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,87 @@
+// Copyright (c) embedded ocean GmbH
+#include "PackedInputWord.hpp"
+
+#include "Bits.hpp"
+
+#include <xentara/utils/eh/currentErrorCode.hpp>
+
+#include <algorithm>
+#include <bit>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+auto PackedInputWord::attach(std::size_t bit, ReadState<bool> &state) noexcept -> bool
+{
+	// Each bit can only be used once, because the states are indexed by the position of the bit within the mask
+	const auto bitMask = Word(Word(1) << bit);
+	if (_mask & bitMask)
+	{
+		return false;
+	}
+
+	// Insert the state at the position of the bit among the used bits
+	const auto count = std::size_t(std::popcount(_mask));
+	const auto position = std::size_t(std::popcount(Word(_mask & (bitMask - 1))));
+	std::copy_backward(_states.begin() + position, _states.begin() + count, _states.begin() + count + 1);
+	_states[position] = &state;
+	_mask |= bitMask;
+
+	return true;
+}
+
+auto PackedInputWord::read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> std::error_code
+{
+	std::scoped_lock lock(_mutex);
+
+	// If another input already read the word for this cycle, its value was committed to our state as well
+	if (timeStamp == _lastRead)
+	{
+		return {};
+	}
+	_lastRead = timeStamp;
+
+	try
+	{
+		// Call the other read function, but catch exceptions.
+		doRead(lease, timeStamp);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		const auto error = utils::eh::currentErrorCode();
+		// Update the states of all the inputs
+		const auto count = std::size_t(std::popcount(_mask));
+		for (std::size_t index = 0; index < count; ++index)
+		{
+			_states[index]->update(timeStamp, utils::eh::unexpected(error));
+		}
+		return error;
+	}
+
+	return {};
+}
+
+auto PackedInputWord::doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	/// @todo read the word at _address using a Transport::Batch on lease.handle().transport(), decoding the value directly
+	/// from batch.response(), and fill in the sample time provided by the device and/or the receive time provided by the
+	/// transport, if available. If the response contains an error, throw an std::system_error.
+	Word word = {};
+	SampleClock::ResponseTimes responseTimes;
+
+	// All the bits were sampled together, so they all get the same time stamp.
+	const auto sampleTime = lease.session().sampleClock().timeStamp(timeStamp, responseTimes);
+
+	// Gather the used bits into the low bits, so that bit n belongs to the state at index n
+	const auto bits = extractBits(word, _mask);
+	const auto count = std::size_t(std::popcount(_mask));
+	for (std::size_t index = 0; index < count; ++index)
+	{
+		_states[index]->update(sampleTime, ((bits >> index) & 1) != 0);
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,85 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "ReadState.hpp"
+#include "Session.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <system_error>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A word on the device containing packed boolean inputs.
+///
+/// Devices usually expose digital inputs as the individual bits of a word. All the inputs that refer to bits of the same
+/// word share a single packed word object, which reads the word once per cycle and commits the value of each bit to the
+/// states of all the inputs together. The read tasks of the other inputs find that the word has already been read for
+/// the current cycle, and do nothing.
+///
+/// The objects are allocated in the arena of the I/O component when the configuration is loaded.
+class PackedInputWord final
+{
+public:
+	/// @brief The type of the word
+	/// @todo change this to the word size used by the device
+	using Word = std::uint16_t;
+
+	/// @brief The number of bits in a word
+	static constexpr std::size_t kBitsPerWord = std::numeric_limits<Word>::digits;
+
+	/// @brief Constructor
+	/// @param address The address of the word on the device
+	explicit PackedInputWord(std::uint64_t address) noexcept : _address(address)
+	{
+	}
+
+	/// @brief Returns the address of the word
+	auto address() const noexcept -> std::uint64_t
+	{
+		return _address;
+	}
+
+	/// @brief Attaches the state of an input to a bit of the word.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param bit The index of the bit, starting with the least significant bit at 0. This must be less than kBitsPerWord.
+	/// @param state The state to update with the value of the bit
+	/// @return true on success, or false if another input already uses the bit
+	auto attach(std::size_t bit, ReadState<bool> &state) noexcept -> bool;
+
+	/// @brief Reads the word and updates the states of all the attached inputs, unless the word was already read for the
+	/// same scheduled time.
+	/// @param lease A lease on the session to use
+	/// @param timeStamp The scheduled time of the read task
+	/// @return The error if the read failed, or a default constructed std::error_code object on success, or if the word was
+	/// already read. The states have been updated with the error already, but the caller must notify its error sink.
+	auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> std::error_code;
+
+private:
+	/// @brief The actual implementation of read(), which may throw exceptions on error.
+	auto doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief The address of the word
+	std::uint64_t _address;
+
+	/// @brief The bits that have inputs attached
+	Word _mask { 0 };
+	/// @brief The states of the attached inputs, ordered by bit.
+	///
+	/// The first std::popcount(_mask) entries are used. The entry at index *n* belongs to the *n*th set bit of _mask, so the
+	/// values can be gathered from the word using extractBits().
+	std::array<ReadState<bool> *, kBitsPerWord> _states {};
+
+	/// @brief A mutex that serializes reads from different read tasks
+	std::mutex _mutex;
+	/// @brief The scheduled time of the last read. This may only be accessed while holding _mutex.
+	std::chrono::system_clock::time_point _lastRead { std::chrono::system_clock::time_point::min() };
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
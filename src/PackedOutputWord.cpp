@@ -0,0 +1,144 @@
+// Copyright (c) embedded ocean GmbH
+#include "PackedOutputWord.hpp"
+
+#include "PackedBitOutputHandler.hpp"
+#include "RateLimiter.hpp"
+
+#include <xentara/utils/eh/currentErrorCode.hpp>
+
+#include <bit>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+auto PackedOutputWord::attach(std::size_t bit, PackedBitOutputHandler &handler) noexcept -> bool
+{
+	// Each bit can only be used once
+	if (_handlers[bit])
+	{
+		return false;
+	}
+
+	_handlers[bit] = &handler;
+	return true;
+}
+
+auto PackedOutputWord::schedule(std::size_t bit, bool value) noexcept -> void
+{
+	// Add the bit to one of the masks, and remove it from the other, so that the last value scheduled wins
+	const auto setBit = Changes(1) << bit;
+	const auto clearBit = setBit << kBitsPerWord;
+	const auto add = value ? setBit : clearBit;
+	const auto remove = value ? clearBit : setBit;
+
+	// Update both masks together, so that a writer never sees a bit in both masks
+	auto changes = _pendingChanges.load(std::memory_order_relaxed);
+	while (!_pendingChanges.compare_exchange_weak(changes, (changes & ~remove) | add, std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+	// Make sure the changes get written
+	_writeLane.get().push(*this);
+}
+
+auto PackedOutputWord::write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Only one thread may write at a time, or a read-modify-write cycle might overwrite the result of another one. If another
+	// thread is busy writing, we leave our request to it, so that it writes our changes once it is done. Handing the word back
+	// to the write lane instead would make the write dispatcher spin until the other thread is finished.
+	if (_writeRequests.fetch_add(1, std::memory_order_acq_rel) != 0)
+	{
+		return;
+	}
+
+	// Write the changes, and make another pass if other threads have made requests in the meantime. A single pass handles any
+	// number of requests, because it takes all the changes that are pending.
+	for (std::size_t handled = 1;; )
+	{
+		writePendingChanges(lease, timeStamp);
+
+		const auto remaining = _writeRequests.fetch_sub(handled, std::memory_order_acq_rel) - handled;
+		if (remaining == 0)
+		{
+			break;
+		}
+		handled = remaining;
+	}
+}
+
+auto PackedOutputWord::writePendingChanges(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Nothing to do if there are no pending changes. Only we take changes away, so they cannot disappear after this check.
+	if (_pendingChanges.load(std::memory_order_relaxed) == 0)
+	{
+		return;
+	}
+
+	// Respect the rate limit of the device, which must allow the read and the write. If the device supports masked writes, only a
+	// single request is needed instead. We never wait for the limit, because that would hold up the calling thread. Instead, we
+	// leave the changes pending, and put the word back into the write lane, which retries it once the limit allows.
+	auto &rateLimiter = lease.session().rateLimiter();
+	if (!rateLimiter.tryAcquire(2))
+	{
+		_writeLane.get().defer(*this, rateLimiter.delay(2));
+		return;
+	}
+
+	// Take all the pending changes at once. Changes scheduled from now on are left for the next write.
+	const auto changes = _pendingChanges.exchange(0, std::memory_order_acquire);
+	const auto set = Word(changes);
+	const auto clear = Word(changes >> kBitsPerWord);
+
+	std::error_code error;
+	try
+	{
+		// Call the other write function, but catch exceptions.
+		doWrite(lease, set, clear);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		error = utils::eh::currentErrorCode();
+	}
+
+	// Update the write states of all the outputs that were written
+	PackedBitOutputHandler *first = nullptr;
+	for (auto written = Word(set | clear); written != 0; written &= Word(written - 1))
+	{
+		auto handler = _handlers[std::countr_zero(written)];
+		handler->written(timeStamp, error);
+		if (!first)
+		{
+			first = handler;
+		}
+	}
+
+	// Notify the error sink of one of the outputs. It will notify the I/O component.
+	if (error && first)
+	{
+		first->errorSink().handleWriteError(lease, timeStamp, error);
+	}
+}
+
+auto PackedOutputWord::doWrite(const Session::Lease &lease, Word set, Word clear) -> void
+{
+	/// @todo if the device supports writing a word using an AND mask and an OR mask (like Modbus function code 22), encode
+	/// a single masked write request into the buffer returned by batch.queue() of a Transport::Batch on
+	/// lease.handle().transport() instead, using Word(~clear) as the AND mask and set as the OR mask, and return.
+
+	/// @todo read the current value of the word at address() using a Transport::Batch on lease.handle().transport(), and
+	/// decode it directly from batch.response(). If the response contains an error, throw an std::system_error.
+	//
+	// The read and the write can also be written as a coroutine returning Transaction<>, using co_await
+	// lease.session().reactor().exchange() for each step. See TemplateOutputHandler::doWrite() for details.
+	Word word = {};
+
+	// Apply the changes. All the other bits keep the value read from the device.
+	word = Word((word & Word(~clear)) | set);
+
+	/// @todo write the word back to address(). If the response contains an error, throw an std::system_error.
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,122 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "PackedInputWord.hpp"
+#include "Session.hpp"
+#include "WriteLane.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace xentara::plugins::templateDriver
+{
+
+class PackedBitOutputHandler;
+
+/// @brief A word on the device containing packed boolean outputs.
+///
+/// All the outputs that refer to bits of the same word share a single packed word object. Scheduling a value for an output
+/// only records the change in a pair of set and clear masks, and adds the word to the write lane of the I/O component. When
+/// the word is written, all the changes recorded since the last write are applied together using a single masked
+/// read-modify-write of the word. Changes recorded while a write is in progress are left for the next write, so concurrent
+/// changes to different bits never clobber each other.
+///
+/// The objects are allocated in the arena of the I/O component when the configuration is loaded.
+class PackedOutputWord final : public WriteLane::Entry
+{
+public:
+	/// @brief The type of the word
+	using Word = PackedInputWord::Word;
+
+	/// @brief The number of bits in a word
+	static constexpr std::size_t kBitsPerWord = PackedInputWord::kBitsPerWord;
+
+	/// @brief Constructor
+	/// @param address The address of the word on the device
+	/// @param writeLane The write lane of the I/O component
+	PackedOutputWord(std::uint64_t address, WriteLane &writeLane) noexcept : _readBack(address), _writeLane(writeLane)
+	{
+	}
+
+	/// @brief Returns the address of the word
+	auto address() const noexcept -> std::uint64_t
+	{
+		return _readBack.address();
+	}
+
+	/// @brief Attaches an output to a bit of the word.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param bit The index of the bit, starting with the least significant bit at 0. This must be less than kBitsPerWord.
+	/// @param handler The handler of the output
+	/// @return true on success, or false if another output already uses the bit
+	auto attach(std::size_t bit, PackedBitOutputHandler &handler) noexcept -> bool;
+
+	/// @brief Returns the word used to read back the values of the outputs
+	auto readBack() noexcept -> PackedInputWord &
+	{
+		return _readBack;
+	}
+
+	/// @brief Schedules a new value for a bit.
+	///
+	/// This function is thread-safe and lock-free. The value is written by the next pass of the write lane of the I/O
+	/// component, or the next "write" task of one of the outputs, whichever comes first.
+	/// @param bit The index of the bit
+	/// @param value The new value of the bit
+	auto schedule(std::size_t bit, bool value) noexcept -> void;
+
+	/// @brief Writes all the pending changes using a single masked write, and updates the write states of the changed outputs
+	/// @param lease A lease on the session to use
+	/// @param timeStamp The time stamp to use for the write
+	auto write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @name Virtual Overrides for WriteLane::Entry
+	/// @{
+
+	auto performPendingWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void final
+	{
+		write(lease, timeStamp);
+	}
+
+	/// @}
+
+private:
+	/// @brief The type used to store the pending changes. The set mask is stored in the low bits, and the clear mask above it.
+	using Changes = std::uint64_t;
+
+	// Make sure both masks fit into a single atomic value
+	static_assert(2 * kBitsPerWord <= sizeof(Changes) * 8, "word is too large to store both masks in a single atomic value");
+
+	/// @brief Writes the changes that are pending right now, and updates the write states of the changed outputs
+	auto writePendingChanges(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief The actual implementation of writePendingChanges(), which may throw exceptions on error.
+	/// @param set The bits to set
+	/// @param clear The bits to clear
+	auto doWrite(const Session::Lease &lease, Word set, Word clear) -> void;
+
+	/// @brief The word used to read back the values of the outputs
+	PackedInputWord _readBack;
+
+	/// @brief The handlers of the attached outputs, by bit
+	std::array<PackedBitOutputHandler *, kBitsPerWord> _handlers {};
+
+	/// @brief The pending changes
+	std::atomic<Changes> _pendingChanges { 0 };
+
+	/// @brief The write lane of the I/O component
+	std::reference_wrapper<WriteLane> _writeLane;
+
+	/// @brief The number of requests to write the pending changes that have not been handled yet.
+	///
+	/// The thread that raises this from zero does the writing, and keeps writing until all the requests made in the meantime by
+	/// other threads have been handled.
+	std::atomic<std::size_t> _writeRequests { 0 };
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,248 @@
+// Copyright (c) embedded ocean GmbH
+#include "PointRange.hpp"
+
+#include "TemplateInputHandler.hpp"
+#include "Trace.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/memory/memoryResources.hpp>
+#include <xentara/memory/WriteSentinel.hpp>
+#include <xentara/utils/eh/currentErrorCode.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace xentara::plugins::templateDriver
+{
+	
+using namespace std::literals;
+
+template <typename ValueType>
+auto PointRange<ValueType>::dataType(std::size_t /*index*/) const -> const data::DataType &
+{
+	// The points have the same data type as a corresponding individual input
+	return TemplateInputHandler<ValueType>::kValueAttribute.dataType();
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::pointReadHandle(std::size_t index, Field field) const noexcept -> data::ReadHandle
+{
+	switch (field)
+	{
+	case Field::Value:
+	default:
+		return _dataBlock.member(index, &State::_value);
+	case Field::Quality:
+		return _dataBlock.member(index, &State::_quality);
+	case Field::Error:
+		return _dataBlock.member(index, &State::_error);
+	case Field::UpdateTime:
+		return _dataBlock.member(index, &State::_updateTime);
+	case Field::ChangeTime:
+		return _dataBlock.member(index, &State::_changeTime);
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::realize() -> void
+{
+	// Create the data block
+	_dataBlock.create(memory::memoryResources::data(), _layout._count);
+
+	// Restore the last known values, if there are any
+	if constexpr (SnapshotValueType<ValueType>)
+	{
+		if (!_snapshot)
+		{
+			return;
+		}
+
+		memory::WriteSentinel sentinel { _dataBlock };
+		const auto &oldStates = sentinel.oldValue();
+		std::optional<std::chrono::system_clock::time_point> lastUpdate;
+		for (std::size_t index = 0; index < _layout._count; ++index)
+		{
+			// Points without a stored value keep their initial state. We must still write them, because memory resources use swap-in.
+			const auto sample = _snapshot->restore(_firstSnapshotSlot + index);
+			if (!sample)
+			{
+				sentinel[index] = oldStates[index];
+				continue;
+			}
+
+			sentinel[index].restore(*sample);
+			lastUpdate = std::max(lastUpdate.value_or(sample->_updateTime), sample->_updateTime);
+		}
+
+		// Commit the data if anything was restored
+		if (lastUpdate)
+		{
+			sentinel.commit(*lastUpdate);
+		}
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::enableSnapshot(Snapshot &snapshot) -> void
+{
+	if constexpr (SnapshotValueType<ValueType>)
+	{
+		// The slots are assigned consecutively, so we only need to remember the first one
+		_snapshot = &snapshot;
+		_firstSnapshotSlot = snapshot.attach<ValueType>();
+		for (std::size_t index = 1; index < _layout._count; ++index)
+		{
+			snapshot.attach<ValueType>();
+		}
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::enableStaleness(Arena &arena, StalenessIndex &index) -> void
+{
+	_stalenessEntry = &arena.make<StalenessEntry>(*this);
+	index.attach(*_stalenessEntry, std::nullopt);
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::requestCount() const noexcept -> std::size_t
+{
+	/// @todo return the number of requests needed to read all the points, based on the maximum size of a response
+	return 1;
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::queueRead(Transport::Batch &batch) -> void
+{
+	// Remember where our requests start
+	_firstRequest = batch.size();
+
+	/// @todo add requestCount() requests to the batch. Encode each request directly into the buffer returned by batch.queue(),
+	/// which takes the size of the request and of the expected response. The address of each point can be gotten using address().
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::read(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+	AbstractTemplateInputHandler::ErrorSink &errorSink) -> void
+{
+	try
+	{
+		// Call the other read function, but catch exceptions.
+		doRead(lease, batch, timeStamp);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		const auto error = utils::eh::currentErrorCode();
+		// Update the states of all the points
+		updateState(timeStamp, error);
+		// Notify the error sink
+		errorSink.handleReadError(lease, timeStamp, error);
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	// Keep a concurrent sweep of the staleness index from marking the points as stale
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->beginUpdate();
+	}
+
+	// Update all the points using a single commit. The points do not raise individual events.
+	memory::WriteSentinel sentinel { _dataBlock };
+	const auto &oldStates = sentinel.oldValue();
+	for (std::size_t index = 0; index < _layout._count; ++index)
+	{
+		sentinel[index].update(oldStates[index], timeStamp, utils::eh::unexpected(error));
+	}
+	sentinel.commit(timeStamp);
+
+	// Stop tracking the age of the values, since there are none
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->remove();
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::doRead(const Session::Lease &lease, const Transport::Batch & /*batch*/,
+	std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// All the points of the range were sampled together, so they all get the same time stamp.
+	/// @todo fill in the sample time provided by the device and/or the receive time provided by the transport, if available.
+	SampleClock::ResponseTimes responseTimes;
+	const auto sampleTime = lease.session().sampleClock().timeStamp(timeStamp, responseTimes);
+
+	// Keep a concurrent sweep of the staleness index from marking the new values as stale
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->beginUpdate();
+	}
+
+	// Decode the values straight into the data block, so that the whole range is updated using a single commit
+	memory::WriteSentinel sentinel { _dataBlock };
+	const auto &oldStates = sentinel.oldValue();
+
+	/// @todo decode the values directly from the responses, which can be gotten using batch.response(_firstRequest + n).
+	/// If a response contains an error, throw an std::system_error.
+	for (std::size_t index = 0; index < _layout._count; ++index)
+	{
+		ValueType value = {};
+
+		auto &state = sentinel[index];
+		state.update(oldStates[index], sampleTime, value);
+
+		// Store the value in the snapshot. If a later response contains an error, the value is still the last one known.
+		if constexpr (SnapshotValueType<ValueType>)
+		{
+			if (_snapshot)
+			{
+				_snapshot->store(_firstSnapshotSlot + index, sampleTime, state._changeTime, Snapshot::toBits(value));
+			}
+		}
+	}
+
+	// Commit the data
+	{
+		Trace::Span span { "commit", "commit" };
+		sentinel.commit(sampleTime);
+	}
+
+	// Restart the age of the values
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->refresh();
+	}
+}
+
+template <typename ValueType>
+auto PointRange<ValueType>::expire(std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Mark all the points as stale using a single commit
+	memory::WriteSentinel sentinel { _dataBlock };
+	const auto &oldStates = sentinel.oldValue();
+	for (std::size_t index = 0; index < _layout._count; ++index)
+	{
+		sentinel[index].expire(oldStates[index], timeStamp);
+	}
+	sentinel.commit(timeStamp);
+}
+
+/// @class xentara::plugins::templateDriver::PointRange
+/// @todo change list of template instantiations to the supported types
+template class PointRange<bool>;
+template class PointRange<std::uint8_t>;
+template class PointRange<std::uint16_t>;
+template class PointRange<std::uint32_t>;
+template class PointRange<std::uint64_t>;
+template class PointRange<std::int8_t>;
+template class PointRange<std::int16_t>;
+template class PointRange<std::int32_t>;
+template class PointRange<std::int64_t>;
+template class PointRange<float>;
+template class PointRange<double>;
+template class PointRange<std::string>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,129 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "AbstractPointRange.hpp"
+#include "Arena.hpp"
+#include "PointState.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
+
+#include <xentara/memory/Array.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief A range of equally spaced inputs of a specific data type.
+///
+/// The states of all the points are stored as a single array data block, so that reading the range or invalidating it on
+/// disconnect takes a single commit, no matter how many points the range has.
+/// @todo rename this class to something more descriptive
+template <typename ValueType>
+class PointRange final : public AbstractPointRange
+{
+public:
+	/// @brief Constructor that sets the layout
+	/// @param layout The layout of the range
+	explicit PointRange(Layout layout) : AbstractPointRange(std::move(layout))
+	{
+	}
+
+	/// @name Virtual Overrides for AbstractPointRange
+	/// @{
+
+	auto dataType(std::size_t index) const -> const data::DataType & final;
+
+	auto realize() -> void final;
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final;
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index) -> void final;
+
+	auto requestCount() const noexcept -> std::size_t final;
+
+	auto queueRead(Transport::Batch &batch) -> void final;
+
+	auto read(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		AbstractTemplateInputHandler::ErrorSink &errorSink) -> void final;
+
+	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+
+	/// @}
+
+protected:
+	/// @name Virtual Overrides for AbstractPointRange
+	/// @{
+
+	auto pointReadHandle(std::size_t index, Field field) const noexcept -> data::ReadHandle final;
+
+	/// @}
+
+private:
+	/// @brief The state of a single point
+	using State = PointState<ValueType>;
+
+	/// @brief The entry of the range in the staleness index
+	class StalenessEntry final : public StalenessIndex::Entry
+	{
+	public:
+		/// @brief Constructor
+		explicit StalenessEntry(PointRange &range) noexcept : _range(range)
+		{
+		}
+
+	private:
+		/// @copydoc StalenessIndex::Entry::expire()
+		auto expire(std::chrono::system_clock::time_point timeStamp) -> void final
+		{
+			_range.get().expire(timeStamp);
+		}
+
+		/// @brief The range
+		std::reference_wrapper<PointRange> _range;
+	};
+
+	/// @brief The actual implementation of read(), which may throw exceptions on error.
+	auto doRead(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief Marks the values of all the points as stale because they have not been updated for longer than their maximum age
+	/// @param timeStamp The time stamp to use for the change
+	auto expire(std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief The data block that contains the states of all the points, in address order
+	memory::Array<State> _dataBlock;
+
+	/// @brief The snapshot the last known values are stored in, or nullptr if there is none
+	Snapshot *_snapshot { nullptr };
+	/// @brief The index of the slot of the first point in the snapshot. The other points use the slots that follow.
+	std::size_t _firstSnapshotSlot { 0 };
+
+	/// @brief The entry in the staleness index, or nullptr if the points have no maximum age. All the points are read together,
+	/// so they share a single entry. The entry is allocated in the arena of the I/O component.
+	StalenessEntry *_stalenessEntry { nullptr };
+
+	/// @brief The index of the first request added to the current batch by queueRead()
+	std::size_t _firstRequest { 0 };
+};
+
+/// @class xentara::plugins::templateDriver::PointRange
+/// @todo change list of extern template statements to the supported types
+extern template class PointRange<bool>;
+extern template class PointRange<std::uint8_t>;
+extern template class PointRange<std::uint16_t>;
+extern template class PointRange<std::uint32_t>;
+extern template class PointRange<std::uint64_t>;
+extern template class PointRange<std::int8_t>;
+extern template class PointRange<std::int16_t>;
+extern template class PointRange<std::int32_t>;
+extern template class PointRange<std::int64_t>;
+extern template class PointRange<float>;
+extern template class PointRange<double>;
+extern template class PointRange<std::string>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,131 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "CustomError.hpp"
+#include "Snapshot.hpp"
+
+#include <xentara/data/Quality.hpp>
+#include <xentara/utils/eh/expected.hpp>
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief The state of a single point of a point range, as stored in the data block of the range.
+///
+/// All the points of a range are stored in a single data block, so that the whole range can be updated using a single commit.
+/// @tparam DataType The data type of the value
+/// @tparam kIndex
+/// @parblock
+/// The index of the point. This is only used to give the registers of a device profile distinct types, so that they can be
+/// used as base classes of the same data block (see PointStates).
+/// @endparblock
+template <std::regular DataType, std::size_t kIndex = 0>
+struct PointState
+{
+	/// @brief The update time stamp
+	std::chrono::system_clock::time_point _updateTime { std::chrono::system_clock::time_point::min() };
+	/// @brief The current value
+	DataType _value {};
+	/// @brief The change time stamp
+	std::chrono::system_clock::time_point _changeTime { std::chrono::system_clock::time_point::min() };
+	/// @brief The quality of the value
+	data::Quality _quality { data::Quality::Bad };
+	/// @brief The error code when reading the value, or a default constructed std::error_code object for none.
+	std::error_code _error { CustomError::NotConnected };
+
+	/// @brief Sets a new value or an error.
+	///
+	/// All the fields are written, because memory resources use swap-in. Errors leave a value restored from the snapshot unchanged.
+	/// @param oldState The state of the point before the update
+	/// @param timeStamp The update time stamp
+	/// @param valueOrError The new value, or the read error
+	auto update(const PointState &oldState, std::chrono::system_clock::time_point timeStamp,
+		const utils::eh::expected<DataType, std::error_code> &valueOrError) -> void
+	{
+		// A value restored from the snapshot is kept until the first value is actually read, because errors only apply to
+		// values that came from a live read
+		if (!valueOrError && oldState._error == CustomError::LastKnownValue)
+		{
+			*this = oldState;
+			return;
+		}
+
+		_updateTime = timeStamp;
+
+		// See if we have a value
+		if (valueOrError)
+		{
+			_value = *valueOrError;
+			_quality = data::Quality::Good;
+			_error = {};
+		}
+		// We don't have a value, but an error
+		else
+		{
+			_value = {};
+			_quality = data::Quality::Bad;
+			_error = valueOrError.error();
+		}
+
+		// Update the change time, if necessary
+		const auto changed = _value != oldState._value || _quality != oldState._quality || _error != oldState._error;
+		_changeTime = changed ? timeStamp : oldState._changeTime;
+	}
+
+	/// @brief Keeps the last value, but marks it as stale because it has not been updated for longer than its maximum age
+	/// @param oldState The state of the point before the update
+	/// @param timeStamp The time stamp to use for the change
+	auto expire(const PointState &oldState, std::chrono::system_clock::time_point timeStamp) -> void
+	{
+		_updateTime = oldState._updateTime;
+		_value = oldState._value;
+		_changeTime = timeStamp;
+		_quality = data::Quality::Unreliable;
+		_error = CustomError::Stale;
+	}
+
+	/// @brief Restores the last known value from a snapshot.
+	///
+	/// The value keeps its original time stamps, but its quality is set to *Unreliable*, because it has not been confirmed by the
+	/// device yet.
+	/// @param sample The sample read from the snapshot
+	auto restore(const Snapshot::Sample &sample) -> void
+		requires SnapshotValueType<DataType>
+	{
+		_updateTime = sample._updateTime;
+		_value = Snapshot::fromBits<DataType>(sample._bits);
+		_changeTime = sample._changeTime;
+		_quality = data::Quality::Unreliable;
+		_error = CustomError::LastKnownValue;
+	}
+};
+
+/// @brief Helper class for PointStates
+template <typename Indices, typename... DataTypes>
+struct PointStateSet;
+
+/// @brief Helper class for PointStates
+template <std::size_t... kIndices, typename... DataTypes>
+struct PointStateSet<std::index_sequence<kIndices...>, DataTypes...> final : PointState<DataTypes, kIndices>...
+{
+};
+
+/// @brief The states of a number of points of different data types, as stored in the data block of a device profile range.
+///
+/// The state of each point is a separate base class, so a pointer to a member of a point can be converted to a pointer to a member
+/// of the whole structure, which can then be used to create a read handle.
+template <typename... DataTypes>
+using PointStates = PointStateSet<std::index_sequence_for<DataTypes...>, DataTypes...>;
+
+/// @brief The type of the state of a single point in PointStates
+template <std::size_t kIndex, typename... DataTypes>
+using PointStateAt = PointState<std::tuple_element_t<kIndex, std::tuple<DataTypes...>>, kIndex>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,226 @@
+// Copyright (c) embedded ocean GmbH
+#include "ProfileRange.hpp"
+
+#include "TemplateInputHandler.hpp"
+#include "Trace.hpp"
+
+#include <xentara/data/DataType.hpp>
+#include <xentara/memory/memoryResources.hpp>
+#include <xentara/memory/WriteSentinel.hpp>
+#include <xentara/utils/eh/currentErrorCode.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::name(std::size_t index) const -> std::string
+{
+	// Replace the placeholder with the name of the register. The pattern was checked to contain the placeholder when it was loaded.
+	static constexpr auto kRegisterNames = kProfile.registerNames();
+	auto name = _layout._namePattern;
+	if (const auto placeholder = name.find("{}"sv); placeholder != std::string::npos)
+	{
+		name.replace(placeholder, 2, kRegisterNames[index]);
+	}
+
+	return name;
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::dataType(std::size_t index) const -> const data::DataType &
+{
+	// The points have the same data type as a corresponding individual input
+	const data::DataType *dataType = nullptr;
+	[&]<std::size_t... kIndices>(std::index_sequence<kIndices...>) {
+		((index == kIndices ? dataType = &TemplateInputHandler<std::tuple_element_t<kIndices, typename Profile::Values>>::kValueAttribute.dataType()
+							: dataType),
+			...);
+	}(std::make_index_sequence<Profile::kRegisterCount>());
+
+	return *dataType;
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::pointReadHandle(std::size_t index, Field field) const noexcept -> data::ReadHandle
+{
+	// Select the register with the correct index
+	std::optional<data::ReadHandle> handle;
+	[&]<std::size_t... kIndices>(std::index_sequence<kIndices...>) {
+		((index == kIndices ? void(handle.emplace(registerReadHandle<kIndices>(field))) : void()), ...);
+	}(std::make_index_sequence<Profile::kRegisterCount>());
+
+	return *handle;
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::realize() -> void
+{
+	// Create the data block
+	_dataBlock.create(memory::memoryResources::data());
+
+	// Restore the last known values, if there are any
+	if (!_snapshot)
+	{
+		return;
+	}
+
+	memory::WriteSentinel sentinel { _dataBlock };
+	std::optional<std::chrono::system_clock::time_point> lastUpdate;
+	forEachRegister(*sentinel, sentinel.oldValue(), [&](auto index, auto &state, const auto &oldState) {
+		// Registers without a stored value keep their initial state. We must still write them, because memory resources use swap-in.
+		const auto sample = _snapshot->restore(_firstSnapshotSlot + index());
+		if (!sample)
+		{
+			state = oldState;
+			return;
+		}
+
+		state.restore(*sample);
+		lastUpdate = std::max(lastUpdate.value_or(sample->_updateTime), sample->_updateTime);
+	});
+
+	// Commit the data if anything was restored
+	if (lastUpdate)
+	{
+		sentinel.commit(*lastUpdate);
+	}
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::enableSnapshot(Snapshot &snapshot) -> void
+{
+	// The slots are assigned consecutively, so we only need to remember the first one
+	_snapshot = &snapshot;
+	_firstSnapshotSlot = [&]<std::size_t... kIndices>(std::index_sequence<kIndices...>) {
+		return std::min({ snapshot.attach<std::tuple_element_t<kIndices, typename Profile::Values>>()... });
+	}(std::make_index_sequence<Profile::kRegisterCount>());
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::enableStaleness(Arena &arena, StalenessIndex &index) -> void
+{
+	_stalenessEntry = &arena.make<StalenessEntry>(*this);
+	index.attach(*_stalenessEntry, std::nullopt);
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::queueRead(Transport::Batch &batch) -> void
+{
+	// Remember the index of our request
+	_request = batch.size();
+
+	/// @todo encode a request for Profile::kBlockSize bytes starting at _layout._baseAddress into the buffer returned by batch.queue()
+	[[maybe_unused]] auto request = batch.queue(0, Profile::kBlockSize);
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::read(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+	AbstractTemplateInputHandler::ErrorSink &errorSink) -> void
+{
+	try
+	{
+		// Call the other read function, but catch exceptions.
+		doRead(lease, batch, timeStamp);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		const auto error = utils::eh::currentErrorCode();
+		// Update the states of all the points
+		updateState(timeStamp, error);
+		// Notify the error sink
+		errorSink.handleReadError(lease, timeStamp, error);
+	}
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	// Keep a concurrent sweep of the staleness index from marking the registers as stale
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->beginUpdate();
+	}
+
+	// Update all the registers using a single commit. The registers do not raise individual events.
+	memory::WriteSentinel sentinel { _dataBlock };
+	forEachRegister(*sentinel, sentinel.oldValue(), [&](auto, auto &state, const auto &oldState) {
+		state.update(oldState, timeStamp, utils::eh::unexpected(error));
+	});
+	sentinel.commit(timeStamp);
+
+	// Stop tracking the age of the values, since there are none
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->remove();
+	}
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::doRead(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp)
+	-> void
+{
+	// All the registers of the block were sampled together, so they all get the same time stamp.
+	/// @todo fill in the sample time provided by the device and/or the receive time provided by the transport, if available.
+	SampleClock::ResponseTimes responseTimes;
+	const auto sampleTime = lease.session().sampleClock().timeStamp(timeStamp, responseTimes);
+
+	/// @todo check the response for errors, and throw an std::system_error if it contains one. If the registers do not start
+	/// at the beginning of the response, skip the header.
+	const auto response = batch.response(_request);
+
+	// Keep a concurrent sweep of the staleness index from marking the new values as stale
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->beginUpdate();
+	}
+
+	// Decode all the registers straight from the response buffer into the data block
+	memory::WriteSentinel sentinel { _dataBlock };
+	auto &states = *sentinel;
+	const auto &oldStates = sentinel.oldValue();
+	Profile::decode(response.data(), [&](auto index, auto value) {
+		auto &state = static_cast<typename Profile::template State<index()> &>(states);
+		state.update(static_cast<const typename Profile::template State<index()> &>(oldStates), sampleTime, value);
+
+		// Store the value in the snapshot
+		if (_snapshot)
+		{
+			_snapshot->store(_firstSnapshotSlot + index(), sampleTime, state._changeTime, Snapshot::toBits(value));
+		}
+	});
+
+	// Commit the data
+	{
+		Trace::Span span { "commit", "commit" };
+		sentinel.commit(sampleTime);
+	}
+
+	// Restart the age of the values
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->refresh();
+	}
+}
+
+template <const auto &kProfile>
+auto ProfileRange<kProfile>::expire(std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Mark all the registers as stale using a single commit
+	memory::WriteSentinel sentinel { _dataBlock };
+	forEachRegister(*sentinel, sentinel.oldValue(), [&](auto, auto &state, const auto &oldState) { state.expire(oldState, timeStamp); });
+	sentinel.commit(timeStamp);
+}
+
+/// @class xentara::plugins::templateDriver::ProfileRange
+/// @todo change list of template instantiations to the supported device profiles
+template class ProfileRange<kExamplePowerMeter>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
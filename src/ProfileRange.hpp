@@ -0,0 +1,174 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "AbstractPointRange.hpp"
+#include "DeviceProfiles.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
+#include "Transport.hpp"
+
+#include <xentara/memory/ObjectBlock.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A block of registers described by a compile-time device profile.
+///
+/// The whole block is read using a single request, and decoded using a decoder that is generated from the profile at compile
+/// time, so that the offset, type, and byte order of each register are fixed, and no runtime dispatch takes place. The states of
+/// all the registers are stored in a single data block, which is updated using a single commit.
+/// The name of each point is generated by replacing the placeholder "{}" in the name pattern with the name of the register.
+/// @tparam kProfile The device profile
+template <const auto &kProfile>
+class ProfileRange final : public AbstractPointRange
+{
+public:
+	/// @brief The type of the profile
+	using Profile = std::remove_cvref_t<decltype(kProfile)>;
+
+	// Make sure the block fits into a single response
+	static_assert(Profile::kBlockSize <= Transport::kBufferSize, "device profile does not fit into a single response");
+
+	/// @brief Constructor that sets the layout
+	/// @param layout The layout of the range. The count is set to the number of registers in the profile.
+	explicit ProfileRange(Layout layout) : AbstractPointRange(std::move(layout))
+	{
+		_layout._count = Profile::kRegisterCount;
+	}
+
+	/// @name Virtual Overrides for AbstractPointRange
+	/// @{
+
+	auto name(std::size_t index) const -> std::string final;
+
+	auto dataType(std::size_t index) const -> const data::DataType & final;
+
+	auto realize() -> void final;
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final;
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index) -> void final;
+
+	auto requestCount() const noexcept -> std::size_t final
+	{
+		return 1;
+	}
+
+	auto queueRead(Transport::Batch &batch) -> void final;
+
+	auto read(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		AbstractTemplateInputHandler::ErrorSink &errorSink) -> void final;
+
+	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+
+	/// @}
+
+protected:
+	/// @name Virtual Overrides for AbstractPointRange
+	/// @{
+
+	auto pointReadHandle(std::size_t index, Field field) const noexcept -> data::ReadHandle final;
+
+	/// @}
+
+private:
+	/// @brief The states of all the registers
+	using States = typename Profile::States;
+
+	/// @brief The entry of the range in the staleness index
+	class StalenessEntry final : public StalenessIndex::Entry
+	{
+	public:
+		/// @brief Constructor
+		explicit StalenessEntry(ProfileRange &range) noexcept : _range(range)
+		{
+		}
+
+	private:
+		/// @copydoc StalenessIndex::Entry::expire()
+		auto expire(std::chrono::system_clock::time_point timeStamp) -> void final
+		{
+			_range.get().expire(timeStamp);
+		}
+
+		/// @brief The range
+		std::reference_wrapper<ProfileRange> _range;
+	};
+
+	/// @brief Calls a function for the new and old state of each register inside a write sentinel
+	/// @param states The new states
+	/// @param oldStates The old states
+	/// @param function A function that is called with the index of each register as an std::integral_constant, its new state,
+	/// and its old state
+	template <typename Function>
+	static auto forEachRegister(States &states, const States &oldStates, Function &&function) -> void
+	{
+		[&]<std::size_t... kIndices>(std::index_sequence<kIndices...>) {
+			(function(std::integral_constant<std::size_t, kIndices>(),
+				 static_cast<typename Profile::template State<kIndices> &>(states),
+				 static_cast<const typename Profile::template State<kIndices> &>(oldStates)),
+				...);
+		}(std::make_index_sequence<Profile::kRegisterCount>());
+	}
+
+	/// @brief Creates a read handle for a field of a register
+	/// @tparam kIndex The index of the register
+	/// @param field The field
+	template <std::size_t kIndex>
+	auto registerReadHandle(Field field) const noexcept -> data::ReadHandle
+	{
+		// Convert the pointer to the member of the state of the register to a pointer to a member of the whole block
+		using State = typename Profile::template State<kIndex>;
+		const auto member = [&]<typename Member>(Member State::*pointer) { return _dataBlock.member(static_cast<Member States::*>(pointer)); };
+
+		switch (field)
+		{
+		case Field::Value:
+		default:
+			return member(&State::_value);
+		case Field::Quality:
+			return member(&State::_quality);
+		case Field::Error:
+			return member(&State::_error);
+		case Field::UpdateTime:
+			return member(&State::_updateTime);
+		case Field::ChangeTime:
+			return member(&State::_changeTime);
+		}
+	}
+
+	/// @brief The actual implementation of read(), which may throw exceptions on error.
+	auto doRead(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief Marks the values of all the registers as stale because they have not been updated for longer than their maximum age
+	/// @param timeStamp The time stamp to use for the change
+	auto expire(std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief The data block that contains the states of all the registers
+	memory::ObjectBlock<States> _dataBlock;
+
+	/// @brief The snapshot the last known values are stored in, or nullptr if there is none
+	Snapshot *_snapshot { nullptr };
+	/// @brief The index of the slot of the first register in the snapshot. The other registers use the slots that follow.
+	std::size_t _firstSnapshotSlot { 0 };
+
+	/// @brief The entry in the staleness index, or nullptr if the registers have no maximum age. The entry is allocated in the arena
+	/// of the I/O component.
+	StalenessEntry *_stalenessEntry { nullptr };
+
+	/// @brief The index of the request added to the current batch by queueRead()
+	std::size_t _request { 0 };
+};
+
+/// @class xentara::plugins::templateDriver::ProfileRange
+/// @todo change list of extern template statements to the supported device profiles
+extern template class ProfileRange<kExamplePowerMeter>;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
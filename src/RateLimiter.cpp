@@ -0,0 +1,203 @@
+// Copyright (c) embedded ocean GmbH
+#include "RateLimiter.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace xentara::plugins::templateDriver
+{
+
+namespace
+{
+
+	/// @brief Returns the current time as a count of clock ticks
+	auto now() noexcept -> RateLimiter::Clock::rep
+	{
+		return RateLimiter::Clock::now().time_since_epoch().count();
+	}
+
+	/// @brief The buckets of the shared links, by name
+	struct LinkRegistry final
+	{
+		/// @brief A mutex protecting the buckets
+		std::mutex _mutex;
+		/// @brief The buckets. Buckets that are no longer used by any I/O component expire automatically.
+		std::unordered_map<std::string, std::weak_ptr<RateLimiter::Bucket>> _buckets;
+	};
+
+	/// @brief Returns the registry of the shared links
+	auto linkRegistry() -> LinkRegistry &
+	{
+		static LinkRegistry registry;
+		return registry;
+	}
+
+} // namespace
+
+RateLimiter::Bucket::Bucket(const Options &options) noexcept :
+	_options(options),
+	_interval(std::max<Clock::rep>(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / options._requestsPerSecond)).count(), 1)),
+	_tolerance(_interval * Clock::rep(options._burst))
+{
+}
+
+auto RateLimiter::Bucket::tryTake(std::size_t count) noexcept -> bool
+{
+	const auto current = now();
+	const auto cost = _interval * Clock::rep(count);
+
+	auto fullTime = _fullTime.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		// The bucket holds enough tokens unless taking them would push the full time more than a full bucket ahead. If more
+		// tokens are requested than the bucket can hold, we let them through if the bucket is full, so they are not stuck forever.
+		const auto next = std::max(fullTime, current) + cost;
+		if (fullTime > current && next - current > _tolerance)
+		{
+			return false;
+		}
+
+		if (_fullTime.compare_exchange_weak(fullTime, next, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+}
+
+auto RateLimiter::Bucket::delay(std::size_t count) const noexcept -> Clock::duration
+{
+	const auto current = now();
+	const auto fullTime = _fullTime.load(std::memory_order_relaxed);
+	const auto next = std::max(fullTime, current) + _interval * Clock::rep(count);
+
+	// The tokens are available once the full time is no more than a full bucket ahead, or once the bucket is full, whichever
+	// comes first. This matches the condition used by tryTake().
+	return Clock::duration(std::max<Clock::rep>(std::min(fullTime, next - _tolerance) - current, 0));
+}
+
+auto RateLimiter::Bucket::giveBack(std::size_t count) noexcept -> void
+{
+	_fullTime.fetch_sub(_interval * Clock::rep(count), std::memory_order_relaxed);
+}
+
+auto RateLimiter::link(const std::string &name, const Options &options) -> std::shared_ptr<Bucket>
+{
+	auto &registry = linkRegistry();
+	std::scoped_lock lock { registry._mutex };
+
+	// Use the existing bucket, if any other I/O component is still using it
+	auto &entry = registry._buckets[name];
+	if (auto bucket = entry.lock())
+	{
+		// All the I/O components on the same link must agree on the limit
+		if (bucket->options() != options)
+		{
+			return nullptr;
+		}
+		return bucket;
+	}
+
+	// Create a new bucket
+	auto bucket = std::make_shared<Bucket>(options);
+	entry = bucket;
+	return bucket;
+}
+
+auto RateLimiter::limitDevice(const Options &options) -> void
+{
+	_device.emplace(options);
+	_enabled = true;
+}
+
+auto RateLimiter::limitLink(std::shared_ptr<Bucket> bucket) noexcept -> void
+{
+	_link = std::move(bucket);
+	_enabled = true;
+}
+
+auto RateLimiter::batchLimit() const noexcept -> std::size_t
+{
+	auto limit = std::numeric_limits<std::size_t>::max();
+	if (_device)
+	{
+		limit = std::min(limit, _device->options()._burst);
+	}
+	if (_link)
+	{
+		limit = std::min(limit, _link->options()._burst);
+	}
+	return limit;
+}
+
+auto RateLimiter::tryAcquireEnabled(std::size_t count) noexcept -> bool
+{
+	if (_device && !_device->tryTake(count))
+	{
+		return false;
+	}
+
+	// If the link does not allow the requests, put the tokens back into the bucket of the device, so they are not wasted
+	if (_link && !_link->tryTake(count))
+	{
+		if (_device)
+		{
+			_device->giveBack(count);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+auto RateLimiter::tryAcquireInTurnEnabled(std::size_t count, Ticket &ticket) noexcept -> bool
+{
+	const auto current = _currentTicket.load(std::memory_order_acquire);
+
+	// Without a ticket, we may only go ahead if no other data point is waiting. Otherwise, we join the queue.
+	if (!ticket)
+	{
+		if (current == _nextTicket.load(std::memory_order_relaxed) && tryAcquireEnabled(count))
+		{
+			return true;
+		}
+		ticket = _nextTicket.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// With a ticket, we must wait until it is our turn
+	if (*ticket != current || !tryAcquireEnabled(count))
+	{
+		return false;
+	}
+
+	// Let the next data point have its turn
+	ticket.reset();
+	_currentTicket.store(current + 1, std::memory_order_release);
+	return true;
+}
+
+auto RateLimiter::skipTurn(Ticket &ticket) noexcept -> void
+{
+	if (ticket && *ticket == _currentTicket.load(std::memory_order_acquire))
+	{
+		ticket.reset();
+		_currentTicket.fetch_add(1, std::memory_order_release);
+	}
+}
+
+auto RateLimiter::delay(std::size_t count) const noexcept -> Clock::duration
+{
+	auto delay = Clock::duration::zero();
+	if (_device)
+	{
+		delay = std::max(delay, _device->delay(count));
+	}
+	if (_link)
+	{
+		delay = std::max(delay, _link->delay(count));
+	}
+	return delay;
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,171 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Limits the rate of the requests sent to a device.
+///
+/// Requests are limited using token buckets. A bucket is refilled at a constant rate up to a maximum *burst* size, and
+/// each request takes one token out of the bucket. Each I/O component can have a bucket of its own, and can also share a
+/// bucket with other I/O components whose devices are connected via the same link, like a serial bus or a gateway.
+///
+/// The buckets are implemented using the generic cell rate algorithm, which tracks the time at which the bucket will be full
+/// again in a single atomic variable, so taking tokens is lock-free.
+class RateLimiter final : private utils::tools::Unique
+{
+public:
+	/// @brief The clock used for the buckets
+	using Clock = std::chrono::steady_clock;
+
+	/// @brief The place of a data point in the queue of data points waiting for the limit, or std::nullopt if it is not waiting
+	using Ticket = std::optional<std::uint64_t>;
+
+	/// @brief The configuration of a bucket
+	struct Options final
+	{
+		/// @brief The sustained number of requests per second
+		double _requestsPerSecond { 0 };
+		/// @brief The number of requests that may be sent back to back
+		std::size_t _burst { 1 };
+
+		/// @brief Default comparison operator
+		auto operator==(const Options &) const -> bool = default;
+	};
+
+	/// @brief A token bucket
+	class Bucket final : private utils::tools::Unique
+	{
+	public:
+		/// @brief Constructor. The bucket starts out full.
+		explicit Bucket(const Options &options) noexcept;
+
+		/// @brief Returns the configuration of the bucket
+		auto options() const noexcept -> const Options &
+		{
+			return _options;
+		}
+
+		/// @brief Takes tokens out of the bucket, if it holds enough of them.
+		///
+		/// If more tokens are requested than the bucket can hold at all, the tokens are only taken if the bucket is full.
+		/// @param count The number of tokens
+		/// @return true if the tokens were taken, or false if there are not enough tokens in the bucket
+		auto tryTake(std::size_t count) noexcept -> bool;
+
+		/// @brief Returns how long it will take until the bucket holds enough tokens, if no other tokens are taken in the meantime
+		/// @param count The number of tokens
+		auto delay(std::size_t count) const noexcept -> Clock::duration;
+
+		/// @brief Puts tokens back into the bucket that were taken, but not used
+		/// @param count The number of tokens
+		auto giveBack(std::size_t count) noexcept -> void;
+
+	private:
+		/// @brief The configuration
+		Options _options;
+		/// @brief The time it takes to refill a single token
+		Clock::rep _interval;
+		/// @brief The time it takes to refill the entire bucket
+		Clock::rep _tolerance;
+
+		/// @brief The time at which the bucket will be full again, if no more tokens are taken
+		std::atomic<Clock::rep> _fullTime { std::numeric_limits<Clock::rep>::min() };
+	};
+
+	/// @brief Returns the bucket for a shared link, creating it if necessary.
+	///
+	/// All the I/O components configured with the same link name share the same bucket for as long as any of them exists.
+	/// @param name The name of the link
+	/// @param options The configuration of the link
+	/// @return The bucket, or nullptr if the link already exists with a different configuration
+	static auto link(const std::string &name, const Options &options) -> std::shared_ptr<Bucket>;
+
+	/// @brief Limits the requests to the device
+	auto limitDevice(const Options &options) -> void;
+
+	/// @brief Limits the requests to the device using the bucket of a shared link, in addition to any limit on the device itself
+	auto limitLink(std::shared_ptr<Bucket> bucket) noexcept -> void;
+
+	/// @brief Checks whether any limit is configured
+	auto enabled() const noexcept -> bool
+	{
+		return _enabled;
+	}
+
+	/// @brief Returns the maximum number of requests that can be sent back to back, or the largest possible value if the requests
+	/// are not limited.
+	auto batchLimit() const noexcept -> std::size_t;
+
+	/// @brief Takes tokens for a number of requests, if all the buckets hold enough tokens.
+	/// @return true if the requests may be sent, or false if they must be skipped
+	auto tryAcquire(std::size_t count) noexcept -> bool
+	{
+		// Don't do anything if there is no limit
+		if (!_enabled)
+		{
+			return true;
+		}
+
+		return tryAcquireEnabled(count);
+	}
+
+	/// @brief Takes tokens for a number of requests in turn with other data points that were held back by the limit.
+	///
+	/// A data point that cannot send its requests draws a ticket. Once any data point is waiting, the tokens go to the holders of
+	/// the tickets in the order they were drawn, so that data points whose tasks happen to run last don't starve. A data point
+	/// that is not at the front of the queue skips its requests without waiting, so the calling thread is never blocked.
+	/// @param count The number of requests
+	/// @param ticket The ticket of the data point. This must be std::nullopt initially, and is managed by this function.
+	/// @return true if the requests may be sent, or false if they must be skipped
+	auto tryAcquireInTurn(std::size_t count, Ticket &ticket) noexcept -> bool
+	{
+		// Don't do anything if there is no limit
+		if (!_enabled)
+		{
+			return true;
+		}
+
+		return tryAcquireInTurnEnabled(count, ticket);
+	}
+
+	/// @brief Gives up the turn of a data point that will not send any requests this time, so that it does not hold up the others.
+	///
+	/// If the data point is not at the front of the queue yet, it keeps its place.
+	/// @param ticket The ticket of the data point
+	auto skipTurn(Ticket &ticket) noexcept -> void;
+
+	/// @brief Returns how long it will take until a number of requests can be sent, if no other requests are sent in the meantime
+	auto delay(std::size_t count) const noexcept -> Clock::duration;
+
+private:
+	/// @brief Implementation of tryAcquire() if there is a limit
+	auto tryAcquireEnabled(std::size_t count) noexcept -> bool;
+	/// @brief Implementation of tryAcquireInTurn() if there is a limit
+	auto tryAcquireInTurnEnabled(std::size_t count, Ticket &ticket) noexcept -> bool;
+
+	/// @brief The bucket for the device, if the device itself is limited
+	std::optional<Bucket> _device;
+	/// @brief The bucket for the link the device is connected by, if the link is limited
+	std::shared_ptr<Bucket> _link;
+	/// @brief Whether any limit is configured
+	bool _enabled { false };
+
+	/// @brief The number of tickets drawn so far, which is also the number of the next ticket
+	std::atomic<std::uint64_t> _nextTicket { 0 };
+	/// @brief The ticket at the front of the queue. The queue is empty if this is equal to _nextTicket.
+	std::atomic<std::uint64_t> _currentTicket { 0 };
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
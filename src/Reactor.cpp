@@ -0,0 +1,189 @@
+// Copyright (c) embedded ocean GmbH
+#include "Reactor.hpp"
+
+#include "CustomError.hpp"
+#include "Transport.hpp"
+
+#include <xentara/utils/eh/currentErrorCode.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+Reactor::Exchange::Exchange(Reactor &reactor, Transport *transport, std::span<const std::byte> request, std::span<std::byte> response) noexcept :
+	_reactor(reactor),
+	_transport(transport),
+	_request(request),
+	_response(response)
+{
+	// Check the parameters here, so that we need not suspend at all if they are invalid
+	if (!_transport)
+	{
+		_error = std::make_error_code(std::errc::not_connected);
+	}
+	else if (_request.size() > Transport::kBufferSize || _response.size() > Transport::kBufferSize)
+	{
+		_error = std::make_error_code(std::errc::message_size);
+	}
+}
+
+auto Reactor::Exchange::await_suspend(std::coroutine_handle<> continuation) noexcept -> void
+{
+	_continuation = continuation;
+
+	// Give up on the request if it cannot be sent in time, so that requests do not pile up behind a device that is not responding
+	_deadline.arm(TimingWheel::shared(), kQueueTimeout);
+
+	_reactor.push(*this);
+}
+
+auto Reactor::exchange(const Session::Lease &lease, std::span<const std::byte> request, std::span<std::byte> response) noexcept -> Exchange
+{
+	// Use the transport of the session, if it has one
+	const auto transport = lease && lease.handle() ? &lease.handle().transport() : nullptr;
+	return Exchange(*this, transport, request, response);
+}
+
+auto Reactor::start() -> void
+{
+	_thread = std::jthread([this](std::stop_token stopToken) { run(stopToken); });
+}
+
+auto Reactor::push(Exchange &exchange) noexcept -> void
+{
+	// Push the exchange onto the front of the list
+	auto head = _head.load(std::memory_order_relaxed);
+	do
+	{
+		exchange._next = head;
+	}
+	while (!_head.compare_exchange_weak(head, &exchange, std::memory_order_release, std::memory_order_relaxed));
+
+	// Wake up the reactor thread
+	_doorbell.fetch_add(1, std::memory_order_release);
+	_doorbell.notify_one();
+}
+
+auto Reactor::run(std::stop_token stopToken) -> void
+{
+	// Wake up the thread when it is asked to stop
+	std::stop_callback wakeUp(stopToken, [this]() {
+		_doorbell.fetch_add(1, std::memory_order_release);
+		_doorbell.notify_one();
+	});
+
+	for (std::uint32_t ring = 0; !stopToken.stop_requested();)
+	{
+		// Wait for exchanges to be queued
+		_doorbell.wait(ring, std::memory_order_acquire);
+		ring = _doorbell.load(std::memory_order_acquire);
+
+		// Take all the exchanges at once, and reverse them so they are sent in the order they were queued. Exchanges queued by
+		// the coroutines we resume will ring the doorbell again, so they are picked up in the next iteration.
+		auto exchanges = _head.exchange(nullptr, std::memory_order_acquire);
+		Exchange *ordered = nullptr;
+		while (exchanges)
+		{
+			auto next = std::exchange(exchanges->_next, ordered);
+			ordered = exchanges;
+			exchanges = next;
+		}
+
+		process(ordered);
+	}
+
+	// Fail any exchanges that are still waiting, so that their coroutines are not left suspended forever. The coroutines may
+	// queue further exchanges when they are resumed, so keep going until there are none left.
+	while (auto exchange = _head.exchange(nullptr, std::memory_order_acquire))
+	{
+		while (exchange)
+		{
+			auto &current = *exchange;
+			exchange = current._next;
+			current._error = std::make_error_code(std::errc::operation_canceled);
+			current._continuation.resume();
+		}
+	}
+}
+
+auto Reactor::process(Exchange *exchanges) noexcept -> void
+{
+	while (exchanges)
+	{
+		// Collect the exchanges for the transport of the first exchange into a batch. Requests that have waited too long are
+		// failed without being sent, and the rest are left for the next round.
+		auto &transport = *exchanges->_transport;
+		Exchange *batched = nullptr;
+		Exchange **batchedTail = &batched;
+		Exchange *expired = nullptr;
+		Exchange **expiredTail = &expired;
+		Exchange *remaining = nullptr;
+		Exchange **remainingTail = &remaining;
+		std::size_t batchSize = 0;
+		for (auto exchange = exchanges; exchange;)
+		{
+			auto &current = *exchange;
+			exchange = current._next;
+			current._next = nullptr;
+
+			current._deadline.disarm();
+			if (current._deadline.passed())
+			{
+				current._error = CustomError::Timeout;
+				*std::exchange(expiredTail, &current._next) = &current;
+			}
+			else if (current._transport == &transport && batchSize < Transport::kMaxBatchSize)
+			{
+				*std::exchange(batchedTail, &current._next) = &current;
+				++batchSize;
+			}
+			else
+			{
+				*std::exchange(remainingTail, &current._next) = &current;
+			}
+		}
+		exchanges = remaining;
+
+		// Send the batch. The batch must be destroyed before any coroutines are resumed, because it locks the transport.
+		if (batched)
+		{
+			try
+			{
+				Transport::Batch batch(transport);
+				for (auto exchange = batched; exchange; exchange = exchange->_next)
+				{
+					auto buffer = batch.queue(exchange->_request.size(), exchange->_response.size());
+					std::ranges::copy(exchange->_request, buffer.begin());
+				}
+				batch.submit();
+
+				std::size_t index = 0;
+				for (auto exchange = batched; exchange; exchange = exchange->_next)
+				{
+					std::ranges::copy(batch.response(index++), exchange->_response.begin());
+				}
+			}
+			catch (...)
+			{
+				const auto error = utils::eh::currentErrorCode();
+				for (auto exchange = batched; exchange; exchange = exchange->_next)
+				{
+					exchange->_error = error;
+				}
+			}
+		}
+
+		// Resume the coroutines, the expired ones first, because they have been waiting longest
+		*expiredTail = batched;
+		while (expired)
+		{
+			auto &current = *expired;
+			expired = current._next;
+			current._continuation.resume();
+		}
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,125 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "Session.hpp"
+#include "TimingWheel.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Performs device requests on behalf of transactions, and resumes the transactions when the responses arrive.
+///
+/// Each I/O component has a single reactor, shared by all its sessions. The reactor has its own thread, which collects the requests of
+/// all waiting transactions, sends them in batches, one per transport, and then resumes the transactions. The reactor also owns
+/// the pool that the coroutine frames of the transactions are allocated from.
+class Reactor final : private utils::tools::Unique
+{
+public:
+	/// @brief An awaitable that sends a request to the device, and receives the response
+	class Exchange final
+	{
+	public:
+		/// @brief The request is sent when the awaiting coroutine is suspended
+		auto await_ready() const noexcept -> bool
+		{
+			// Don't suspend if there is nothing to send it over
+			return _error != std::error_code();
+		}
+
+		/// @brief Queues the request with the reactor
+		auto await_suspend(std::coroutine_handle<> continuation) noexcept -> void;
+
+		/// @brief Finishes the exchange
+		/// @throw std::system_error if the request could not be sent, or no valid response was received. If the request
+		/// waited too long to be sent, or the device did not respond in time, the error code is CustomError::Timeout.
+		auto await_resume() const -> void
+		{
+			if (_error)
+			{
+				throw std::system_error(_error, "could not exchange data with device");
+			}
+		}
+
+	private:
+		/// @brief The reactor creates exchanges
+		friend class Reactor;
+
+		/// @brief Constructor
+		Exchange(Reactor &reactor, Transport *transport, std::span<const std::byte> request, std::span<std::byte> response) noexcept;
+
+		/// @brief The reactor
+		Reactor &_reactor;
+		/// @brief The transport to use
+		Transport *_transport;
+		/// @brief The request
+		std::span<const std::byte> _request;
+		/// @brief The buffer to receive the response into
+		std::span<std::byte> _response;
+		/// @brief The result of the exchange
+		std::error_code _error;
+		/// @brief The coroutine to resume when the response has arrived
+		std::coroutine_handle<> _continuation;
+		/// @brief The next exchange waiting in the reactor
+		Exchange *_next { nullptr };
+		/// @brief The time after which the request is no longer sent if it is still waiting in the reactor
+		TimingWheel::Deadline _deadline;
+	};
+
+	/// @brief How long a request may wait to be sent before it is failed with CustomError::Timeout
+	static constexpr std::chrono::milliseconds kQueueTimeout = 2 * Transport::kTimeout;
+
+	/// @brief Returns the pool that coroutine frames are allocated from
+	auto framePool() noexcept -> std::pmr::memory_resource &
+	{
+		return _framePool;
+	}
+
+	/// @brief Sends a request to the device over a session, and receives the response.
+	///
+	/// The returned object must be awaited using co_await. The awaiting coroutine is resumed on the reactor thread once the response
+	/// has arrived. The buffers must remain valid until then, and the lease must not be released.
+	/// @param lease A lease on the session to use
+	/// @param request The request to send
+	/// @param response A buffer for the response. The response must have exactly this size.
+	auto exchange(const Session::Lease &lease, std::span<const std::byte> request, std::span<std::byte> response) noexcept -> Exchange;
+
+	/// @brief Starts the reactor thread
+	auto start() -> void;
+
+private:
+	/// @brief Adds an exchange to the queue, and wakes up the reactor thread
+	auto push(Exchange &exchange) noexcept -> void;
+
+	/// @brief The function executed by the reactor thread
+	auto run(std::stop_token stopToken) -> void;
+
+	/// @brief Sends a list of exchanges, and resumes their coroutines
+	/// @param exchanges The exchanges, in the order they were queued
+	auto process(Exchange *exchanges) noexcept -> void;
+
+	/// @brief The exchange that was queued last, or nullptr if there are none
+	std::atomic<Exchange *> _head { nullptr };
+	/// @brief A counter that is incremented whenever an exchange is queued, used to wake up the reactor thread.
+	std::atomic<std::uint32_t> _doorbell { 0 };
+
+	/// @brief The pool that coroutine frames are allocated from
+	std::pmr::synchronized_pool_resource _framePool;
+
+	/// @brief The reactor thread. This must be the last member, so the thread is stopped before anything else is destroyed.
+	std::jthread _thread;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "ReadState.hpp"
 
 #include "Attributes.hpp"
+#include "Trace.hpp"
 
 #include <xentara/memory/memoryResources.hpp>
 #include <xentara/memory/WriteSentinel.hpp>
@@ -64,16 +65,101 @@ auto ReadState<DataType>::realize() -> void
 {
 	// Create the data block
 	_dataBlock.create(memory::memoryResources::data());
+
+	// Restore the last known value, if there is one
+	if constexpr (SnapshotValueType<DataType>)
+	{
+		if (!_snapshot)
+		{
+			return;
+		}
+		const auto sample = _snapshot->restore(_snapshotSlot);
+		if (!sample)
+		{
+			return;
+		}
+
+		memory::WriteSentinel sentinel { _dataBlock };
+		auto &state = *sentinel;
+		state._updateTime = sample->_updateTime;
+		state._value = Snapshot::fromBits<DataType>(sample->_bits);
+		state._changeTime = sample->_changeTime;
+		// The value has not been confirmed by the device yet, so it might be outdated
+		state._quality = data::Quality::Unreliable;
+		state._error = CustomError::LastKnownValue;
+		sentinel.commit(sample->_updateTime);
+	}
+}
+
+template <std::regular DataType>
+auto ReadState<DataType>::enableSnapshot(Snapshot &snapshot) -> void
+{
+	if constexpr (SnapshotValueType<DataType>)
+	{
+		_snapshot = &snapshot;
+		_snapshotSlot = snapshot.attach<DataType>();
+	}
+}
+
+template <std::regular DataType>
+auto ReadState<DataType>::enableHistory(Arena &arena, std::size_t size) -> bool
+{
+	if constexpr (HistoryValueType<DataType>)
+	{
+		_history = &arena.make<History<DataType>>(arena, size);
+		return true;
+	}
+	else
+	{
+		return false;
+	}
+}
+
+template <std::regular DataType>
+auto ReadState<DataType>::enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void
+{
+	_stalenessEntry = &arena.make<StalenessEntry>(*this);
+	index.attach(*_stalenessEntry, maxAge);
+}
+
+template <std::regular DataType>
+auto ReadState<DataType>::readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool
+{
+	if constexpr (HistoryValueType<DataType>)
+	{
+		if (_history)
+		{
+			_history->read(since, function);
+			return true;
+		}
+	}
+
+	return false;
 }
 
 template <std::regular DataType>
-auto ReadState<DataType>::update(std::chrono::system_clock::time_point timeStamp, const utils::eh::expected<DataType, std::error_code> &valueOrError) -> void
+auto ReadState<DataType>::update(std::chrono::system_clock::time_point timeStamp,
+	const utils::eh::expected<DataType, std::error_code> &valueOrError,
+	bool raiseEvents) -> void
 {
+	// Keep a concurrent sweep of the staleness index from marking the new value as stale
+	if (_stalenessEntry)
+	{
+		_stalenessEntry->beginUpdate();
+	}
+
 	// Make a write sentinel
 	memory::WriteSentinel sentinel { _dataBlock };
 	auto &state = *sentinel;
 	const auto &oldState = sentinel.oldValue();
 
+	// A value restored from the snapshot is kept until the first value is actually read. It did not come from a live read,
+	// so errors, including the invalidation when the I/O component connects or fails to connect, do not apply to it.
+	if (!valueOrError && oldState._error == CustomError::LastKnownValue)
+	{
+		return;
+	}
+
 	state._updateTime = timeStamp;
 
 	// See if we have a value
@@ -105,16 +191,73 @@ auto ReadState<DataType>::update(std::chrono::system_clock::time_point timeStamp
 
 	// Update the change time, if necessary. We always need to write the change time, even if it is the same as before,
 	// because memory resources use swap-in.
-	state._changeTime = changed ? timeStamp : oldState._changeTime;
+	const auto changeTime = changed ? timeStamp : oldState._changeTime;
+	state._changeTime = changeTime;
 
 	// Collect the events to raise
 	process::StaticEventList<1> events;
-	if (changed)
+	if (changed && raiseEvents)
 	{
 		events.push_back(_changedEvent);
 	}
 
 	// Commit the data and raise the events
+	{
+		Trace::Span span { "commit", "commit" };
+		sentinel.commit(timeStamp, events);
+	}
+
+	// Restart the age of the value, or stop tracking it if there is no value
+	if (_stalenessEntry)
+	{
+		if (valueOrError)
+		{
+			_stalenessEntry->refresh();
+		}
+		else
+		{
+			_stalenessEntry->remove();
+		}
+	}
+
+	// Record the value in the history
+	if constexpr (HistoryValueType<DataType>)
+	{
+		if (_history)
+		{
+			_history->record(timeStamp, valueOrError ? std::optional<DataType>(*valueOrError) : std::nullopt);
+		}
+	}
+
+	// Store the value in the snapshot. Errors are not stored, so that the snapshot always holds the last known value.
+	if constexpr (SnapshotValueType<DataType>)
+	{
+		if (_snapshot && valueOrError)
+		{
+			_snapshot->store(_snapshotSlot, timeStamp, changeTime, Snapshot::toBits(*valueOrError));
+		}
+	}
+}
+
+template <std::regular DataType>
+auto ReadState<DataType>::expire(std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Make a write sentinel
+	memory::WriteSentinel sentinel { _dataBlock };
+	auto &state = *sentinel;
+	const auto &oldState = sentinel.oldValue();
+
+	// Keep the last value and its time stamps, but mark it as no longer current. We must write all the fields, because memory
+	// resources use swap-in.
+	state._updateTime = oldState._updateTime;
+	state._value = oldState._value;
+	state._changeTime = timeStamp;
+	state._quality = data::Quality::Unreliable;
+	state._error = CustomError::Stale;
+
+	// Commit the data and raise the event
+	process::StaticEventList<1> events;
+	events.push_back(_changedEvent);
 	sentinel.commit(timeStamp, events);
 }
 
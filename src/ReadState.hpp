@@ -1,8 +1,12 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "Arena.hpp"
 #include "Attributes.hpp"
 #include "CustomError.hpp"
+#include "History.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
 
 #include <xentara/data/Quality.hpp>
 #include <xentara/data/ReadHandle.hpp>
@@ -14,6 +18,7 @@
 
 #include <chrono>
 #include <concepts>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -53,14 +58,51 @@ public:
 	/// @return A read handle to the value attribute
 	auto valueReadHandle() const noexcept -> data::ReadHandle;
 
-	/// @brief Realizes the state
+	/// @brief Realizes the state.
+	///
+	/// If the state has a slot in a snapshot that contains a value from a previous run, the value is restored with its original
+	/// time stamps, but with the quality set to *Unreliable*. The restored value is kept until the first value is read, and is
+	/// not replaced by errors.
 	auto realize() -> void;
 
+	/// @brief Assigns the state a slot in a snapshot, so that the last known value survives a restart.
+	///
+	/// This function must only be called while the configuration is being loaded. It does nothing if values of the data type cannot
+	/// be stored in a snapshot.
+	/// @param snapshot The snapshot of the I/O component
+	auto enableSnapshot(Snapshot &snapshot) -> void;
+
+	/// @brief Enables recording a history of the values
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the history from
+	/// @param size The size of the history buffer, in bytes
+	/// @return true on success, or false if no history can be recorded for the data type
+	auto enableHistory(Arena &arena, std::size_t size) -> bool;
+
+	/// @brief Enables detecting values that have not been updated for too long
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param arena The arena to allocate the index entry from
+	/// @param index The staleness index of the I/O component
+	/// @param maxAge The maximum age of the value, or std::nullopt to use the default maximum age of the I/O component
+	auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void;
+
+	/// @brief Calls a function for each sample in the history that was recorded at or after a certain time
+	/// @param since The time stamp of the oldest sample of interest
+	/// @param function The function to call
+	/// @return true if the history was read, or false if no history is being recorded
+	auto readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool;
+
 	/// @brief Updates the data and sends events
 	/// @param timeStamp The update time stamp
 	/// @param valueOrError This is a variant-like type that will hold either the new value, or an std::error_code object
 	/// containing an read error
-	auto update(std::chrono::system_clock::time_point timeStamp, const utils::eh::expected<DataType, std::error_code> &valueOrError) -> void;
+	/// @param raiseEvents Whether to raise the *changed* event if anything changed. This is false when all the data points of
+	/// an I/O component are invalidated together, and the I/O component raises a single event for all of them.
+	auto update(std::chrono::system_clock::time_point timeStamp,
+		const utils::eh::expected<DataType, std::error_code> &valueOrError,
+		bool raiseEvents = true) -> void;
 
 private:
 	/// @brief This structure is used to represent the state inside the memory block
@@ -78,11 +120,47 @@ private:
 		std::error_code _error { CustomError::NotConnected };
 	};
 
+	/// @brief The entry of the state in the staleness index
+	class StalenessEntry final : public StalenessIndex::Entry
+	{
+	public:
+		/// @brief Constructor
+		explicit StalenessEntry(ReadState &state) noexcept : _state(state)
+		{
+		}
+
+	private:
+		/// @copydoc StalenessIndex::Entry::expire()
+		auto expire(std::chrono::system_clock::time_point timeStamp) -> void final
+		{
+			_state.get().expire(timeStamp);
+		}
+
+		/// @brief The state
+		std::reference_wrapper<ReadState> _state;
+	};
+
+	/// @brief Marks the value as stale because it has not been updated for longer than its maximum age
+	/// @param timeStamp The time stamp to use for the change
+	auto expire(std::chrono::system_clock::time_point timeStamp) -> void;
+
 	/// @brief A summary event that is raised when anything changes
 	process::Event _changedEvent { io::Direction::Input };
 
 	/// @brief The data block that contains the state
 	memory::ObjectBlock<State> _dataBlock;
+
+	/// @brief The history, or nullptr if no history is recorded. The history is allocated in the arena of the I/O component.
+	History<DataType> *_history { nullptr };
+
+	/// @brief The snapshot the last known value is stored in, or nullptr if there is none
+	Snapshot *_snapshot { nullptr };
+	/// @brief The index of our slot in the snapshot
+	std::size_t _snapshotSlot { 0 };
+
+	/// @brief The entry in the staleness index, or nullptr if the value has no maximum age. The entry is allocated in the arena
+	/// of the I/O component.
+	StalenessEntry *_stalenessEntry { nullptr };
 };
 
 /// @class xentara::plugins::templateDriver::ReadState
@@ -1,6 +1,8 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "Trace.hpp"
+
 #include <xentara/process/Task.hpp>
 #include <xentara/process/ExecutionContext.hpp>
 
@@ -73,6 +75,7 @@ auto ReadTask<Target>::preOperational(const process::ExecutionContext &context)
 template <typename Target>
 auto ReadTask<Target>::operational(const process::ExecutionContext &context) -> void
 {
+	Trace::Span span { "read task", "task" };
 	_target.get().performReadTask(context);
 }
 
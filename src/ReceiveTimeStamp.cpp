@@ -0,0 +1,59 @@
+// Copyright (c) embedded ocean GmbH
+#include "ReceiveTimeStamp.hpp"
+
+#ifndef _WIN32
+
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace xentara::plugins::templateDriver
+{
+
+const std::size_t kReceiveTimeStampControlSize = CMSG_SPACE(sizeof(::scm_timestamping));
+
+auto enableReceiveTimeStamps(int socket) -> void
+{
+	// We only need software time stamps. Hardware time stamps use the clock of the network card, which is not synchronized
+	// with the system clock.
+	const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	if (::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not enable receive time stamps");
+	}
+}
+
+auto receiveTimeStamp(const ::msghdr &message) noexcept -> std::optional<std::chrono::system_clock::time_point>
+{
+	// Look for the time stamping control message
+	for (auto header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(const_cast<::msghdr *>(&message), header))
+	{
+		if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SO_TIMESTAMPING)
+		{
+			continue;
+		}
+
+		// Copy the data out of the message, because it is not guaranteed to be properly aligned
+		::scm_timestamping timeStamps;
+		std::memcpy(&timeStamps, CMSG_DATA(header), sizeof(timeStamps));
+
+		// The software time stamp is the first one. It is all zeros if it is not present.
+		const auto &software = timeStamps.ts[0];
+		if (software.tv_sec == 0 && software.tv_nsec == 0)
+		{
+			return std::nullopt;
+		}
+
+		return std::chrono::system_clock::time_point(
+			std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::seconds(software.tv_sec) + std::chrono::nanoseconds(software.tv_nsec)));
+	}
+
+	return std::nullopt;
+}
+
+} // namespace xentara::plugins::templateDriver
+
+#endif // _WIN32
\ No newline at end of file
@@ -0,0 +1,36 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#ifndef _WIN32
+#	include <sys/socket.h>
+#endif
+
+namespace xentara::plugins::templateDriver
+{
+
+#ifndef _WIN32
+
+/// @brief Enables kernel receive time stamps on a socket, using SO_TIMESTAMPING.
+///
+/// Once this is enabled, each message received using recvmsg() carries the time the kernel received it in its control data,
+/// which can be extracted using receiveTimeStamp(). The time stamp is taken by the network stack, so it does not include any
+/// scheduling delay of the receiving thread.
+/// @param socket The socket
+/// @throw std::system_error if the option could not be set
+auto enableReceiveTimeStamps(int socket) -> void;
+
+/// @brief Extracts the kernel receive time stamp from a message received using recvmsg()
+/// @param message The message. The control buffer of the message should be at least kReceiveTimeStampControlSize bytes large.
+/// @return The time stamp, or std::nullopt if the message does not contain one
+auto receiveTimeStamp(const ::msghdr &message) noexcept -> std::optional<std::chrono::system_clock::time_point>;
+
+/// @brief The size of the control buffer needed to receive a time stamp
+extern const std::size_t kReceiveTimeStampControlSize;
+
+#endif // _WIN32
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Copyright (c) embedded ocean GmbH
+#include "SampleClock.hpp"
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+auto SampleClock::parseSource(std::string_view keyword) noexcept -> std::optional<Source>
+{
+	if (keyword == "scheduled"sv)
+	{
+		return Source::Scheduled;
+	}
+	else if (keyword == "device"sv)
+	{
+		return Source::Device;
+	}
+	else if (keyword == "receive"sv)
+	{
+		return Source::Receive;
+	}
+
+	return std::nullopt;
+}
+
+auto SampleClock::timeStamp(std::chrono::system_clock::time_point scheduledTime, const ResponseTimes &responseTimes) noexcept
+	-> std::chrono::system_clock::time_point
+{
+	switch (_source)
+	{
+	case Source::Device:
+		if (responseTimes._deviceTime)
+		{
+			// Every response is a sample for the offset estimate, so the estimate is kept current without any extra reads.
+			// If the transport did not record a receive time, the current time is the next best thing.
+			_clockOffset.addSample(*responseTimes._deviceTime, responseTimes._receiveTime.value_or(std::chrono::system_clock::now()));
+
+			return _clockOffset.toHostTime(*responseTimes._deviceTime);
+		}
+		break;
+
+	case Source::Receive:
+		if (responseTimes._receiveTime)
+		{
+			return *responseTimes._receiveTime;
+		}
+		break;
+
+	case Source::Scheduled:
+		break;
+	}
+
+	return scheduledTime;
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "ClockOffset.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Determines the time stamps of values read from a device.
+///
+/// By default, values are stamped with the scheduled time of the task that read them. Optionally, the time the device sampled
+/// the value, or the time the host received the response can be used instead. Device times are converted to host time using
+/// a continuously estimated clock offset.
+class SampleClock final : private utils::tools::Unique
+{
+public:
+	/// @brief The source of the time stamps
+	enum class Source
+	{
+		/// @brief Use the scheduled time of the task that performed the read
+		Scheduled,
+		/// @brief Use the sample time provided by the device, converted to host time
+		Device,
+		/// @brief Use the time the response was received by the host, preferably as time stamped by the kernel
+		Receive
+	};
+
+	/// @brief Timing information about a response from the device.
+	///
+	/// The transport fills in whatever information it has available.
+	struct ResponseTimes final
+	{
+		/// @brief The time the device sampled the value, in device time
+		std::optional<std::chrono::system_clock::time_point> _deviceTime;
+		/// @brief The time the host received the response, in host time
+		std::optional<std::chrono::system_clock::time_point> _receiveTime;
+	};
+
+	/// @brief Parses a time stamp source keyword
+	/// @return The source, or std::nullopt if the keyword is unknown
+	static auto parseSource(std::string_view keyword) noexcept -> std::optional<Source>;
+
+	/// @brief Returns the configured source
+	auto source() const noexcept -> Source
+	{
+		return _source;
+	}
+
+	/// @brief Sets the source. This must only be called while the configuration is being loaded.
+	auto setSource(Source source) noexcept -> void
+	{
+		_source = source;
+	}
+
+	/// @brief Determines the time stamp for a value read from the device
+	///
+	/// Falls back to the scheduled time if the configured time stamp is not available for the response. If device time stamps
+	/// are used, this function also updates the clock offset estimate.
+	/// @param scheduledTime The scheduled time of the task that performed the read
+	/// @param responseTimes The timing information of the response
+	auto timeStamp(std::chrono::system_clock::time_point scheduledTime, const ResponseTimes &responseTimes) noexcept
+		-> std::chrono::system_clock::time_point;
+
+	/// @brief Returns the clock offset estimate
+	auto clockOffset() const noexcept -> const ClockOffset &
+	{
+		return _clockOffset;
+	}
+
+private:
+	/// @brief The configured source
+	Source _source { Source::Scheduled };
+
+	/// @brief The estimated offset between the device clock and the host clock
+	ClockOffset _clockOffset;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,87 @@
+// Copyright (c) embedded ocean GmbH
+#include "Session.hpp"
+
+#include <algorithm>
+
+namespace xentara::plugins::templateDriver
+{
+
+auto Session::lease() noexcept -> Lease
+{
+	// Register the lease before checking the state. closeHandle() is only called after the state was changed, and checks
+	// the lease count afterwards, so either it will see our lease, or we will see the new state.
+	++_leaseCount;
+	const auto status = _status.load();
+	if (status._state != State::Connected)
+	{
+		releaseLease();
+		return {};
+	}
+
+	return { *this, status._generation };
+}
+
+auto Session::releaseLease() noexcept -> void
+{
+	// Wake up any thread waiting in closeHandle() if this was the last lease
+	if (--_leaseCount == 0)
+	{
+		_leaseCount.notify_all();
+	}
+}
+
+auto Session::tryTransition(std::initializer_list<State> from, State to) noexcept -> std::optional<Status>
+{
+	auto current = _status.load();
+	while (std::ranges::find(from, current._state) != from.end())
+	{
+		// Keep the generation. It is only changed when a new connection is established.
+		if (_status.compare_exchange_weak(current, { to, current._generation }))
+		{
+			return current;
+		}
+	}
+
+	return std::nullopt;
+}
+
+auto Session::acquire(State to) noexcept -> Status
+{
+	auto current = _status.load();
+	for (;;)
+	{
+		if (current._state == State::Connecting || current._state == State::Closing)
+		{
+			// Wait for the owner to move the session into a different state
+			_status.wait(current);
+			current = _status.load();
+		}
+		else if (_status.compare_exchange_weak(current, { to, current._generation }))
+		{
+			return current;
+		}
+	}
+}
+
+auto Session::publish(Status status) noexcept -> void
+{
+	_status.store(status);
+	_status.notify_all();
+}
+
+auto Session::closeHandle() noexcept -> void
+{
+	// Wait until nobody is using the handle anymore. No new leases can be acquired, because the session is not up.
+	for (auto count = _leaseCount.load(); count != 0; count = _leaseCount.load())
+	{
+		_leaseCount.wait(count);
+	}
+
+	// Reset the handle in any case, even if we fail, because the connection state should be false after this
+	auto handle = std::exchange(_handle, Handle());
+
+	/// @todo close the connection, ignoring any errors. If the disconnect function can throw exceptions,
+	// these shoudl be caucht and ignored.
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,263 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "SampleClock.hpp"
+#include "TimingWheel.hpp"
+#include "Transport.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+class RateLimiter;
+class Reactor;
+class TemplateIoComponent;
+
+/// @brief A single connection to the physical device.
+///
+/// An I/O component can open several sessions to the same device in parallel, and to each of several redundant endpoints of the
+/// device. Each session has its own lock-free connection state machine, and is monitored and reconnected individually.
+/// @todo rename this class to something more descriptive
+class Session final : private utils::tools::Unique
+{
+public:
+	/// @brief A handle used to access the session
+	/// @todo implement a proper handle
+	class Handle final
+	{
+	public:
+		/// @brief Creates a handle that is not connected
+		Handle() noexcept = default;
+
+		/// @brief Creates a handle that exchanges data using a transport
+		explicit Handle(std::unique_ptr<Transport> transport) noexcept : _transport(std::move(transport))
+		{
+		}
+
+		/// @brief determines of the session is connected
+		explicit operator bool() const noexcept
+		{
+			/// @todo return the actual state
+			return _transport != nullptr;
+		}
+
+		/// @brief Returns the transport used to exchange data with the device.
+		///
+		/// This must only be called if the handle is connected. Sessions are only published as connected once their handle has
+		/// been set, so the handle of a leased session is always connected.
+		auto transport() const noexcept -> Transport &
+		{
+			return *_transport;
+		}
+
+	private:
+		/// @brief The transport
+		std::unique_ptr<Transport> _transport;
+	};
+
+	/// @brief A lease on a session.
+	///
+	/// The session will not be torn down while a lease on it is held, so the handle can safely be used by the holder,
+	/// even if another thread detects an error in the meantime. Leases are lock-free, and any number of threads can hold one
+	/// at the same time. Leases must only be held for the duration of a single operation.
+	class Lease final
+	{
+	public:
+		/// @brief Creates an empty lease that does not refer to a session
+		Lease() noexcept = default;
+
+		/// @brief Move constructor
+		Lease(Lease &&other) noexcept :
+			_session(std::exchange(other._session, nullptr)),
+			_generation(other._generation)
+		{
+		}
+
+		/// @brief Leases cannot be assigned
+		auto operator=(Lease &&other) -> Lease & = delete;
+
+		/// @brief Destructor. Releases the lease.
+		~Lease()
+		{
+			if (_session)
+			{
+				_session->releaseLease();
+			}
+		}
+
+		/// @brief Determines whether the lease refers to a session
+		explicit operator bool() const noexcept
+		{
+			return _session != nullptr;
+		}
+
+		/// @brief Returns the leased session
+		auto session() const noexcept -> Session &
+		{
+			return *_session;
+		}
+
+		/// @brief Returns the handle of the leased session
+		auto handle() const noexcept -> const Handle &
+		{
+			return _session->_handle;
+		}
+
+		/// @brief Returns the generation of the leased session
+		auto generation() const noexcept -> std::uint32_t
+		{
+			return _generation;
+		}
+
+	private:
+		/// @brief Sessions create leases
+		friend class Session;
+
+		/// @brief Constructor used by the session
+		Lease(Session &session, std::uint32_t generation) noexcept :
+			_session(&session),
+			_generation(generation)
+		{
+		}
+
+		/// @brief The session, or nullptr if the lease is empty
+		Session *_session { nullptr };
+		/// @brief The generation of the leased session
+		std::uint32_t _generation { 0 };
+	};
+
+	/// @brief The states of the session
+	enum class State : std::uint32_t
+	{
+		/// @brief The session is closed, and nobody has requested that it be open
+		Disconnected,
+		/// @brief A thread is trying to establish the session
+		Connecting,
+		/// @brief The session is up
+		Connected,
+		/// @brief The session was lost or could not be established. The "reconnect" task will try again.
+		Failed,
+		/// @brief A thread is tearing down the session, either because of an error or because it is no longer needed
+		Closing
+	};
+
+	/// @brief The state of the session, together with its generation.
+	///
+	/// The thread that moves the session into the Connecting or Closing state owns the session until it moves it out of
+	/// that state again using publish(). Only the owner may modify the handle. This guarantees that only one thread ever
+	/// reconnects a session, and that only the first error of each connection is handled.
+	struct Status final
+	{
+		/// @brief The state of the session
+		State _state { State::Disconnected };
+		/// @brief A counter that is incremented each time the session is established
+		std::uint32_t _generation { 0 };
+	};
+
+	/// @brief Checks whether the session is up
+	auto connected() const noexcept -> bool
+	{
+		return _status.load()._state == State::Connected;
+	}
+
+	/// @brief Returns the number of leases currently held, i.e. the number of outstanding requests
+	auto outstanding() const noexcept -> std::size_t
+	{
+		return _leaseCount.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Returns the index of the endpoint the session connects to
+	auto endpoint() const noexcept -> std::size_t
+	{
+		return _endpoint;
+	}
+
+	/// @brief Returns the clock used to time stamp values read using the session
+	auto sampleClock() const noexcept -> SampleClock &
+	{
+		return *_sampleClock;
+	}
+
+	/// @brief Returns the reactor used to perform transactions on the session
+	auto reactor() const noexcept -> Reactor &
+	{
+		return *_reactor;
+	}
+
+	/// @brief Returns the rate limiter that requests sent using the session must obey
+	auto rateLimiter() const noexcept -> RateLimiter &
+	{
+		return *_rateLimiter;
+	}
+
+	/// @brief Leases the session.
+	/// @return A lease on the session, or an empty lease if the session is not connected.
+	auto lease() noexcept -> Lease;
+
+	/// @brief Atomically moves the session into a new state, if it is in one of a list of states.
+	/// @return The status before the transition, or std::nullopt if the session was not in one of the given states
+	auto tryTransition(std::initializer_list<State> from, State to) noexcept -> std::optional<Status>;
+
+	/// @brief Moves the session into a state owned by the calling thread, waiting for any other owner to finish first.
+	/// @return The status before the transition
+	auto acquire(State to) noexcept -> Status;
+
+	/// @brief Moves the session out of a state owned by the calling thread, and wakes up threads waiting for the transition
+	auto publish(Status status) noexcept -> void;
+
+	/// @brief Closes the handle, once all the leases have been released
+	///
+	/// The caller must own the session.
+	auto closeHandle() noexcept -> void;
+
+private:
+	/// @brief The I/O component establishes the connection and sets the handle
+	friend class TemplateIoComponent;
+
+	/// @brief Releases a lease acquired using lease()
+	auto releaseLease() noexcept -> void;
+
+	/// @brief The status of the session
+	std::atomic<Status> _status;
+	// Check that the status is lock free, so that it can be used from any thread without blocking
+	static_assert(std::atomic<Status>::is_always_lock_free);
+
+	/// @brief The number of leases currently held on the session
+	std::atomic<std::size_t> _leaseCount { 0 };
+
+	/// @brief The index of the endpoint the session connects to
+	std::size_t _endpoint { 0 };
+
+	/// @brief The clock used to time stamp values. This is shared by all the sessions of an I/O component.
+	SampleClock *_sampleClock { nullptr };
+	/// @brief The reactor used to perform transactions. This is shared by all the sessions of an I/O component.
+	Reactor *_reactor { nullptr };
+	/// @brief The rate limiter for requests. This is shared by all the sessions of an I/O component.
+	RateLimiter *_rateLimiter { nullptr };
+
+	/// @brief The current wait between connection attempts, or zero if the last attempt succeeded.
+	///
+	/// This may only be accessed by the thread owning the session.
+	std::chrono::milliseconds _reconnectBackoff { 0 };
+	/// @brief The time before which no new connection attempt should be made
+	TimingWheel::Deadline _reconnectDeadline;
+	/// @brief The time before which no heartbeat needs to be sent on a standby session
+	TimingWheel::Deadline _heartbeatDeadline;
+
+	/// @brief The handle.
+	///
+	/// This may only be modified by the thread owning the session, and only while no leases are held.
+	Handle _handle;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
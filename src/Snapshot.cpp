@@ -0,0 +1,84 @@
+// Copyright (c) embedded ocean GmbH
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace xentara::plugins::templateDriver
+{
+
+namespace
+{
+
+	/// @brief Identifies the file format. This must be changed whenever the layout of the file changes.
+	constexpr std::uint64_t kMagic = 0x3130'5053'4452'5458; // "XTRDSP01" in little endian
+
+} // namespace
+
+auto Snapshot::open() -> void
+{
+	// Nothing to do if no file was configured
+	if (_path.empty())
+	{
+		return;
+	}
+
+	_file.open(_path, sizeof(Header) + _slotCount * sizeof(Slot));
+	auto &header = *reinterpret_cast<Header *>(_file.bytes().data());
+
+	// Discard the contents if the file was written with different slots, because the values would end up in the wrong data points
+	if (header._magic != kMagic || header._layout != _layout || header._slotCount != _slotCount)
+	{
+		std::ranges::fill(_file.bytes(), std::byte(0));
+		header = { kMagic, _layout, _slotCount };
+	}
+
+	_slots = { reinterpret_cast<Slot *>(_file.bytes().data() + sizeof(Header)), _slotCount };
+}
+
+auto Snapshot::restore(std::size_t slot) -> std::optional<Sample>
+{
+	std::call_once(_opened, [this]() { open(); });
+	if (slot >= _slots.size())
+	{
+		return std::nullopt;
+	}
+
+	// Skip slots that were never written, or whose last write was interrupted
+	const auto &contents = _slots[slot];
+	if (contents._sequence == 0 || contents._sequence % 2 != 0)
+	{
+		return std::nullopt;
+	}
+
+	using Duration = std::chrono::system_clock::duration;
+	return Sample {
+		std::chrono::system_clock::time_point(Duration(contents._updateTime)),
+		std::chrono::system_clock::time_point(Duration(contents._changeTime)),
+		contents._bits };
+}
+
+auto Snapshot::store(std::size_t slot, std::chrono::system_clock::time_point updateTime, std::chrono::system_clock::time_point changeTime,
+	std::uint64_t bits) noexcept -> void
+{
+	if (slot >= _slots.size())
+	{
+		return;
+	}
+
+	// Make the sequence number odd while the slot is being written, so that a write interrupted by a crash is detected
+	auto &contents = _slots[slot];
+	std::atomic_ref sequence { contents._sequence };
+	const auto start = sequence.load(std::memory_order_relaxed) | 1;
+	sequence.store(start, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	contents._updateTime = updateTime.time_since_epoch().count();
+	contents._changeTime = changeTime.time_since_epoch().count();
+	contents._bits = bits;
+
+	// Skip zero when the sequence number wraps around, because that marks a slot that was never written
+	sequence.store(start + 1 != 0 ? start + 1 : 2, std::memory_order_release);
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,158 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <type_traits>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Checks whether values of a certain type can be stored in a snapshot
+template <typename ValueType>
+concept SnapshotValueType = std::integral<ValueType> || std::floating_point<ValueType>;
+
+/// @brief A memory-mapped file containing the last known values of the data points of an I/O component.
+///
+/// Each data point has a fixed slot in the file, which is overwritten every time a valid value is read. Since the file is
+/// memory-mapped, this costs only a few memory stores. After a restart, the data points are initialized from their slots, so that
+/// their last known values are available immediately, rather than only after the first successful read.
+///
+/// The slots are assigned in the order the data points are loaded. If the configuration changes so that the data points no
+/// longer match the ones the file was written with, the file is discarded.
+class Snapshot final : private utils::tools::Unique
+{
+public:
+	/// @brief The contents of a slot
+	struct Sample final
+	{
+		/// @brief The time stamp of the last update
+		std::chrono::system_clock::time_point _updateTime;
+		/// @brief The time stamp of the last change
+		std::chrono::system_clock::time_point _changeTime;
+		/// @brief The raw bits of the value, as returned by toBits()
+		std::uint64_t _bits;
+	};
+
+	/// @brief Sets the path of the file.
+	///
+	/// If no file is set, nothing is stored.
+	auto setFile(std::filesystem::path path) -> void
+	{
+		_path = std::move(path);
+	}
+
+	/// @brief Assigns a slot to a data point.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @tparam ValueType The type of the value of the data point
+	/// @return The index of the slot
+	template <SnapshotValueType ValueType>
+	auto attach() -> std::size_t
+	{
+		// Include the type of the value in the fingerprint, so the values are never reinterpreted as a different type
+		_layout = (_layout ^ (std::uint64_t(std::is_signed_v<ValueType>) << 8 | std::floating_point<ValueType> << 9 | sizeof(ValueType))) *
+			kFingerprintPrime;
+		return _slotCount++;
+	}
+
+	/// @brief Reads the value stored in a slot by a previous run.
+	///
+	/// The first call opens the file, so this function must not be called before all the slots have been assigned.
+	/// @return The value, or std::nullopt if there is none
+	auto restore(std::size_t slot) -> std::optional<Sample>;
+
+	/// @brief Stores a value in a slot
+	auto store(std::size_t slot, std::chrono::system_clock::time_point updateTime, std::chrono::system_clock::time_point changeTime,
+		std::uint64_t bits) noexcept -> void;
+
+	/// @brief Converts a value to the raw bits stored in the slot
+	template <SnapshotValueType ValueType>
+	static constexpr auto toBits(ValueType value) noexcept -> std::uint64_t
+	{
+		if constexpr (std::floating_point<ValueType>)
+		{
+			using Bits = std::conditional_t<sizeof(ValueType) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+			return std::bit_cast<Bits>(value);
+		}
+		else
+		{
+			return std::uint64_t(value);
+		}
+	}
+
+	/// @brief Converts raw bits stored in a slot back to a value
+	template <SnapshotValueType ValueType>
+	static constexpr auto fromBits(std::uint64_t bits) noexcept -> ValueType
+	{
+		if constexpr (std::floating_point<ValueType>)
+		{
+			using Bits = std::conditional_t<sizeof(ValueType) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+			return std::bit_cast<ValueType>(Bits(bits));
+		}
+		else
+		{
+			return ValueType(bits);
+		}
+	}
+
+private:
+	/// @brief The FNV-1a prime used to compute the fingerprint of the slots
+	static constexpr std::uint64_t kFingerprintPrime = 0x100000001b3;
+
+	/// @brief The header at the start of the file
+	struct Header final
+	{
+		/// @brief Identifies the file format
+		std::uint64_t _magic;
+		/// @brief The fingerprint of the slots the file was written with
+		std::uint64_t _layout;
+		/// @brief The number of slots
+		std::uint64_t _slotCount;
+	};
+
+	/// @brief A slot in the file
+	struct Slot final
+	{
+		/// @brief A sequence number that is odd while the slot is being written, and zero if it was never written
+		std::uint32_t _sequence;
+		/// @brief Padding
+		std::uint32_t _reserved;
+		/// @brief The time stamp of the last update, as a count of system clock ticks
+		std::chrono::system_clock::rep _updateTime;
+		/// @brief The time stamp of the last change, as a count of system clock ticks
+		std::chrono::system_clock::rep _changeTime;
+		/// @brief The raw bits of the value
+		std::uint64_t _bits;
+	};
+
+	/// @brief Opens the file, discarding its contents if they don't match the slots
+	auto open() -> void;
+
+	/// @brief The path of the file, or an empty path if there is none
+	std::filesystem::path _path;
+	/// @brief The fingerprint of the slots
+	std::uint64_t _layout { 0xcbf29ce484222325 };
+	/// @brief The number of slots assigned
+	std::size_t _slotCount { 0 };
+
+	/// @brief Used to open the file on first use
+	std::once_flag _opened;
+	/// @brief The file
+	MappedFile _file;
+	/// @brief The slots in the file, or an empty span if the file is not open
+	std::span<Slot> _slots;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
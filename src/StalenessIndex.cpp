@@ -0,0 +1,170 @@
+// Copyright (c) embedded ocean GmbH
+#include "StalenessIndex.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace xentara::plugins::templateDriver
+{
+
+auto StalenessIndex::Entry::beginUpdate() noexcept -> void
+{
+	if (!_list)
+	{
+		return;
+	}
+
+	// Start a new generation, waiting for a concurrent sweep to finish marking the old value as stale first
+	auto generation = _generation.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		if (generation & kExpiring) [[unlikely]]
+		{
+			std::this_thread::yield();
+			generation = _generation.load(std::memory_order_relaxed);
+		}
+		else if (_generation.compare_exchange_weak(generation, generation + 2, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			break;
+		}
+	}
+}
+
+auto StalenessIndex::Entry::refresh() -> void
+{
+	if (!_list)
+	{
+		return;
+	}
+
+	std::scoped_lock lock { _list->_mutex };
+	_refreshTime = Clock::now();
+	_refreshGeneration = _generation.load(std::memory_order_relaxed);
+	link();
+}
+
+auto StalenessIndex::Entry::remove() -> void
+{
+	if (!_list)
+	{
+		return;
+	}
+
+	std::scoped_lock lock { _list->_mutex };
+	unlink();
+}
+
+auto StalenessIndex::Entry::link() noexcept -> void
+{
+	// Move the entry to the back of the list
+	unlink();
+	_previous = _list->_last;
+	_next = nullptr;
+	(_previous ? _previous->_next : _list->_first) = this;
+	_list->_last = this;
+	_linked = true;
+}
+
+auto StalenessIndex::Entry::unlink() noexcept -> void
+{
+	if (!_linked)
+	{
+		return;
+	}
+
+	(_previous ? _previous->_next : _list->_first) = _next;
+	(_next ? _next->_previous : _list->_last) = _previous;
+	_previous = nullptr;
+	_next = nullptr;
+	_linked = false;
+}
+
+auto StalenessIndex::Entry::claim(std::uint64_t generation) noexcept -> bool
+{
+	// This fails if an update has started a new generation in the meantime
+	return _generation.compare_exchange_strong(generation, generation | kExpiring, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+auto StalenessIndex::attach(Entry &entry, std::optional<std::chrono::milliseconds> maxAge) -> void
+{
+	if (maxAge)
+	{
+		entry._list = &list(*maxAge);
+	}
+	else
+	{
+		_defaultEntries.push_back(&entry);
+	}
+}
+
+auto StalenessIndex::realize() -> void
+{
+	if (_defaultMaxAge)
+	{
+		auto &list = this->list(*_defaultMaxAge);
+		for (auto &&entry : _defaultEntries)
+		{
+			entry->_list = &list;
+		}
+	}
+
+	_defaultEntries = {};
+}
+
+auto StalenessIndex::sweep(std::chrono::system_clock::time_point timeStamp) -> void
+{
+	const auto now = Clock::now();
+
+	for (auto &&list : _lists)
+	{
+		// The entries are ordered by refresh time, so we can stop at the first one that is not overdue
+		const auto cutoff = now - list._maxAge;
+		for (;;)
+		{
+			// Take the first entry off the list if it is overdue. We only hold the lock while doing that, so that updates of
+			// other values are not held up while we commit.
+			Entry *entry = nullptr;
+			std::uint64_t generation = 0;
+			{
+				std::scoped_lock lock { list._mutex };
+				if (!list._first || list._first->_refreshTime > cutoff)
+				{
+					break;
+				}
+				entry = list._first;
+				generation = entry->_refreshGeneration;
+				entry->unlink();
+			}
+
+			// Mark the value as stale, unless it has been updated since it was refreshed. An update that started after this
+			// will wait for us, and then commit its value after ours.
+			if (entry->claim(generation))
+			{
+				try
+				{
+					entry->expire(timeStamp);
+				}
+				catch (...)
+				{
+					// Release the claim, so that updates can proceed
+					entry->_generation.store(generation, std::memory_order_release);
+					throw;
+				}
+				entry->_generation.store(generation, std::memory_order_release);
+			}
+		}
+	}
+}
+
+auto StalenessIndex::list(std::chrono::milliseconds maxAge) -> List &
+{
+	// Use the existing list, if there is one
+	if (auto existing = std::ranges::find_if(_lists, [&](const List &list) { return list._maxAge == maxAge; }); existing != _lists.end())
+	{
+		return *existing;
+	}
+
+	return _lists.emplace_front(maxAge);
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
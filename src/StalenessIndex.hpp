@@ -0,0 +1,178 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <forward_list>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief An index of the ages of the values of the data points of an I/O component, used to detect values that have not
+/// been updated for too long.
+///
+/// The data points are kept in one intrusive list for each distinct maximum age, ordered by the time of their last update.
+/// Updating a value moves its entry to the back of its list. Since all the entries in a list have the same maximum age, the
+/// entries at the front of each list are always the first to become overdue, so a sweep only needs to look at the entries
+/// that actually are overdue, and costs nothing per data point otherwise. No timers are needed for individual data points.
+///
+/// An entry that has been found to be overdue is removed from its list, so that it is only reported once. It is added
+/// again with its next valid value.
+///
+/// The lists are only locked while entries are moved, so values are committed concurrently. A generation counter in each
+/// entry ensures that a value that was updated after it was found to be overdue is not marked as stale.
+class StalenessIndex final : private utils::tools::Unique
+{
+public:
+	/// @brief The clock used to measure the ages
+	using Clock = std::chrono::steady_clock;
+
+	class List;
+
+	/// @brief Base class for the entries of data points
+	class Entry
+	{
+	public:
+		/// @brief Virtual destructor
+		/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+		/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+		/// instantiable by accident as a result of refactoring.
+		virtual ~Entry() = 0;
+
+		/// @brief Announces that the value is about to be updated.
+		///
+		/// This must be called before the new value is committed. It keeps a sweep that has already found the value to be
+		/// overdue from marking it as stale after the update. If the value is being marked as stale at this very moment,
+		/// this waits for that to finish, so that the new value is committed last.
+		auto beginUpdate() noexcept -> void;
+
+		/// @brief Records that the data point has received a valid value, and moves it to the back of its list.
+		///
+		/// This must be called after the new value has been committed.
+		auto refresh() -> void;
+
+		/// @brief Removes the entry from its list, because the data point no longer has a valid value.
+		///
+		/// This must be called after the new value has been committed.
+		auto remove() -> void;
+
+	private:
+		/// @brief Called by sweep() when the value has become overdue.
+		///
+		/// This is called without holding any locks, and the entry has already been removed from the list. It is never
+		/// called while the value is being updated.
+		/// @param timeStamp The time stamp to use for the change
+		virtual auto expire(std::chrono::system_clock::time_point timeStamp) -> void = 0;
+
+		/// @brief Moves the entry to the back of the list. The caller must hold the mutex of the list.
+		auto link() noexcept -> void;
+		/// @brief Removes the entry from the list, if it is in it. The caller must hold the mutex of the list.
+		auto unlink() noexcept -> void;
+
+		/// @brief Claims the value for marking it as stale
+		/// @param generation The generation the entry had when it was found to be overdue
+		/// @return true if the value has not been updated since, or false if it has been updated and must be left alone
+		auto claim(std::uint64_t generation) noexcept -> bool;
+
+		/// @brief The index manages the entries
+		friend class StalenessIndex;
+
+		/// @brief The bit set in the generation while the value is being marked as stale
+		static constexpr std::uint64_t kExpiring = 1;
+
+		/// @brief The list the entry belongs to, or nullptr if the data point has no maximum age
+		List *_list { nullptr };
+		/// @brief The previous entry in the list. This is protected by the mutex of the list.
+		Entry *_previous { nullptr };
+		/// @brief The next entry in the list. This is protected by the mutex of the list.
+		Entry *_next { nullptr };
+		/// @brief Whether the entry is currently in the list. This is protected by the mutex of the list.
+		bool _linked { false };
+		/// @brief The time the value was last refreshed. This is protected by the mutex of the list.
+		Clock::time_point _refreshTime;
+		/// @brief The generation of the value when it was last refreshed. This is protected by the mutex of the list.
+		std::uint64_t _refreshGeneration { 0 };
+		/// @brief The generation of the value.
+		///
+		/// This is incremented by two for each update, and has the kExpiring bit set while the value is being marked as
+		/// stale.
+		std::atomic<std::uint64_t> _generation { 0 };
+	};
+
+	/// @brief The entries that share the same maximum age
+	class List final : private utils::tools::Unique
+	{
+	public:
+		/// @brief Constructor
+		explicit List(std::chrono::milliseconds maxAge) noexcept : _maxAge(maxAge)
+		{
+		}
+
+	private:
+		/// @brief The entries access the list directly
+		friend class Entry;
+		/// @brief The index manages the lists
+		friend class StalenessIndex;
+
+		/// @brief The maximum age of the entries
+		std::chrono::milliseconds _maxAge;
+		/// @brief A mutex protecting the links of the entries. The mutex is only held while an entry is moved, never while
+		/// a value is committed.
+		std::mutex _mutex;
+		/// @brief The entry that was refreshed the longest time ago
+		Entry *_first { nullptr };
+		/// @brief The entry that was refreshed last
+		Entry *_last { nullptr };
+	};
+
+	/// @brief Adds an entry to the index.
+	///
+	/// This function must only be called while the configuration is being loaded.
+	/// @param entry The entry
+	/// @param maxAge The maximum age of the value, or std::nullopt to use the default maximum age of the I/O component, which
+	/// may not have been loaded yet.
+	auto attach(Entry &entry, std::optional<std::chrono::milliseconds> maxAge) -> void;
+
+	/// @brief Sets the maximum age for data points that don't have one of their own
+	auto setDefaultMaxAge(std::chrono::milliseconds maxAge) noexcept -> void
+	{
+		_defaultMaxAge = maxAge;
+	}
+
+	/// @brief Assigns the default maximum age to the entries that don't have one of their own.
+	///
+	/// This must be called after the configuration has been loaded, and before any values are updated.
+	auto realize() -> void;
+
+	/// @brief Checks whether any data points have a maximum age
+	auto empty() const noexcept -> bool
+	{
+		return _lists.empty();
+	}
+
+	/// @brief Reports all the values that have become overdue
+	/// @param timeStamp The time stamp to use for the changes
+	auto sweep(std::chrono::system_clock::time_point timeStamp) -> void;
+
+private:
+	/// @brief Returns the list for a maximum age, creating it if necessary
+	auto list(std::chrono::milliseconds maxAge) -> List &;
+
+	/// @brief The lists, one for each distinct maximum age
+	std::forward_list<List> _lists;
+
+	/// @brief The maximum age of data points that don't have one of their own, or std::nullopt if there is none
+	std::optional<std::chrono::milliseconds> _defaultMaxAge;
+	/// @brief The entries waiting for the default maximum age. This is cleared by realize().
+	std::vector<Entry *> _defaultEntries;
+};
+
+inline StalenessIndex::Entry::~Entry() = default;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "TemplateInput.hpp"
 
 #include "AbstractTemplateInputHandler.hpp"
+#include "BitAddress.hpp"
+#include "PackedBitInputHandler.hpp"
 #include "Tasks.hpp"
 #include "TemplateInputHandler.hpp"
 
@@ -22,13 +24,45 @@ using namespace std::literals;
 
 auto TemplateInput::load(utils::json::decoder::Object &jsonObject, config::Context &context) -> void
 {
+	std::size_t historySize = 0;
+	std::optional<std::chrono::milliseconds> maxAge;
+
 	// Go through all the members of the JSON object that represents this object
 	for (auto && [name, value] : jsonObject)
     {
-		if (name == "dataType"sv)
+		if (name == "dataType"sv || name == "bit"sv)
 		{
+			// Make sure that only one of the two was specified
+			if (_handler)
+			{
+				/// @todo replace "template input" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value,
+					std::runtime_error("template input must specify either a data type or a bit address, but not both"));
+			}
+
 			// Create the handler
-			_handler = createHandler(value);
+			_handler = name == "bit"sv ? createBitHandler(value) : createHandler(value);
+		}
+		else if (name == "connectionEvents"sv)
+		{
+			_connectionEvents = value.asBool();
+		}
+		else if (name == "essential"sv)
+		{
+			_essential = value.asBool();
+		}
+		else if (name == "maxAge"sv)
+		{
+			maxAge = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (*maxAge <= std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template input" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("maxAge of template input must be positive"));
+			}
+		}
+		else if (name == "historySize"sv)
+		{
+			historySize = value.asNumber<std::size_t>();
 		}
 		/// @todo load custom configuration parameters
 		else if (name == "TODO"sv)
@@ -55,8 +89,18 @@ auto TemplateInput::load(utils::json::decoder::Object &jsonObject, config::Conte
 	if (!_handler)
 	{
 		/// @todo replace "template input" with a more descriptive name
-		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("Missing data type in template input"));
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("Missing data type or bit address in template input"));
+	}
+	// Enable the history, if requested
+	if (historySize > 0 && !_handler->enableHistory(_ioComponent.get().arena(), historySize))
+	{
+		/// @todo replace "template input" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("history is not supported for the data type of template input"));
 	}
+	// Keep the last known value in the snapshot of the I/O component
+	_handler->enableSnapshot(_ioComponent.get().snapshot());
+	// Detect values that are not updated for too long
+	_handler->enableStaleness(_ioComponent.get().arena(), _ioComponent.get().stalenessIndex(), maxAge);
 	/// @todo perform consistency and completeness checks
 	if (!"TODO")
 	{
@@ -65,59 +109,62 @@ auto TemplateInput::load(utils::json::decoder::Object &jsonObject, config::Conte
 	}
 }
 
-auto TemplateInput::createHandler(utils::json::decoder::Value &value) -> std::unique_ptr<AbstractTemplateInputHandler>
+auto TemplateInput::createHandler(utils::json::decoder::Value &value) -> AbstractTemplateInputHandler *
 {
 	// Get the keyword from the value
 	auto keyword = value.asString<std::string>();
+
+	// Handlers are allocated in the arena of the I/O component
+	auto &arena = _ioComponent.get().arena();
 	
 	/// @todo use keywords that are appropriate to the I/O component
 	if (keyword == "bool"sv)
 	{
-		return std::make_unique<TemplateInputHandler<bool>>();
+		return &arena.make<TemplateInputHandler<bool>>();
 	}
 	else if (keyword == "uint8"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::uint8_t>>();
+		return &arena.make<TemplateInputHandler<std::uint8_t>>();
 	}
 	else if (keyword == "uint16"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::uint16_t>>();
+		return &arena.make<TemplateInputHandler<std::uint16_t>>();
 	}
 	else if (keyword == "uint32"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::uint32_t>>();
+		return &arena.make<TemplateInputHandler<std::uint32_t>>();
 	}
 	else if (keyword == "uint64"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::uint64_t>>();
+		return &arena.make<TemplateInputHandler<std::uint64_t>>();
 	}
 	else if (keyword == "int8"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::int8_t>>();
+		return &arena.make<TemplateInputHandler<std::int8_t>>();
 	}
 	else if (keyword == "int16"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::int16_t>>();
+		return &arena.make<TemplateInputHandler<std::int16_t>>();
 	}
 	else if (keyword == "int32"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::int32_t>>();
+		return &arena.make<TemplateInputHandler<std::int32_t>>();
 	}
 	else if (keyword == "int64"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::int64_t>>();
+		return &arena.make<TemplateInputHandler<std::int64_t>>();
 	}
 	else if (keyword == "float32"sv)
 	{
-		return std::make_unique<TemplateInputHandler<float>>();
+		return &arena.make<TemplateInputHandler<float>>();
 	}
 	else if (keyword == "float64"sv)
 	{
-		return std::make_unique<TemplateInputHandler<double>>();
+		return &arena.make<TemplateInputHandler<double>>();
 	}
 	else if (keyword == "string"sv)
 	{
-		return std::make_unique<TemplateInputHandler<std::string>>();
+		return &arena.make<TemplateInputHandler<std::string>>();
 	}
 
 	// The keyword is not known
@@ -127,7 +174,34 @@ auto TemplateInput::createHandler(utils::json::decoder::Value &value) -> std::un
 		utils::json::decoder::throwWithLocation(value, std::runtime_error("unknown data type in template input"));
 	}
 
-	return std::unique_ptr<AbstractTemplateInputHandler>();
+	return nullptr;
+}
+
+auto TemplateInput::createBitHandler(utils::json::decoder::Value &value) -> AbstractTemplateInputHandler *
+{
+	// Parse the address, which has the form "word.bit"
+	const auto address = BitAddress::parse(value.asString<std::string>());
+	if (!address)
+	{
+		/// @todo replace "template input" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("malformed bit address in template input"));
+	}
+	if (address->_bit >= PackedInputWord::kBitsPerWord)
+	{
+		/// @todo replace "template input" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("bit index of template input is out of range"));
+	}
+
+	// Create the handler in the arena and attach it to the shared word
+	auto &ioComponent = _ioComponent.get();
+	auto &handler = ioComponent.arena().make<PackedBitInputHandler>(ioComponent.packedInputWord(address->_word));
+	if (!handler.attach(address->_bit))
+	{
+		/// @todo replace "template input" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("bit address is used by more than one template input"));
+	}
+
+	return &handler;
 }
 
 auto TemplateInput::performReadTask(const process::ExecutionContext &context) -> void
@@ -139,14 +213,50 @@ auto TemplateInput::performReadTask(const process::ExecutionContext &context) ->
 		throw std::logic_error("internal error: \"read\" task of xentara::plugins::templateDriver::TemplateInput executed before configuration has been loaded");
 	}
 
-	// Only perform the reconnect if we are supposed to be connected in the first place
-	if (!_ioComponent.get().connected())
+	// Only perform the read if the I/O component is connected. The lease keeps the connection from being torn down
+	// while we are using it.
+	const auto lease = _ioComponent.get().lease();
+	if (!lease)
+	{
+		return;
+	}
+
+	// Send any pending writes of the I/O component first, because writes take priority over reads
+	if (auto &writeLane = _ioComponent.get().writeLane(); !writeLane.empty())
 	{
+		writeLane.drain(lease, context.scheduledTime());
+	}
+
+	// Skip the read if the circuit breaker of the I/O component is open, unless the value is essential or this is a probe
+	auto &circuitBreaker = _ioComponent.get().circuitBreaker();
+	auto &rateLimiter = lease.session().rateLimiter();
+	const auto admission = circuitBreaker.admit(_essential);
+	if (admission == CircuitBreaker::Admission::Rejected)
+	{
+		// Don't hold up the other data points if it is our turn to read
+		rateLimiter.skipTurn(_rateLimitTicket);
+		return;
+	}
+
+	// Respect the rate limit of the device. We never wait for the limit, because that would hold up the thread of the task. Instead,
+	// data points that had to skip a read take turns, so that data points whose tasks happen to run last don't starve.
+	if (!rateLimiter.tryAcquireInTurn(1, _rateLimitTicket))
+	{
+		if (admission == CircuitBreaker::Admission::Probe)
+		{
+			circuitBreaker.finishProbe(false);
+		}
 		return;
 	}
 
 	// Ask the handler to read the data
-	_handler->read(context.scheduledTime(), *this);
+	_handler->read(lease, context.scheduledTime(), *this);
+
+	// If the read was a probe, the circuit breaker closes again unless the read reported an error
+	if (admission == CircuitBreaker::Admission::Probe)
+	{
+		circuitBreaker.finishProbe(true);
+	}
 }
 
 auto TemplateInput::dataType() const -> const data::DataType &
@@ -255,14 +365,15 @@ auto TemplateInput::ioComponentStateChanged(std::chrono::system_clock::time_poin
 	auto effectiveError = error ? error : CustomError::NoData;
 
 	// Ask the handler to update its state. We do not notify the I/O component, because that is who this message comes from in the first place.
-	_handler->updateState(timeStamp, effectiveError);
+	_handler->updateState(timeStamp, effectiveError, _connectionEvents);
 }
 
-auto TemplateInput::handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error)
+auto TemplateInput::handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error)
 	-> void
 {
 	// Just notify the I/O component. The handler will have updated its state already, before calling this function.
-	_ioComponent.get().handleError(timeStamp, error, this);
+	_ioComponent.get().circuitBreaker().recordError();
+	_ioComponent.get().handleError(lease, timeStamp, error, this);
 }
 
 } // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "TemplateIoComponent.hpp"
+#include "RateLimiter.hpp"
 #include "ReadState.hpp"
 #include "ReadTask.hpp"
 #include "AbstractTemplateInputHandler.hpp"
@@ -68,16 +69,32 @@ public:
 	/// @name Virtual Overrides for AbstractTemplateInputHandler::ErrorSink
 	/// @{
 	
-	auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+	auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
 
 	/// @}
 
+	/// @brief Calls a function for each value in the history of the input that was read at or after a certain time.
+	///
+	/// The history is recorded in memory when the values are read, so querying it causes no communication with the device.
+	/// @param since The time stamp of the oldest value of interest
+	/// @param function The function to call
+	/// @return true if the history was read, or false if no history is being recorded for this input
+	auto readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool
+	{
+		return _handler && _handler->readHistory(since, function);
+	}
+
 private:
 	/// @brief The read task needs access to out private member functions
 	friend class ReadTask<TemplateInput>;
 
 	/// @brief Creates an input handler based on a configuration value
-	auto createHandler(utils::json::decoder::Value &value) -> std::unique_ptr<AbstractTemplateInputHandler>;
+	/// @return The handler, which is allocated in the arena of the I/O component
+	auto createHandler(utils::json::decoder::Value &value) -> AbstractTemplateInputHandler *;
+	/// @brief Creates a handler for a boolean input that refers to a bit of a word on the device
+	/// @param value The configuration value containing the bit address, in the form "word.bit"
+	/// @return The handler, which is allocated in the arena of the I/O component
+	auto createBitHandler(utils::json::decoder::Value &value) -> AbstractTemplateInputHandler *;
 
 	/// @brief This function is forwarded to the I/O component.
 	auto requestConnect(std::chrono::system_clock::time_point timeStamp) noexcept -> void
@@ -111,8 +128,24 @@ private:
 	/// @todo give this a more descriptive name, e.g. "_device"
 	std::reference_wrapper<TemplateIoComponent> _ioComponent;
 
-	/// @brief The handler for data type specific functionality, or nullptr, if the data type hans not been loaded yet
-	std::unique_ptr<AbstractTemplateInputHandler> _handler;
+	/// @brief The handler for data type specific functionality, or nullptr, if the data type hans not been loaded yet.
+	///
+	/// The handler is allocated in the arena of the I/O component, so that the handlers of all the data points of the
+	/// component lie close together in memory, in configuration order.
+	AbstractTemplateInputHandler *_handler { nullptr };
+
+	/// @brief Whether to raise the *changed* event when the data is invalidated because the state of the I/O component changed.
+	///
+	/// This is false by default, so that losing the connection to a device with many data points does not cause a burst of
+	/// events. Clients that are not interested in individual data points can use the *connected* and *disconnected* events of the
+	/// I/O component instead.
+	bool _connectionEvents { false };
+
+	/// @brief Whether the value is read even while the circuit breaker of the I/O component is open
+	bool _essential { false };
+	/// @brief Our place in the queue of data points waiting for the rate limit of the I/O component, if we had to skip a read.
+	/// This is only accessed by the "read" task.
+	RateLimiter::Ticket _rateLimitTicket;
 
 	/// @brief The "read" task
 	ReadTask<TemplateInput> _readTask { *this };
@@ -18,40 +18,46 @@ template <typename ValueType>
 const model::Attribute TemplateInputHandler<ValueType>::kValueAttribute { model::Attribute::kValue, model::Attribute::Access::ReadOnly, staticDataType() };
 
 template <typename ValueType>
-auto TemplateInputHandler<ValueType>::read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+auto TemplateInputHandler<ValueType>::read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
 {
 	try
 	{
 		// Call the other read function, but catch exceptions.
-		doRead(timeStamp);
+		doRead(lease, timeStamp);
 	}
 	catch (const std::exception &)
 	{
 		// Get the error from the current exception using this special utility function
 		const auto error = utils::eh::currentErrorCode();
 		// Handle the error
-		handleReadError(timeStamp, error, errorSink);
+		handleReadError(lease, timeStamp, error, errorSink);
 	}
 }
 
 template <typename ValueType>
-auto TemplateInputHandler<ValueType>::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error)
+auto TemplateInputHandler<ValueType>::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents)
 	-> void
 {
-	_state.update(timeStamp, utils::eh::unexpected(error));
+	_state.update(timeStamp, utils::eh::unexpected(error), raiseEvents);
 }
 
 template <typename ValueType>
-auto TemplateInputHandler<ValueType>::doRead(std::chrono::system_clock::time_point timeStamp) -> void
+auto TemplateInputHandler<ValueType>::doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
 {
-	/// @todo read the value
+	/// @todo read the value using a Transport::Batch on lease.handle().transport(), decoding the value directly from
+	/// batch.response(), and fill in the sample time provided by the device and/or the receive time provided by the transport,
+	/// if available.
+	//
+	// If reading the value takes several round trips, it can be read by a coroutine returning Transaction<> instead, using
+	// co_await lease.session().reactor().exchange() for each step. See TemplateOutputHandler::doWrite() for details.
 	ValueType value = {};
+	SampleClock::ResponseTimes responseTimes;
 
 	/// @todo if the read function does not throw errors, but uses return types or internal handle state,
 	// throw an std::system_error here on failure, or call handleReadError() directly.
 
-	// The read was successful
-	_state.update(timeStamp, value);
+	// The read was successful. Stamp the value using the configured time stamp source.
+	_state.update(lease.session().sampleClock().timeStamp(timeStamp, responseTimes), value);
 
 	/// @todo it may be advantageous to split this function up according to value type, either using explicit 
 	/// template specialization, or using if constexpr().
@@ -81,13 +87,13 @@ auto TemplateInputHandler<ValueType>::doRead(std::chrono::system_clock::time_poi
 }
 
 template <typename ValueType>
-auto TemplateInputHandler<ValueType>::handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
+auto TemplateInputHandler<ValueType>::handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
 	-> void
 {
 	// Update our own state
 	_state.update(timeStamp, utils::eh::unexpected(error));
 	// Notify the error sink
-	errorSink.handleReadError(timeStamp, error);
+	errorSink.handleReadError(lease, timeStamp, error);
 }
 
 template <typename ValueType>
@@ -36,10 +36,30 @@ public:
 	auto makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle> final;
 
 	auto realize() -> void final;
+
+	auto enableHistory(Arena &arena, std::size_t size) -> bool final
+	{
+		return _state.enableHistory(arena, size);
+	}
+
+	auto readHistory(std::chrono::system_clock::time_point since, const HistoryFunction &function) const -> bool final
+	{
+		return _state.readHistory(since, function);
+	}
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final
+	{
+		_state.enableSnapshot(snapshot);
+	}
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void final
+	{
+		_state.enableStaleness(arena, index, maxAge);
+	}
 		
-	auto read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
+	auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
 
-	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void final;
 	
 	///@}
 
@@ -50,9 +70,9 @@ public:
 
 private:
 	/// @brief The actual implementation of read(), which may throw exceptions on error.
-	auto doRead(std::chrono::system_clock::time_point timeStamp) -> void;
+	auto doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
 	/// @brief Handles a read error
-	auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
+	auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
 
 	/// @brief Determines the correct data type based on the *ValueType* template parameter
 	///
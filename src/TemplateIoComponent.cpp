@@ -2,11 +2,18 @@
 #include "TemplateIoComponent.hpp"
 
 #include "Attributes.hpp"
+#include "Events.hpp"
+#include "PointRange.hpp"
+#include "ProfileRange.hpp"
+#include "ReceiveTimeStamp.hpp"
+#include "Tasks.hpp"
 #include "TemplateInput.hpp"
 #include "TemplateOutput.hpp"
+#include "TimingWheel.hpp"
 
 #include <xentara/config/Errors.hpp>
 #include <xentara/data/ReadHandle.hpp>
+#include <xentara/data/WriteHandle.hpp>
 #include <xentara/memory/memoryResources.hpp>
 #include <xentara/memory/WriteSentinel.hpp>
 #include <xentara/model/Attribute.hpp>
@@ -17,10 +24,17 @@
 #include <xentara/process/ExecutionContext.hpp>
 #include <xentara/skill/ElementFactory.hpp>
 #include <xentara/utils/eh/currentErrorCode.hpp>
+#include <xentara/utils/json/decoder/Array.hpp>
 #include <xentara/utils/json/decoder/Object.hpp>
 #include <xentara/utils/json/decoder/Errors.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
 #include <string_view>
+#include <system_error>
+#include <unordered_set>
 
 #ifdef _WIN32
 #	include <Windows.h>
@@ -38,71 +52,948 @@ auto TemplateIoComponent::load(utils::json::decoder::Object &jsonObject, config:
 	// Go through all the members of the JSON object that represents this object
 	for (auto && [name, value] : jsonObject)
     {
+		if (name == "pointRanges"sv)
+		{
+			// Collect the names of all the attributes, so that duplicates can be detected. No point ranges have been added yet, so
+			// forEachAttribute() only lists our own attributes.
+			std::unordered_set<std::string_view> attributeNames;
+			forEachAttribute([&](const model::Attribute &attribute) {
+				attributeNames.insert(attribute.name());
+				return false;
+			});
+
+			// Load all the ranges in the array
+			for (auto &&element : value.asArray())
+			{
+				auto &range = loadPointRange(element);
+				range.publish();
+				for (auto &&attributeName : range.attributeNames())
+				{
+					if (!attributeNames.insert(attributeName).second)
+					{
+						/// @todo replace "template I/O component" with a more descriptive name
+						utils::json::decoder::throwWithLocation(element,
+							std::runtime_error("point range in template I/O component uses the attribute name \"" + attributeName +
+								"\", which is already in use"));
+					}
+				}
+				range.enableSnapshot(_snapshot);
+				range.enableStaleness(_arena, _stalenessIndex);
+				_pointRanges.push_back(range);
+			}
+		}
+		else if (name == "ioThread"sv)
+		{
+			_threadOptions = loadThreadOptions(value);
+		}
+		else if (name == "rateLimit"sv)
+		{
+			_rateLimiter.limitDevice(loadRateLimit(value));
+		}
+		else if (name == "link"sv)
+		{
+			std::string link;
+			const auto options = loadRateLimit(value, &link);
+			auto bucket = RateLimiter::link(link, options);
+			if (!bucket)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value,
+					std::runtime_error("link of template I/O component has a different rate limit than other I/O components on the same link"));
+			}
+			_rateLimiter.limitLink(std::move(bucket));
+		}
+		else if (name == "circuitBreaker"sv)
+		{
+			_circuitBreakerOptions = loadCircuitBreakerOptions(value);
+		}
+		else if (name == "trace"sv)
+		{
+			loadTraceOptions(value);
+		}
+		else if (name == "immediateWrites"sv)
+		{
+			_immediateWrites = value.asBool();
+		}
+		else if (name == "writeCoalescingWindow"sv)
+		{
+			_writeCoalescingWindow = std::chrono::microseconds(value.asNumber<std::chrono::microseconds::rep>());
+			if (_writeCoalescingWindow < std::chrono::microseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("negative write coalescing window in template I/O component"));
+			}
+		}
+		else if (name == "writeCoalescingLimit"sv)
+		{
+			_writeCoalescingLimit = value.asNumber<std::size_t>();
+			if (_writeCoalescingLimit == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("writeCoalescingLimit of template I/O component must not be zero"));
+			}
+		}
+		else if (name == "timeStampSource"sv)
+		{
+			const auto source = SampleClock::parseSource(value.asString<std::string>());
+			if (!source)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("unknown time stamp source in template I/O component"));
+			}
+			_sampleClock.setSource(*source);
+		}
+		else if (name == "timeoutsBeforeDisconnect"sv)
+		{
+			_timeoutsBeforeDisconnect = value.asNumber<std::size_t>();
+			if (_timeoutsBeforeDisconnect == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("timeoutsBeforeDisconnect of template I/O component must be at least 1"));
+			}
+		}
+		else if (name == "reconnectBackoff"sv)
+		{
+			_reconnectBackoff = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (_reconnectBackoff < std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("negative reconnect backoff in template I/O component"));
+			}
+		}
+		else if (name == "maxReconnectBackoff"sv)
+		{
+			_maxReconnectBackoff = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (_maxReconnectBackoff < std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("negative maximum reconnect backoff in template I/O component"));
+			}
+		}
+		else if (name == "sessions"sv)
+		{
+			_sessionCount = value.asNumber<std::size_t>();
+			if (_sessionCount == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("template I/O component must have at least one session"));
+			}
+		}
+		else if (name == "endpoints"sv)
+		{
+			for (auto &&element : value.asArray())
+			{
+				/// @todo parse and validate the endpoint address
+				_endpoints.push_back(element.asString<std::string>());
+			}
+			if (_endpoints.empty())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("empty list of endpoints in template I/O component"));
+			}
+		}
+		else if (name == "heartbeatInterval"sv)
+		{
+			_heartbeatInterval = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (_heartbeatInterval < std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("negative heartbeat interval in template I/O component"));
+			}
+		}
+		else if (name == "maxAge"sv)
+		{
+			const auto maxAge = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (maxAge <= std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("maxAge of template I/O component must be positive"));
+			}
+			_stalenessIndex.setDefaultMaxAge(maxAge);
+		}
+		else if (name == "snapshotFile"sv)
+		{
+			_snapshot.setFile(value.asString<std::string>());
+		}
+		else if (name == "forwardQueueFile"sv)
+		{
+			_forwardQueueFile = value.asString<std::string>();
+		}
+		else if (name == "forwardQueueSize"sv)
+		{
+			_forwardQueueSize = value.asNumber<std::size_t>();
+			if (_forwardQueueSize == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("forwardQueueSize of template I/O component must not be zero"));
+			}
+		}
+		else if (name == "forwardQueueOverflow"sv)
+		{
+			const auto policy = ForwardQueue::parseOverflowPolicy(value.asString<std::string>());
+			if (!policy)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("unknown forward queue overflow policy in template I/O component"));
+			}
+			_forwardQueueOverflow = *policy;
+		}
 		/// @todo load configuration parameters
-		if (name == "TODO"sv)
+		else if (name == "TODO"sv)
+		{
+			/// @todo parse the value correctly
+			auto todo = value.asNumber<std::uint64_t>();
+
+			/// @todo check that the value is valid
+			if (!"TODO")
+			{
+				/// @todo use an error message that tells the user exactly what is wrong
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("TODO is wrong with TODO parameter of template I/O component"));
+			}
+
+			/// @todo set the appropriate member variables
+		}
+		else
+		{
+            config::throwUnknownParameterError(name);
+		}
+    }
+
+	/// @todo perform consistency and completeness checks
+	if (!"TODO")
+	{
+		/// @todo use an error message that tells the user exactly what is wrong
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("TODO is wrong with template I/O component"));
+	}
+
+	// Create the sessions to each endpoint. They all share the same clock, because they all talk to the same device, and the same reactor.
+	const auto endpointCount = std::max<std::size_t>(_endpoints.size(), 1);
+	_sessions = _arena.makeArray<Session>(_sessionCount * endpointCount);
+	for (std::size_t index = 0; index < _sessions.size(); ++index)
+	{
+		auto &session = _sessions[index];
+		session._endpoint = index / _sessionCount;
+		session._sampleClock = &_sampleClock;
+		session._reactor = &_reactor;
+		session._rateLimiter = &_rateLimiter;
+	}
+	_endpointSessionCounts = _arena.makeArray<std::size_t>(endpointCount);
+}
+
+auto TemplateIoComponent::loadPointRange(utils::json::decoder::Value &value) -> AbstractPointRange &
+{
+	auto jsonObject = value.asObject();
+
+	AbstractPointRange::Layout layout;
+	std::string dataType;
+	std::string deviceProfile;
+	bool essential = false;
+	bool countLoaded = false;
+	bool strideLoaded = false;
+
+	// Go through all the members of the JSON object that represents the range
+	for (auto && [name, memberValue] : jsonObject)
+	{
+		if (name == "name"sv)
+		{
+			layout._namePattern = memberValue.asString<std::string>();
+
+			// The pattern must contain a placeholder for the index, or all the points would have the same name
+			if (layout._namePattern.find("{}"sv) == std::string::npos)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue,
+					std::runtime_error("name pattern of point range in template I/O component does not contain the placeholder \"{}\""));
+			}
+		}
+		else if (name == "dataType"sv)
+		{
+			dataType = memberValue.asString<std::string>();
+		}
+		else if (name == "deviceProfile"sv)
+		{
+			deviceProfile = memberValue.asString<std::string>();
+		}
+		else if (name == "baseAddress"sv)
+		{
+			layout._baseAddress = memberValue.asNumber<std::uint64_t>();
+		}
+		else if (name == "count"sv)
+		{
+			layout._count = memberValue.asNumber<std::size_t>();
+			if (layout._count == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("empty point range in template I/O component"));
+			}
+			countLoaded = true;
+		}
+		else if (name == "stride"sv)
+		{
+			layout._stride = memberValue.asNumber<std::uint64_t>();
+			if (layout._stride == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("stride of point range in template I/O component is zero"));
+			}
+			strideLoaded = true;
+		}
+		else if (name == "essential"sv)
+		{
+			essential = memberValue.asBool();
+		}
+		else
+		{
+			config::throwUnknownParameterError(name);
+		}
+	}
+
+	// Ranges with a device profile get their registers from the profile
+	if (!deviceProfile.empty())
+	{
+		if (layout._namePattern.empty() || !dataType.empty() || countLoaded || strideLoaded)
+		{
+			/// @todo replace "template I/O component" with a more descriptive name
+			utils::json::decoder::throwWithLocation(jsonObject,
+				std::runtime_error("point range with device profile in template I/O component must specify a name, and no data type, count, or stride"));
+		}
+
+		auto range = createProfileRange(deviceProfile, std::move(layout));
+		if (!range)
+		{
+			/// @todo replace "template I/O component" with a more descriptive name
+			utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("unknown device profile in point range of template I/O component"));
+		}
+
+		range->setEssential(essential);
+		return *range;
+	}
+
+	// Make sure that all the mandatory parameters were specified
+	if (layout._namePattern.empty() || dataType.empty() || !countLoaded)
+	{
+		/// @todo replace "template I/O component" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject,
+			std::runtime_error("point range in template I/O component must specify name, data type, and count"));
+	}
+	// Make sure the addresses don't overflow
+	if ((layout._count - 1) > (std::numeric_limits<std::uint64_t>::max() - layout._baseAddress) / layout._stride)
+	{
+		/// @todo replace "template I/O component" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("point range in template I/O component exceeds the address space"));
+	}
+
+	// Create the range
+	auto range = createPointRange(dataType, std::move(layout));
+	if (!range)
+	{
+		/// @todo replace "template I/O component" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("unknown data type in point range of template I/O component"));
+	}
+
+	range->setEssential(essential);
+	return *range;
+}
+
+auto TemplateIoComponent::loadThreadOptions(utils::json::decoder::Value &value) -> ThreadOptions
+{
+	auto jsonObject = value.asObject();
+
+	ThreadOptions options;
+
+	// Go through all the members of the JSON object that represents the options
+	for (auto && [name, memberValue] : jsonObject)
+	{
+		if (name == "cpus"sv)
+		{
+			const auto cpuLimit = ThreadOptions::cpuLimit();
+			for (auto &&element : memberValue.asArray())
+			{
+				const auto cpu = element.asNumber<unsigned>();
+				if (cpu >= cpuLimit)
+				{
+					/// @todo replace "template I/O component" with a more descriptive name
+					utils::json::decoder::throwWithLocation(element, std::runtime_error(
+						"CPU index of I/O thread of template I/O component exceeds the number of CPUs in the system"));
+				}
+				options._cpus.push_back(cpu);
+			}
+		}
+		else if (name == "priority"sv)
+		{
+			options._priority = memberValue.asNumber<int>();
+			if (options._priority < 0 || options._priority > 99)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue,
+					std::runtime_error("real-time priority of I/O thread of template I/O component must be between 0 and 99"));
+			}
+		}
+		else if (name == "lockMemory"sv)
+		{
+			options._lockMemory = memberValue.asBool();
+		}
+		else
+		{
+			config::throwUnknownParameterError(name);
+		}
+	}
+
+	return options;
+}
+
+auto TemplateIoComponent::loadRateLimit(utils::json::decoder::Value &value, std::string *link) -> RateLimiter::Options
+{
+	auto jsonObject = value.asObject();
+
+	RateLimiter::Options options;
+	bool rateLoaded = false;
+
+	// Go through all the members of the JSON object that represents the rate limit
+	for (auto && [name, memberValue] : jsonObject)
+	{
+		if (name == "requestsPerSecond"sv)
+		{
+			options._requestsPerSecond = memberValue.asNumber<double>();
+			if (!(options._requestsPerSecond > 0))
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("rate limit of template I/O component must be positive"));
+			}
+			rateLoaded = true;
+		}
+		else if (name == "burst"sv)
+		{
+			options._burst = memberValue.asNumber<std::size_t>();
+			if (options._burst == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("burst size of template I/O component must be at least 1"));
+			}
+		}
+		else if (link && name == "name"sv)
+		{
+			*link = memberValue.asString<std::string>();
+		}
+		else
+		{
+			config::throwUnknownParameterError(name);
+		}
+	}
+
+	// Make sure that all the mandatory parameters were specified
+	if (!rateLoaded || (link && link->empty()))
+	{
+		/// @todo replace "template I/O component" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error(link
+			? "link of template I/O component must specify a name and requestsPerSecond"
+			: "rate limit of template I/O component must specify requestsPerSecond"));
+	}
+
+	return options;
+}
+
+auto TemplateIoComponent::loadCircuitBreakerOptions(utils::json::decoder::Value &value) -> CircuitBreaker::Options
+{
+	auto jsonObject = value.asObject();
+
+	CircuitBreaker::Options options;
+
+	// Go through all the members of the JSON object that represents the options
+	for (auto && [name, memberValue] : jsonObject)
+	{
+		if (name == "errorRate"sv)
+		{
+			options._errorRate = memberValue.asNumber<double>();
+			if (!(options._errorRate > 0 && options._errorRate <= 1))
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue,
+					std::runtime_error("error rate of circuit breaker of template I/O component must be greater than 0 and at most 1"));
+			}
+		}
+		else if (name == "minimumReads"sv)
+		{
+			options._minimumReads = memberValue.asNumber<std::size_t>();
+		}
+		else if (name == "window"sv)
+		{
+			options._window = std::chrono::milliseconds(memberValue.asNumber<std::chrono::milliseconds::rep>());
+			if (options._window <= std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("window of circuit breaker of template I/O component must be positive"));
+			}
+		}
+		else if (name == "probeInterval"sv)
+		{
+			options._probeInterval = std::chrono::milliseconds(memberValue.asNumber<std::chrono::milliseconds::rep>());
+			if (options._probeInterval < std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("negative probe interval of circuit breaker in template I/O component"));
+			}
+		}
+		else
+		{
+			config::throwUnknownParameterError(name);
+		}
+	}
+
+	return options;
+}
+
+auto TemplateIoComponent::loadTraceOptions(utils::json::decoder::Value &value) -> void
+{
+	auto jsonObject = value.asObject();
+
+	// Go through all the members of the JSON object that represents the options
+	for (auto && [name, memberValue] : jsonObject)
+	{
+		if (name == "file"sv)
+		{
+			_traceFile = memberValue.asString<std::string>();
+		}
+		else if (name == "bufferSize"sv)
+		{
+			_traceBufferSize = memberValue.asNumber<std::size_t>();
+			if (_traceBufferSize == 0)
+			{
+				/// @todo replace "template I/O component" with a more descriptive name
+				utils::json::decoder::throwWithLocation(memberValue, std::runtime_error("trace buffer size of template I/O component must not be zero"));
+			}
+		}
+		else
+		{
+			config::throwUnknownParameterError(name);
+		}
+	}
+
+	if (_traceFile.empty())
+	{
+		/// @todo replace "template I/O component" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("missing trace file in template I/O component"));
+	}
+}
+
+auto TemplateIoComponent::dumpTrace() noexcept -> void
+{
+	if (_traceFile.empty())
+	{
+		return;
+	}
+
+	try
+	{
+		Trace::dump(_traceFile);
+	}
+	catch (...)
+	{
+		// The trace is a diagnostic aid only, so failing to write it must not affect the operation of the component
+	}
+}
+
+auto TemplateIoComponent::createPointRange(std::string_view keyword, AbstractPointRange::Layout layout) -> AbstractPointRange *
+{
+	/// @todo use keywords that are appropriate to the I/O component, and that match the ones used by TemplateInput
+	if (keyword == "bool"sv)
+	{
+		return &_arena.make<PointRange<bool>>(std::move(layout));
+	}
+	else if (keyword == "uint8"sv)
+	{
+		return &_arena.make<PointRange<std::uint8_t>>(std::move(layout));
+	}
+	else if (keyword == "uint16"sv)
+	{
+		return &_arena.make<PointRange<std::uint16_t>>(std::move(layout));
+	}
+	else if (keyword == "uint32"sv)
+	{
+		return &_arena.make<PointRange<std::uint32_t>>(std::move(layout));
+	}
+	else if (keyword == "uint64"sv)
+	{
+		return &_arena.make<PointRange<std::uint64_t>>(std::move(layout));
+	}
+	else if (keyword == "int8"sv)
+	{
+		return &_arena.make<PointRange<std::int8_t>>(std::move(layout));
+	}
+	else if (keyword == "int16"sv)
+	{
+		return &_arena.make<PointRange<std::int16_t>>(std::move(layout));
+	}
+	else if (keyword == "int32"sv)
+	{
+		return &_arena.make<PointRange<std::int32_t>>(std::move(layout));
+	}
+	else if (keyword == "int64"sv)
+	{
+		return &_arena.make<PointRange<std::int64_t>>(std::move(layout));
+	}
+	else if (keyword == "float32"sv)
+	{
+		return &_arena.make<PointRange<float>>(std::move(layout));
+	}
+	else if (keyword == "float64"sv)
+	{
+		return &_arena.make<PointRange<double>>(std::move(layout));
+	}
+	else if (keyword == "string"sv)
+	{
+		return &_arena.make<PointRange<std::string>>(std::move(layout));
+	}
+
+	// The keyword is not known
+	return nullptr;
+}
+
+auto TemplateIoComponent::packedInputWord(std::uint64_t address) -> PackedInputWord &
+{
+	// Use the existing word, if there is one
+	if (auto existing = _packedInputWords.find(address); existing != _packedInputWords.end())
+	{
+		return existing->second;
+	}
+
+	// Create a new word
+	auto &word = _arena.make<PackedInputWord>(address);
+	_packedInputWords.emplace(address, word);
+	return word;
+}
+
+auto TemplateIoComponent::packedOutputWord(std::uint64_t address) -> PackedOutputWord &
+{
+	// Use the existing word, if there is one
+	if (auto existing = _packedOutputWords.find(address); existing != _packedOutputWords.end())
+	{
+		return existing->second;
+	}
+
+	// Create a new word. The word adds itself to the write lane when a value is scheduled.
+	auto &word = _arena.make<PackedOutputWord>(address, _writeLane);
+	_packedOutputWords.emplace(address, word);
+	return word;
+}
+
+auto TemplateIoComponent::createProfileRange(std::string_view profile, AbstractPointRange::Layout layout) -> AbstractPointRange *
+{
+	/// @todo add the supported device profiles
+	if (profile == kExamplePowerMeter.name())
+	{
+		return &_arena.make<ProfileRange<kExamplePowerMeter>>(std::move(layout));
+	}
+
+	// The profile is not known
+	return nullptr;
+}
+
+auto TemplateIoComponent::performReconnectTask(const process::ExecutionContext &context) -> void
+{
+	// Write the trace, if requested
+	if (_traceDumpRequested.load(std::memory_order_relaxed) && _traceDumpRequested.exchange(false, std::memory_order_relaxed))
+	{
+		dumpTrace();
+	}
+
+	// Mark values that have not been updated for too long as stale. This is done regardless of the connection state, because
+	// values that are not being read at all are the ones most likely to go stale.
+	if (!_stalenessIndex.empty())
+	{
+		_stalenessIndex.sweep(context.scheduledTime());
+	}
+
+	// Only perform the reconnect if we are supposed to be connected in the first place
+	if (_connectionRequestCount.load(std::memory_order_relaxed) == 0)
+	{
+		return;
+	}
+	// Reconnect each session individually
+	for (auto &&session : _sessions)
+	{
+		// Keep sessions to standby endpoints alive, and resume sending the values held while the component was down if the
+		// rate limit stopped the replay
+		if (session.connected())
+		{
+			if (session._endpoint != _activeEndpoint.load(std::memory_order_relaxed))
+			{
+				if (session._heartbeatDeadline.passed())
+				{
+					sendHeartbeat(session, context.scheduledTime());
+				}
+			}
+			else if (_forwardQueue.holding())
+			{
+				replayForwardQueue(session, context.scheduledTime());
+			}
+			continue;
+		}
+
+		// Skip the session if it is still backing off after a failed connection attempt
+		if (!session._reconnectDeadline.passed())
+		{
+			continue;
+		}
+
+		// Take ownership of the session, but only if it has failed. If it is up, or if another thread is already busy connecting
+		// or disconnecting it, there is nothing to do.
+		const auto previous = session.tryTransition({ Session::State::Failed }, Session::State::Connecting);
+		if (!previous)
+		{
+			continue;
+		}
+
+		/// @todo check if a reconnect can succeed at all, and skip the session if it can't, using session.publish(*previous).
+		// A reconnect need not be attempted if it requires non-existent hardware, like a missing network adapter or I/O card,
+		// for example. see isConnectionError() for an example on how to check error codes.
+
+		// Attempt a connection
+		connect(session, context.scheduledTime(), *previous);
+	}
+}
+
+auto TemplateIoComponent::performReadTask(const process::ExecutionContext &context) -> void
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// If there is a dedicated I/O thread, just wake it up. If the thread is still busy with the last cycle, it will pick up the
+	// latest cycle when it is done, so slow cycles do not pile up.
+	if (_threadOptions)
+	{
+		_ioScheduledTime.store(context.scheduledTime(), std::memory_order_relaxed);
+		_ioStartTime.store(startTime, std::memory_order_relaxed);
+		_ioDoorbell.fetch_add(1, std::memory_order_release);
+		_ioDoorbell.notify_one();
+		return;
+	}
+
+	readPointRanges(context.scheduledTime(), startTime);
+}
+
+auto TemplateIoComponent::readPointRanges(std::chrono::system_clock::time_point timeStamp, std::chrono::steady_clock::time_point startTime)
+	-> void
+{
+	Trace::Span span { "read cycle", "io" };
+
+	bool first = true;
+
+	// Select the ranges to read, in configuration order. If the rate limit stopped the last cycle before all the ranges were
+	// read, the cycle starts with the first range that was left out, so that the ranges take turns and none of them starves.
+	// While the circuit breaker is open, only the essential ranges are read, plus a single other range as a probe once per
+	// probe interval.
+	_cycleRanges.clear();
+	std::optional<std::size_t> probe;
+	const auto rangeCount = _pointRanges.size();
+	for (std::size_t offset = 0; offset < rangeCount; ++offset)
+	{
+		const auto index = (_nextRange + offset) % rangeCount;
+		const auto admission = _circuitBreaker.admit(_pointRanges[index].get().essential());
+		if (admission == CircuitBreaker::Admission::Rejected)
+		{
+			continue;
+		}
+		if (admission == CircuitBreaker::Admission::Probe)
+		{
+			probe = _cycleRanges.size();
+		}
+		_cycleRanges.push_back(index);
+	}
+	_nextRange = 0;
+
+	// A batch must not contain more requests than the rate limit allows to be sent back to back
+	const auto batchLimit = std::min(Transport::kMaxBatchSize, _rateLimiter.batchLimit());
+	// The number of ranges that were read successfully
+	std::size_t readCount = 0;
+
+	// Read the ranges in groups that fit into a single batch
+	for (auto group = _cycleRanges.begin(); group != _cycleRanges.end();)
+	{
+		// Lease a session for each group separately, so that the groups are spread over all the sessions. The lease keeps
+		// the session from being torn down while we are using it. Stop if no session is up.
+		const auto lease = this->lease();
+		if (!lease)
+		{
+			break;
+		}
+
+		// Send any pending writes first. Writes take priority over reads, because a setpoint waiting behind a large poll
+		// is much more costly than a slightly delayed read. This must be done before creating the batch, because the batch
+		// locks the transport.
+		if (!_writeLane.empty())
 		{
-			/// @todo parse the value correctly
-			auto todo = value.asNumber<std::uint64_t>();
+			_writeLane.drain(lease, timeStamp);
+		}
 
-			/// @todo check that the value is valid
-			if (!"TODO")
+		// Collect as many ranges as fit into a single batch. A range that needs more requests than a batch can hold
+		// gets a batch of its own, and will throw an error when queuing the requests.
+		auto end = group;
+		std::size_t requestCount = 0;
+		for (; end != _cycleRanges.end(); ++end)
+		{
+			const auto rangeRequests = _pointRanges[*end].get().requestCount();
+			if (requestCount + rangeRequests > batchLimit && end != group)
 			{
-				/// @todo use an error message that tells the user exactly what is wrong
-				utils::json::decoder::throwWithLocation(value, std::runtime_error("TODO is wrong with TODO parameter of template I/O component"));
+				break;
 			}
+			requestCount += rangeRequests;
+		}
 
-			/// @todo set the appropriate member variables
+		// Stop if the rate limit does not allow sending the requests right now. The next cycle starts with this group. We don't wait
+		// for the tokens, because the cycle would then overrun, and the next one would be delayed as well.
+		if (!_rateLimiter.tryAcquire(requestCount))
+		{
+			_nextRange = *group;
+			break;
 		}
-		else
+
+		try
 		{
-            config::throwUnknownParameterError(name);
+			// Send the requests for all the ranges using a single submission
+			Transport::Batch batch(lease.handle().transport());
+			for (auto range = group; range != end; ++range)
+			{
+				_pointRanges[*range].get().queueRead(batch);
+			}
+
+			// Measure the delay until the first request is sent
+			if (first)
+			{
+				updateIoJitter(std::chrono::steady_clock::now() - startTime);
+				first = false;
+			}
+
+			batch.submit();
+
+			// Decode the responses directly from the receive buffers
+			Trace::Span decodeSpan { "decode", "io" };
+			for (auto range = group; range != end; ++range)
+			{
+				_pointRanges[*range].get().read(lease, batch, timeStamp, *this);
+			}
+		}
+		catch (...)
+		{
+			// The exchange failed, so none of the ranges in the group could be read
+			const auto error = utils::eh::currentErrorCode();
+			for (auto range = group; range != end; ++range)
+			{
+				_pointRanges[*range].get().updateState(timeStamp, error);
+			}
+			_circuitBreaker.recordError();
+			handleError(lease, timeStamp, error);
+			break;
 		}
-    }
 
-	/// @todo perform consistency and completeness checks
-	if (!"TODO")
+		group = end;
+		readCount = std::size_t(end - _cycleRanges.begin());
+	}
+
+	// Close the circuit breaker again if the probe was read without errors
+	if (probe)
 	{
-		/// @todo use an error message that tells the user exactly what is wrong
-		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("TODO is wrong with template I/O component"));
+		_circuitBreaker.finishProbe(*probe < readCount);
 	}
 }
 
-auto TemplateIoComponent::performReconnectTask(const process::ExecutionContext &context) -> void
+auto TemplateIoComponent::updateIoJitter(std::chrono::steady_clock::duration delay) -> void
 {
-	// Only perform the reconnect if we are supposed to be connected in the first place
-	if (_connectionRequestCount.load(std::memory_order_relaxed) == 0)
+	// Smooth the difference between consecutive delays the same way RFC 3550 smoothes the interarrival jitter of RTP packets
+	if (_lastSendDelay)
 	{
-		return;
+		const auto difference = std::chrono::duration<double>(delay - *_lastSendDelay).count();
+		_ioJitter += (std::abs(difference) - _ioJitter) / 16;
 	}
-	// Also don't reconnect if we are already connected
-	if (_handle)
+	_lastSendDelay = delay;
+
+	memory::WriteSentinel sentinel { _timingDataBlock };
+	sentinel->_ioJitter = _ioJitter;
+	sentinel.commit(std::chrono::system_clock::now());
+}
+
+auto TemplateIoComponent::runIoThread(std::stop_token stopToken) -> void
+{
+	// Ring the doorbell when we are asked to stop, so that we don't sleep forever
+	std::stop_callback wakeUp { stopToken, [this]() {
+		_ioDoorbell.fetch_add(1, std::memory_order_release);
+		_ioDoorbell.notify_one();
+	} };
+
+	for (std::uint32_t ring = 0; !stopToken.stop_requested();)
 	{
-		return;
-	}
+		// Wait until the "read" task starts a read cycle
+		_ioDoorbell.wait(ring, std::memory_order_acquire);
+		ring = _ioDoorbell.load(std::memory_order_acquire);
+		if (stopToken.stop_requested())
+		{
+			break;
+		}
 
-	/// @todo check _lastError to see if a reconnect can succeed at all, and bail if it can't. A reconnect need not be attempted
-	// if it requires non-existent hardware, like a missing network adapter or I/O card, for example.
-	// see isConnectionError() for an example on how to check error codes.
+		readPointRanges(_ioScheduledTime.load(std::memory_order_relaxed), _ioStartTime.load(std::memory_order_relaxed));
+	}
+}
 
-	// Attempt a connection
-	connect(context.scheduledTime());
+auto TemplateIoComponent::handleReadError(const Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	// Handle the error like any other. The range will have updated its state already, before calling this function.
+	_circuitBreaker.recordError();
+	handleError(lease, timeStamp, error);
 }
 
-auto TemplateIoComponent::connect(std::chrono::system_clock::time_point timeStamp) -> void
+auto TemplateIoComponent::connect(Session &session, std::chrono::system_clock::time_point timeStamp, Session::Status previous) -> void
 {
+	Trace::Span span { "connect", "io" };
+
+	// Close the handle of the previous connection, if there is one
+	session.closeHandle();
+
 	try
 	{
-		/// @todo try to establish the connection, and set the _handle object
+		/// @todo try to establish the connection to the endpoint with the index session._endpoint in _endpoints (or to the
+		// configured address, if _endpoints is empty), and set the _handle object of the session. If the connection uses a stream socket,
+		// create the handle using Session::Handle(Transport::create(socket)), which uses io_uring if available.
+		//
+		// If the connection needs a handshake with several round trips, like a login, the handshake can be performed by a
+		// coroutine returning Transaction<>, using co_await session.reactor().exchange(). The coroutine then takes over ownership
+		// of the session, and must call sessionConnected() or sessionFailed(), and publish() itself.
+
+		/// @todo if _sampleClock.source() is SampleClock::Source::Receive, and the connection uses a socket, enable kernel time
+		// stamps on the socket using enableReceiveTimeStamps(), and use receiveTimeStamp() to get the receive time of each response.
 
 		/// @todo if the connect function does not throw errors, but uses return types or internal handle state,
-		// throw an std::system_error here on failure, or call updateState() directly.
+		// throw an std::system_error here on failure, or call sessionFailed() directly.
 		
 		// Note: If your connect function uses normal system error codes (errno on Linux or GetLastError() on Windows), you
 		// should create std::error_codes using std::system_category(). If you are using a library and/or protocol that provides
 		// its own error codes, you should define a custom error category.
 
-		// The connection was successful
-		updateState(timeStamp, std::error_code());
+		// A session without a handle cannot exchange any data, so it must never be published as connected. The I/O paths rely on
+		// every leased session having a transport.
+		if (!session._handle)
+		{
+			throw std::system_error(CustomError::NotConnected);
+		}
+
+		// The connection was successful, so the next failed attempt starts backing off from the beginning again
+		session._reconnectBackoff = {};
+
+		// We must update the state before publishing the session, because as soon as the session is published, other threads
+		// may detect errors on it and update the state themselves.
+		sessionConnected(session, timeStamp);
+		session.publish({ Session::State::Connected, previous._generation + 1 });
+
+		// Send the values that were held while the component was down. This must be done before any of the values left over
+		// in the write lane are written, because those were scheduled later. Sessions to standby endpoints are not used for writing.
+		if (session._endpoint == _activeEndpoint.load(std::memory_order_relaxed))
+		{
+			replayForwardQueue(session, timeStamp);
+		}
+
+		// Wake up the write dispatcher thread if there are values left over from before the session was established
+		if (_immediateWrites && !_writeLane.empty())
+		{
+			_writeLane.ringDoorbell();
+		}
 	}
 	/// @todo if your connection function throws exceptions that are not derived from std::system_error, but that
 	// still provide some sort of error code, you should catch those exceptions separately and wrap the error code in a custom
@@ -113,20 +1004,227 @@ auto TemplateIoComponent::connect(std::chrono::system_clock::time_point timeStam
 		const auto error = utils::eh::currentErrorCode();
 		
 		// Update the state
-		updateState(timeStamp, error);
+		sessionFailed(session, timeStamp, error, false);
+
+		// Back off before the next attempt, doubling the wait each time
+		if (_reconnectBackoff > std::chrono::milliseconds::zero())
+		{
+			session._reconnectBackoff = session._reconnectBackoff == std::chrono::milliseconds::zero()
+				? _reconnectBackoff
+				: std::min(session._reconnectBackoff * 2, std::max(_maxReconnectBackoff, _reconnectBackoff));
+			session._reconnectDeadline.arm(TimingWheel::shared(), session._reconnectBackoff);
+		}
+
+		session.publish({ Session::State::Failed, previous._generation });
+	}
+}
+
+auto TemplateIoComponent::replayForwardQueue(Session &session, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Nothing to do if we are not holding any values
+	if (!_forwardQueue.holding())
+	{
+		return;
+	}
+
+	// Lease the session, which might already have been lost again
+	const auto lease = session.lease();
+	if (!lease)
+	{
+		return;
 	}
+
+	// Write the records back to back. A record that fails due to an error that only affects the output itself is dropped,
+	// but if the connection is lost, the replay stops, and is resumed with the same record when the next session comes up.
+	// If the rate limit of the device is exhausted, the replay also stops, and is resumed by the next "reconnect" task. We
+	// never wait for the limit, because that would hold up the thread of the task.
+	_forwardQueue.replay([&](ForwardQueue::Entry &entry, std::span<const std::byte> record) {
+		if (!_rateLimiter.tryAcquire(1))
+		{
+			return false;
+		}
+
+		const auto error = entry.replay(lease, record, timeStamp);
+		if (error && isConnectionError(lease, error))
+		{
+			handleError(lease, timeStamp, error);
+			return false;
+		}
+		return true;
+	});
 }
 
 auto TemplateIoComponent::disconnect(std::chrono::system_clock::time_point timeStamp) -> void
 {
-	// Reset the handle in any case, even if we fail, because the connection state should be false after this
-	auto handle = std::exchange(_handle, Handle());
+	for (auto &&session : _sessions)
+	{
+		// Take ownership of the session. If another thread is busy connecting it or handling an error, we wait for it to finish.
+		const auto previous = session.acquire(Session::State::Closing);
+
+		// Close the handle
+		session.closeHandle();
+
+		// Remove the session from the count without notifying anyone. The state of the component as a whole is updated below.
+		if (previous._state == Session::State::Connected)
+		{
+			std::scoped_lock lock { _stateMutex };
+			removeConnectedSession(session);
+		}
 
-	/// @todo close the connection, ignoring any errors. If the disconnect function can throw exceptions,
-	// these shoudl be caucht and ignored.
+		session.publish({ Session::State::Disconnected, previous._generation });
+	}
 
 	// This is always a graceful disconnect, regardless of what happened, so never include an error code.
+	std::scoped_lock lock { _stateMutex };
 	updateState(timeStamp, CustomError::NotConnected);
+
+	// Start with the preferred endpoint again next time
+	_activeEndpoint.store(0, std::memory_order_relaxed);
+
+	// Hold any output values until the component is connected again
+	_forwardQueue.hold();
+}
+
+auto TemplateIoComponent::lease() noexcept -> Lease
+{
+	if (_sessions.empty()) [[unlikely]]
+	{
+		return {};
+	}
+
+	// Only consider the sessions to the active endpoint
+	const auto sessionCount = _sessionCount;
+	const auto sessions = _sessions.subspan(_activeEndpoint.load(std::memory_order_relaxed) * sessionCount, sessionCount);
+
+	// Find the session with the fewest outstanding requests. We start the search at a different session each time,
+	// so that sessions with the same number of requests take turns.
+	const auto start = _nextSession.fetch_add(1, std::memory_order_relaxed);
+	Session *best = nullptr;
+	auto bestOutstanding = std::numeric_limits<std::size_t>::max();
+	for (std::size_t offset = 0; offset < sessionCount; ++offset)
+	{
+		auto &session = sessions[(start + offset) % sessionCount];
+		if (!session.connected())
+		{
+			continue;
+		}
+
+		const auto outstanding = session.outstanding();
+		if (outstanding < bestOutstanding)
+		{
+			best = &session;
+			bestOutstanding = outstanding;
+
+			// We can't do better than an idle session
+			if (outstanding == 0)
+			{
+				break;
+			}
+		}
+	}
+
+	// If no session is up, there is nothing to lease. If the session was lost in the meantime, the lease will be empty.
+	if (!best)
+	{
+		return {};
+	}
+	return best->lease();
+}
+
+auto TemplateIoComponent::sessionConnected(const Session &session, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	std::scoped_lock lock { _stateMutex };
+
+	++_endpointSessionCounts[session._endpoint];
+
+	// A session to a standby endpoint does not affect the state if the component is up
+	const auto active = _activeEndpoint.load(std::memory_order_relaxed);
+	if (session._endpoint != active)
+	{
+		if (_connectedSessionCount != 0)
+		{
+			return;
+		}
+
+		// The component is down, so use this endpoint right away
+		_activeEndpoint.store(session._endpoint, std::memory_order_relaxed);
+	}
+
+	// The component comes up with the first session
+	if (_connectedSessionCount++ == 0)
+	{
+		updateState(timeStamp, std::error_code());
+	}
+}
+
+auto TemplateIoComponent::sessionFailed(const Session &session,
+	std::chrono::system_clock::time_point timeStamp, std::error_code error, bool wasConnected, const ErrorSink *excludeErrorSink) -> void
+{
+	std::scoped_lock lock { _stateMutex };
+
+	// Remove the session from the count
+	if (wasConnected)
+	{
+		removeConnectedSession(session);
+	}
+
+	// The component only goes down with the last session to the active endpoint, and only if there is no standby endpoint to fail
+	// over to. As long as any other session is up, the data points are unaffected.
+	if (_connectedSessionCount == 0 && !failOver())
+	{
+		updateState(timeStamp, error, excludeErrorSink);
+
+		// Hold any output values until the component comes back up
+		_forwardQueue.hold();
+	}
+}
+
+auto TemplateIoComponent::removeConnectedSession(const Session &session) noexcept -> void
+{
+	--_endpointSessionCounts[session._endpoint];
+	if (session._endpoint == _activeEndpoint.load(std::memory_order_relaxed))
+	{
+		--_connectedSessionCount;
+	}
+}
+
+auto TemplateIoComponent::failOver() noexcept -> bool
+{
+	// Use the first endpoint in order of preference that has sessions that are up. The sessions are already established and kept alive
+	// by heartbeats, so they can take over immediately.
+	const auto found = std::ranges::find_if(_endpointSessionCounts, [](std::size_t count) { return count != 0; });
+	if (found == _endpointSessionCounts.end())
+	{
+		return false;
+	}
+
+	_activeEndpoint.store(std::size_t(found - _endpointSessionCounts.begin()), std::memory_order_relaxed);
+	_connectedSessionCount = *found;
+	return true;
+}
+
+auto TemplateIoComponent::sendHeartbeat(Session &session, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Lease the session, which might have been lost in the meantime
+	const auto lease = session.lease();
+	if (!lease)
+	{
+		return;
+	}
+
+	try
+	{
+		/// @todo send the cheapest request the device supports, like reading a single register or an explicit keep-alive message,
+		// using a Transport::Batch on lease.handle().transport().
+	}
+	catch (const std::exception &)
+	{
+		// Mark the session as failed, so it is reconnected
+		handleError(lease, timeStamp, utils::eh::currentErrorCode());
+		return;
+	}
+
+	session._heartbeatDeadline.arm(TimingWheel::shared(), _heartbeatInterval);
 }
 
 auto TemplateIoComponent::updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *excludeErrorSink)
@@ -171,6 +1269,9 @@ auto TemplateIoComponent::updateState(std::chrono::system_clock::time_point time
 	// Commit the data and raise the events
 	sentinel.commit(timeStamp, events);
 
+	// Remember the error
+	_lastError = error;
+
 	// Notify all error sinks
 	for (auto &&sink : _errorSinks)
 	{
@@ -179,9 +1280,37 @@ auto TemplateIoComponent::updateState(std::chrono::system_clock::time_point time
 			sink.get().ioComponentStateChanged(timeStamp, error);
 		}
 	}
+
+	// Update the point ranges. We cannot reset the error to Ok because we don't have a value, so we use the special custom
+	// error code instead. Each range invalidates all of its points using a single commit, and the points do not raise individual
+	// events, because the connected and disconnected events raised above already cover all of them.
+	const auto effectiveError = error ? error : CustomError::NoData;
+	for (auto &&range : _pointRanges)
+	{
+		range.get().updateState(timeStamp, effectiveError);
+	}
+}
+
+auto TemplateIoComponent::updateCircuitState(CircuitBreaker::State circuitState) -> void
+{
+	// Only the transitions between closed and open are published. The half open state only lasts as long as a single probe.
+	const auto open = circuitState != CircuitBreaker::State::Closed;
+
+	// Make a write sentinel
+	memory::WriteSentinel sentinel { _circuitDataBlock };
+	if (open == sentinel.oldValue()._circuitOpen)
+	{
+		return;
+	}
+	sentinel->_circuitOpen = open;
+
+	// Commit the data and raise the event
+	process::StaticEventList<1> events;
+	events.push_back(open ? _circuitOpenedEvent : _circuitClosedEvent);
+	sentinel.commit(std::chrono::system_clock::now(), events);
 }
 
-auto TemplateIoComponent::isConnectionError(std::error_code error) noexcept -> bool
+auto TemplateIoComponent::isConnectionError(const Lease &lease, std::error_code error) const noexcept -> bool
 {
 	/// @todo check if this error affects the connection as a whole, and bail if it doesn't.
 	// This function should return true on errors that signal that the entire I/O component has stopped working,
@@ -234,9 +1363,13 @@ auto TemplateIoComponent::isConnectionError(std::error_code error) noexcept -> b
 		{
 		case CustomError::NotConnected:
 		case CustomError::UnknownError:
-			/// @todo add case statements for other relevant custom errors (like e.g. timeout) here
+			/// @todo add case statements for other relevant custom errors here
 			return true;
 
+		// A single timeout may just be a lost packet, but a device that keeps timing out is gone
+		case CustomError::Timeout:
+			return !lease.handle() || lease.handle().transport().consecutiveTimeouts() >= _timeoutsBeforeDisconnect;
+
 		case CustomError::NoError:
 		case CustomError::NoData:
 		default:
@@ -259,7 +1392,15 @@ auto TemplateIoComponent::requestConnect(std::chrono::system_clock::time_point t
 	// connect if the old count was 0
 	if (oldCount == 0)
 	{
-		connect(timeStamp);
+		// Establish all the sessions
+		for (auto &&session : _sessions)
+		{
+			// Take ownership of the session. If this fails, another thread is already taking care of it.
+			if (const auto previous = session.tryTransition({ Session::State::Disconnected, Session::State::Failed }, Session::State::Connecting))
+			{
+				connect(session, timeStamp, *previous);
+			}
+		}
 	}
 }
 
@@ -275,25 +1416,29 @@ auto TemplateIoComponent::requestDisconnect(std::chrono::system_clock::time_poin
 	}
 }
 
-auto TemplateIoComponent::handleError(std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *sender) noexcept -> void
+auto TemplateIoComponent::handleError(const Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *sender) noexcept
+	-> void
 {
-	// Ignore any new errors if we already have an error (the first error always wins).
-	if (_lastError)
+	// Check if this error affects the session as a whole, and bail if it doesn't.
+	if (!isConnectionError(lease, error))
 	{
 		return;
 	}
-	// Check if this error affects the connection as a whole, and bail if it doesn't. This function shoudl
-	if (!isConnectionError(error))
+	// Take ownership of the session. This fails if the session is not up, or if another thread has already taken
+	// ownership, so any new errors are ignored if we already have an error (the first error always wins).
+	auto &session = lease.session();
+	const auto previous = session.tryTransition({ Session::State::Connected }, Session::State::Closing);
+	if (!previous)
 	{
 		return;
 	}
 
-	// Reset the handle
-	/// @todo gracefully close the handle, if this is necessary
-	_handle = Handle();
-
 	// update the error state
-	updateState(timeStamp, error, sender);
+	sessionFailed(session, timeStamp, error, true, sender);
+
+	// Mark the session as failed, so that the "reconnect" task will pick it up. We cannot close the handle here, because
+	// the caller is still holding a lease on it. The handle will be closed by the next connection attempt instead.
+	session.publish({ Session::State::Failed, previous->_generation });
 }
 
 auto TemplateIoComponent::createChildElement(const skill::Element::Class &elementClass, skill::ElementFactory &factory)
@@ -316,10 +1461,26 @@ auto TemplateIoComponent::createChildElement(const skill::Element::Class &elemen
 auto TemplateIoComponent::forEachAttribute(const model::ForEachAttributeFunction &function) const -> bool
 {
 	/// @todo handle any additional attributes this class supports
-	return
-		function(model::Attribute::kDeviceState) ||
+	if (function(model::Attribute::kDeviceState) ||
 		function(attributes::kConnectionTime) ||
-		function(attributes::kDeviceError);
+		function(attributes::kDeviceError) ||
+		function(attributes::kIoJitter) ||
+		function(attributes::kCircuitOpen) ||
+		function(attributes::kDumpTrace))
+	{
+		return true;
+	}
+
+	// Publish the points of the point ranges
+	for (auto &&range : _pointRanges)
+	{
+		if (range.get().forEachAttribute(function))
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 auto TemplateIoComponent::forEachEvent(const model::ForEachEventFunction &function) -> bool
@@ -327,7 +1488,9 @@ auto TemplateIoComponent::forEachEvent(const model::ForEachEventFunction &functi
 	// Handle all the events we support
 	return
 		function(process::Event::kConnected, sharedFromThis(&_connectedEvent)) ||
-		function(process::Event::kDisconnected, sharedFromThis(&_disconnectedEvent));
+		function(process::Event::kDisconnected, sharedFromThis(&_disconnectedEvent)) ||
+		function(events::kCircuitOpened, sharedFromThis(&_circuitOpenedEvent)) ||
+		function(events::kCircuitClosed, sharedFromThis(&_circuitClosedEvent));
 
 	/// @todo handle any additional events this class supports
 }
@@ -336,13 +1499,24 @@ auto TemplateIoComponent::forEachTask(const model::ForEachTaskFunction &function
 {
 	// Handle all the tasks we support
 	return
-		function(process::Task::kReconnect, sharedFromThis(&_reconnectTask));
+		function(process::Task::kReconnect, sharedFromThis(&_reconnectTask)) ||
+		function(tasks::kRead, sharedFromThis(&_readTask));
 
 	/// @todo handle any additional tasks this class supports
 }
 
 auto TemplateIoComponent::makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle>
 {
+	// Try the points of the point ranges first. The ranges identify their attributes by address, so this never matches any of our
+	// own attributes, whereas comparing our attributes to those of the points might match if they have the same UUID.
+	for (auto &&range : _pointRanges)
+	{
+		if (auto handle = range.get().makeReadHandle(attribute))
+		{
+			return handle;
+		}
+	}
+
 	// Try our attributes
 	if (attribute == model::Attribute::kDeviceState)
 	{
@@ -356,6 +1530,14 @@ auto TemplateIoComponent::makeReadHandle(const model::Attribute &attribute) cons
 	{
 		return _stateDataBlock.member(&State::_error);
 	}
+	else if (attribute == attributes::kIoJitter)
+	{
+		return _timingDataBlock.member(&Timing::_ioJitter);
+	}
+	else if (attribute == attributes::kCircuitOpen)
+	{
+		return _circuitDataBlock.member(&Circuit::_circuitOpen);
+	}
 
 	/// @todo handle any additional readable attributes this class supports
 
@@ -363,10 +1545,113 @@ auto TemplateIoComponent::makeReadHandle(const model::Attribute &attribute) cons
 	return std::nullopt;
 }
 
+auto TemplateIoComponent::makeWriteHandle(const model::Attribute &attribute) noexcept -> std::optional<data::WriteHandle>
+{
+	// Try our attributes
+	if (attribute == attributes::kDumpTrace)
+	{
+		// This creates a write handle of type bool that calls requestTraceDump() on this object.
+		// (There are two sets of braces needed here: one for data::WriteHandle, and one for std::optional)
+		return {{ std::in_place_type<bool>, &TemplateIoComponent::requestTraceDump, sharedFromThis() }};
+	}
+
+	/// @todo handle any additional writable attributes this class supports
+
+	// Nothing found
+	return std::nullopt;
+}
+
 auto TemplateIoComponent::realize() -> void
 {
-	// Create the data block
+	// Create the data blocks
 	_stateDataBlock.create(memory::memoryResources::data());
+	_timingDataBlock.create(memory::memoryResources::data());
+	_circuitDataBlock.create(memory::memoryResources::data());
+
+	// Realize the point ranges
+	for (auto &&range : _pointRanges)
+	{
+		range.get().realize();
+	}
+
+	// Start recording spans, if requested
+	if (!_traceFile.empty())
+	{
+		Trace::enable(_traceBufferSize);
+	}
+
+	// Assign the default maximum age to the data points that don't have their own. All the data points have been loaded by now.
+	_stalenessIndex.realize();
+
+	// Allocate the list of ranges to read up front, so that read cycles don't allocate memory
+	_cycleRanges.reserve(_pointRanges.size());
+
+	// Enable the circuit breaker
+	if (_circuitBreakerOptions)
+	{
+		_circuitBreaker.enable(*_circuitBreakerOptions, [this](CircuitBreaker::State state) { updateCircuitState(state); });
+	}
+
+	// Open the forward queue. All the outputs have registered with the queue by now.
+	if (!_forwardQueueFile.empty())
+	{
+		_forwardQueue.open(_forwardQueueFile, _forwardQueueSize, _forwardQueueOverflow);
+	}
+
+	// Start the reactor thread for transactions
+	_reactor.start();
+
+	// Start the write dispatcher thread, if necessary
+	if (_immediateWrites)
+	{
+		_writeLane.enableDoorbell();
+		_writeDispatcher = std::jthread([this](std::stop_token stopToken) { runWriteDispatcher(stopToken); });
+		if (_threadOptions)
+		{
+			_threadOptions->apply(_writeDispatcher);
+		}
+	}
+
+	// Start the dedicated I/O thread, if necessary
+	if (_threadOptions)
+	{
+		_ioThread = std::jthread([this](std::stop_token stopToken) { runIoThread(stopToken); });
+		_threadOptions->apply(_ioThread);
+	}
+}
+
+auto TemplateIoComponent::runWriteDispatcher(std::stop_token stopToken) -> void
+{
+	// Ring the doorbell when we are asked to stop, so that we don't sleep forever
+	std::stop_callback wakeUp { stopToken, [this]() { _writeLane.ringDoorbell(); } };
+
+	for (std::uint32_t ring = 0; !stopToken.stop_requested();)
+	{
+		// Wait until an output adds itself to the write lane
+		ring = _writeLane.waitForDoorbell(ring);
+		if (stopToken.stop_requested())
+		{
+			break;
+		}
+
+		// Give other values scheduled at the same time a chance to arrive, so that they are written together, but stop as soon
+		// as enough values are pending. The window is measured from the time the oldest pending value was scheduled, rather than
+		// from the time we woke up, so that no value is ever held back longer than the window, even if it arrived while we were
+		// still busy writing. We spin rather than sleep, because the window is typically far shorter than the resolution of the
+		// system timer.
+		const auto deadline = _writeLane.oldestTime() + _writeCoalescingWindow;
+		while (_writeLane.size() < _writeCoalescingLimit && std::chrono::steady_clock::now() < deadline)
+		{
+			std::this_thread::yield();
+		}
+
+		// Write the pending values if the I/O component is up. If it isn't, the values stay in the lane, and we are woken up
+		// again as soon as a session has been established.
+		if (const auto lease = this->lease())
+		{
+			_writeLane.drain(lease, std::chrono::system_clock::now());
+		}
+	}
 }
 
 auto TemplateIoComponent::ReconnectTask::preparePreOperational(const process::ExecutionContext &context) -> Status
@@ -387,6 +1672,7 @@ auto TemplateIoComponent::ReconnectTask::preOperational(const process::Execution
 
 auto TemplateIoComponent::ReconnectTask::operational(const process::ExecutionContext &context) -> void
 {
+	Trace::Span span { "reconnect task", "task" };
 	_target.get().performReconnectTask(context);
 }
 
@@ -408,6 +1694,9 @@ auto TemplateIoComponent::ReconnectTask::finishPostOperational(const process::Ex
 {
 	// Request a disconnect
 	_target.get().requestDisconnect(context.scheduledTime());
+
+	// Write the trace one last time, so that it covers the shutdown
+	_target.get().dumpTrace();
 }
 
 } // namespace xentara::plugins::templateDriver
\ No newline at end of file
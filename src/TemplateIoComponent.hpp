@@ -1,8 +1,25 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "AbstractPointRange.hpp"
+#include "AbstractTemplateInputHandler.hpp"
+#include "Arena.hpp"
 #include "Attributes.hpp"
+#include "CircuitBreaker.hpp"
 #include "CustomError.hpp"
+#include "ForwardQueue.hpp"
+#include "PackedInputWord.hpp"
+#include "PackedOutputWord.hpp"
+#include "RateLimiter.hpp"
+#include "ReadTask.hpp"
+#include "Reactor.hpp"
+#include "SampleClock.hpp"
+#include "Session.hpp"
+#include "Snapshot.hpp"
+#include "StalenessIndex.hpp"
+#include "ThreadOptions.hpp"
+#include "Trace.hpp"
+#include "WriteLane.hpp"
 
 #include <xentara/memory/Array.hpp>
 #include <xentara/memory/ObjectBlock.hpp>
@@ -12,11 +29,27 @@
 #include <xentara/skill/Element.hpp>
 #include <xentara/skill/EnableSharedFromThis.hpp>
 #include <xentara/utils/core/Uuid.hpp>
+#include <xentara/utils/json/decoder/Value.hpp>
 #include <xentara/utils/tools/Unique.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
 #include <string_view>
 #include <functional>
 #include <forward_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace xentara::plugins::templateDriver
 {
@@ -25,7 +58,10 @@ using namespace std::literals;
 
 /// @brief A class representing a specific type of I/O component.
 /// @todo rename this class to something more descriptive
-class TemplateIoComponent final : public skill::Element, public skill::EnableSharedFromThis<TemplateIoComponent>
+class TemplateIoComponent final :
+	public skill::Element,
+	public AbstractTemplateInputHandler::ErrorSink,
+	public skill::EnableSharedFromThis<TemplateIoComponent>
 {
 public:
 	/// @brief The class object containing meta-information about this element type
@@ -36,18 +72,8 @@ public:
 		"deadbeef-dead-beef-dead-beefdeadbeef"_uuid,
 		"template driver I/O component">;
 
-	/// @brief A handle used to access the I/O component
-	/// @todo implement a proper handle
-	class Handle final : private utils::tools::Unique
-	{
-	public:
-		/// @brief determines of the I/O component is connected
-		explicit operator bool() const noexcept
-		{
-			/// @todo return the actual state
-			return false;
-		}
-	};
+	/// @brief A lease on one of the sessions of the I/O component
+	using Lease = Session::Lease;
 
 	/// @brief Interface for objects that want to be notified of errors
 	class ErrorSink
@@ -99,20 +125,86 @@ public:
 	
 	/// @brief Notifies the I/O component that an error was detected from outside, e.g. when reading or writing a data point.
 	/// 
-	/// If this error affects the I/O component as a whole, error sinks will be notified. If the sender is an error sink itself,
+	/// If this error affects the session as a whole, the session is marked as failed, and will be reconnected by the "reconnect" task.
+	/// If it was the last session that was up, error sinks will be notified. If the sender is an error sink itself,
 	/// and does not whish to be notified, but intends to handle the error itself instead, it can pass a pointer to itself as the sender parameter. 
-	auto handleError(std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *sender = nullptr) noexcept -> void;
+	/// @param lease The lease on the session the error occurred on
+	auto handleError(const Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *sender = nullptr) noexcept
+		-> void;
 
-	/// @brief Checks whether the I/O component is up
-	auto connected() const -> bool
+	/// @brief Checks whether the I/O component is up, i.e. whether at least one of the sessions to its active endpoint is up
+	auto connected() const noexcept -> bool
 	{
-		return bool(_handle);
+		return _connectedSessionCount.load() != 0;
 	}
 
-	/// @brief Returns a handle to the I/O component
-	auto handle() const -> const Handle &
+	/// @brief Leases the session to the active endpoint with the fewest outstanding requests.
+	///
+	/// Sessions with the same number of outstanding requests take turns. Sessions to standby endpoints are never leased.
+	/// This function is thread-safe and lock-free.
+	/// @return A lease on a session, or an empty lease if no session is up.
+	auto lease() noexcept -> Lease;
+
+	/// @brief Returns the arena used to allocate the handlers and point states of the data points of this component.
+	///
+	/// Objects allocated from the arena are destroyed together with the I/O component, and must only be created while the
+	/// configuration is being loaded.
+	auto arena() noexcept -> Arena &
 	{
-		return _handle;
+		return _arena;
+	}
+
+	/// @brief Returns the packed word containing boolean inputs at a certain address, creating it if necessary.
+	///
+	/// The word is allocated in the arena, so this function must only be called while the configuration is being loaded.
+	/// @param address The address of the word
+	auto packedInputWord(std::uint64_t address) -> PackedInputWord &;
+
+	/// @brief Returns the packed word containing boolean outputs at a certain address, creating it if necessary.
+	///
+	/// The word is allocated in the arena, so this function must only be called while the configuration is being loaded.
+	/// @param address The address of the word
+	auto packedOutputWord(std::uint64_t address) -> PackedOutputWord &;
+
+	/// @brief Returns the write lane of the component.
+	///
+	/// Outputs with pending values add themselves to the lane, so that the values are written between the reads of the "read" task.
+	auto writeLane() noexcept -> WriteLane &
+	{
+		return _writeLane;
+	}
+
+	/// @brief Returns the forward queue of the component.
+	///
+	/// If a forward queue file is configured, outputs add their values to the queue while the component is down, and the values
+	/// are replayed once the component comes back up.
+	auto forwardQueue() noexcept -> ForwardQueue &
+	{
+		return _forwardQueue;
+	}
+
+	/// @brief Returns the circuit breaker of the component.
+	///
+	/// Data points must ask the breaker before reading, and report read errors to it.
+	auto circuitBreaker() noexcept -> CircuitBreaker &
+	{
+		return _circuitBreaker;
+	}
+
+	/// @brief Returns the snapshot of the last known values of the data points of the component.
+	///
+	/// Data points must be assigned their slots while the configuration is being loaded.
+	auto snapshot() noexcept -> Snapshot &
+	{
+		return _snapshot;
+	}
+
+	/// @brief Returns the index used to detect values that have not been updated for too long.
+	///
+	/// Data points must be added to the index while the configuration is being loaded.
+	auto stalenessIndex() noexcept -> StalenessIndex &
+	{
+		return _stalenessIndex;
 	}
 
 	/// @name Virtual Overrides for skill::Element
@@ -129,6 +221,8 @@ public:
 
 	auto makeReadHandle(const model::Attribute &attribute) const noexcept -> std::optional<data::ReadHandle> final;
 
+	auto makeWriteHandle(const model::Attribute &attribute) noexcept -> std::optional<data::WriteHandle> final;
+
 	auto category() const noexcept -> model::ElementCategory final
 	{
 		return model::ElementCategory::Device;
@@ -136,7 +230,17 @@ public:
 
 	/// @}
 
+	/// @name Virtual Overrides for AbstractTemplateInputHandler::ErrorSink
+	/// @{
+	
+	auto handleReadError(const Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+
+	/// @}
+
 private:
+	/// @brief The read task needs access to out private member functions
+	friend class ReadTask<TemplateIoComponent>;
+
 	/// @brief This structure represents the current state of the I/O component
 	struct State
 	{
@@ -186,24 +290,129 @@ private:
 	
 	/// @brief This function is called by the "reconnect" task.
 	///
-	/// This function attempts to reconnect any disconnected I/O components.
+	/// This function attempts to reconnect any failed sessions.
 	auto performReconnectTask(const process::ExecutionContext &context) -> void;
 
-	/// @brief Attempts to establish a connection to the I/O component and updates the state accordingly.
+	/// @brief This function is called by the "read" task.
 	///
-	/// This function will notify error sinks if anything changes.
-	auto connect(std::chrono::system_clock::time_point timeStamp) -> void;
+	/// This function reads all the point ranges, or wakes up the dedicated I/O thread to do so, if there is one.
+	auto performReadTask(const process::ExecutionContext &context) -> void;
+
+	/// @brief Reads all the point ranges if the I/O component is up. Pending writes in the write lane are sent ahead of each range.
+	/// @param timeStamp The time stamp to use for the values
+	/// @param startTime The time the read cycle was started, used to measure the I/O jitter
+	auto readPointRanges(std::chrono::system_clock::time_point timeStamp, std::chrono::steady_clock::time_point startTime) -> void;
 
-	/// @brief Terminates the connection to the I/O component and updates the state accordingly.
+	/// @brief Updates the I/O jitter
+	/// @param delay The delay between the start of the read cycle and the sending of the first request
+	auto updateIoJitter(std::chrono::steady_clock::duration delay) -> void;
+
+	/// @brief The body of the dedicated I/O thread.
+	///
+	/// The thread waits for the "read" task to start a read cycle, and then reads the point ranges.
+	auto runIoThread(std::stop_token stopToken) -> void;
+
+	/// @brief Loads the options for the threads of the component from the configuration
+	auto loadThreadOptions(utils::json::decoder::Value &value) -> ThreadOptions;
+
+	/// @brief Loads a rate limit from the configuration
+	/// @param link Receives the name of the link, or nullptr if this is the rate limit of the device itself
+	auto loadRateLimit(utils::json::decoder::Value &value, std::string *link = nullptr) -> RateLimiter::Options;
+
+	/// @brief Loads the options for the circuit breaker from the configuration
+	auto loadCircuitBreakerOptions(utils::json::decoder::Value &value) -> CircuitBreaker::Options;
+
+	/// @brief Loads the tracing options from the configuration
+	auto loadTraceOptions(utils::json::decoder::Value &value) -> void;
+
+	/// @brief Requests the trace to be written to the trace file by the next "reconnect" task.
+	///
+	/// This function is called by the write handle of the dumpTrace attribute. The trace is not written directly, because
+	/// the caller might be a time critical task.
+	auto requestTraceDump(bool dump) noexcept -> void
+	{
+		if (dump)
+		{
+			_traceDumpRequested.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	/// @brief Writes the trace to the trace file, if there is one
+	auto dumpTrace() noexcept -> void;
+
+	/// @brief The body of the write dispatcher thread.
+	///
+	/// The thread waits for the doorbell of the write lane, and writes the pending values immediately.
+	auto runWriteDispatcher(std::stop_token stopToken) -> void;
+
+	/// @brief Loads a point range from the configuration
+	auto loadPointRange(utils::json::decoder::Value &value) -> AbstractPointRange &;
+	/// @brief Creates a point range in the arena based on a data type keyword
+	/// @return The range, or nullptr if the keyword is unknown
+	auto createPointRange(std::string_view keyword, AbstractPointRange::Layout layout) -> AbstractPointRange *;
+
+	/// @brief Creates a range for a device profile
+	/// @param profile The name of the device profile
+	/// @param layout The layout of the range. Only the name pattern and the base address are used.
+	/// @return The range, or nullptr if the profile is unknown
+	auto createProfileRange(std::string_view profile, AbstractPointRange::Layout layout) -> AbstractPointRange *;
+
+	/// @brief Attempts to establish a session and updates the state accordingly.
+	///
+	/// The caller must have moved the session into the Connecting state. This function will notify error sinks if anything changes.
+	/// @param session The session to establish
+	/// @param timeStamp The time stamp to use for the state change
+	/// @param previous The status of the session before it was moved into the Connecting state
+	auto connect(Session &session, std::chrono::system_clock::time_point timeStamp, Session::Status previous) -> void;
+
+	/// @brief Writes the values held in the forward queue using a session that was just established
+	auto replayForwardQueue(Session &session, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief Sends a heartbeat on a session to a standby endpoint, so that the session stays up and failures are detected early.
+	auto sendHeartbeat(Session &session, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief Terminates all the sessions and updates the state accordingly.
 	///
 	/// This function will notify error sinks if anything changes.
 	auto disconnect(std::chrono::system_clock::time_point timeStamp) -> void;
 
+	/// @brief Updates the state after a session was established
+	///
+	/// The component comes up with its first session. If the component is down, the endpoint of the session becomes the active endpoint.
+	/// @param session The session
+	auto sessionConnected(const Session &session, std::chrono::system_clock::time_point timeStamp) -> void;
+	/// @brief Updates the state after a session was lost, or could not be established
+	///
+	/// If this was the last session to the active endpoint, the component fails over to a standby endpoint that is up. The component
+	/// only goes down if no such endpoint exists.
+	/// @param session The session
+	/// @param wasConnected Whether the session was up before
+	auto sessionFailed(const Session &session, std::chrono::system_clock::time_point timeStamp, std::error_code error, bool wasConnected,
+		const ErrorSink *excludeErrorSink = nullptr) -> void;
+	/// @brief Removes a session that was up from the counts
+	///
+	/// The caller must hold _stateMutex.
+	auto removeConnectedSession(const Session &session) noexcept -> void;
+	/// @brief Makes a standby endpoint with sessions that are up the active endpoint.
+	///
+	/// The caller must hold _stateMutex.
+	/// @return true on success, or false if no standby endpoint has any sessions that are up
+	auto failOver() noexcept -> bool;
+
 	/// @brief Updates the state and sends events
+	///
+	/// The caller must hold _stateMutex.
 	auto updateState(std::chrono::system_clock::time_point timeStamp, std::error_code error, const ErrorSink *excludeErrorSink = nullptr) -> void;
 
+	/// @brief Updates the circuit breaker attribute and sends events.
+	///
+	/// This is called by the circuit breaker whenever its state changes.
+	auto updateCircuitState(CircuitBreaker::State circuitState) -> void;
+
 	/// @brief Checks whether an error is the result of a lost connection
-	static auto isConnectionError(std::error_code error) noexcept -> bool;
+	/// @param lease The lease on the session the error occurred on
+	/// @param error The error
+	auto isConnectionError(const Lease &lease, std::error_code error) const noexcept -> bool;
 
 	/// @name Virtual Overrides for skill::Element
 	/// @{
@@ -218,9 +427,15 @@ private:
 	process::Event _connectedEvent;
 	/// @brief A Xentara event that is raised when the connection is closed or lost
 	process::Event _disconnectedEvent;
+	/// @brief A Xentara event that is raised when the circuit breaker opens
+	process::Event _circuitOpenedEvent;
+	/// @brief A Xentara event that is raised when the circuit breaker closes again
+	process::Event _circuitClosedEvent;
 
 	/// @brief The "reconnect" task
 	ReconnectTask _reconnectTask { *this };
+	/// @brief The "read" task, which reads the point ranges
+	ReadTask<TemplateIoComponent> _readTask { *this };
 
 	/// @brief A list of objects that want to be notified of errors
 	std::forward_list<std::reference_wrapper<ErrorSink>> _errorSinks;
@@ -228,18 +443,157 @@ private:
 	/// @brief The number of people who would like this component to be connected
 	std::atomic<std::size_t> _connectionRequestCount { 0 };
 
-	/// @brief A handle to the I/O component
-	Handle _handle;
+	/// @brief The number of parallel sessions to open to each endpoint of the device
+	std::size_t _sessionCount { 1 };
+	/// @brief The addresses of the redundant endpoints of the device, in order of preference.
+	/// If this is empty, the device has a single endpoint.
+	/// @todo use a type suitable for the addresses of the device
+	std::vector<std::string> _endpoints;
+	/// @brief The sessions. The sessions to each endpoint are stored consecutively, and allocated in _arena when the configuration
+	/// is loaded.
+	std::span<Session> _sessions;
+	/// @brief The index of the session to start the search at in lease()
+	std::atomic<std::size_t> _nextSession { 0 };
+
+	/// @brief The index of the endpoint whose sessions are used for reading and writing.
+	///
+	/// This may only be modified while holding _stateMutex, but can be read at any time.
+	std::atomic<std::size_t> _activeEndpoint { 0 };
+	/// @brief The number of sessions to each endpoint that are up. This is allocated in _arena, and must only be accessed while
+	/// holding _stateMutex.
+	std::span<std::size_t> _endpointSessionCounts;
+	/// @brief The number of sessions to the active endpoint that are up
+	///
+	/// This may only be modified while holding _stateMutex, but can be read at any time.
+	std::atomic<std::size_t> _connectedSessionCount { 0 };
+	/// @brief The interval at which heartbeats are sent on sessions to standby endpoints
+	std::chrono::milliseconds _heartbeatInterval { 1s };
+
+	/// @brief A mutex that serializes changes to the state of the I/O component as a whole.
+	///
+	/// The sessions themselves are lock-free. The mutex is only taken when a session comes up or goes down.
+	std::mutex _stateMutex;
 	/// @brief The last error we encountered.
 	/// 
 	/// May have the following values:
-	/// - If the connection is open, this will be a default constructed std::error_code object
-	/// - If the connection was closed gracefully, this will be CustomError::NotConnected;
+	/// - If at least one session is up, this will be a default constructed std::error_code object
+	/// - If the component was disconnected gracefully, this will be CustomError::NotConnected;
 	/// - Otherwise, this will contain an appropriate error code
+	///
+	/// This may only be accessed while holding _stateMutex.
 	std::error_code _lastError { CustomError::NotConnected };
 
 	/// @brief The data block that contains the state
 	memory::ObjectBlock<State> _stateDataBlock;
+
+	/// @brief This structure contains timing information about the I/O of the component
+	struct Timing final
+	{
+		/// @brief The I/O jitter, in seconds
+		double _ioJitter { 0 };
+	};
+
+	/// @brief The data block that contains the timing information
+	memory::ObjectBlock<Timing> _timingDataBlock;
+	/// @brief The delay between the start of the last read cycle and the sending of its first request, or std::nullopt if there
+	/// was no read cycle yet. This is only accessed by the thread performing the read cycles.
+	std::optional<std::chrono::steady_clock::duration> _lastSendDelay;
+	/// @brief The smoothed I/O jitter, in seconds. This is only accessed by the thread performing the read cycles.
+	double _ioJitter { 0 };
+
+	/// @brief This structure contains the state of the circuit breaker
+	struct Circuit final
+	{
+		/// @brief Whether the circuit breaker is open
+		bool _circuitOpen { false };
+	};
+
+	/// @brief The data block that contains the state of the circuit breaker
+	memory::ObjectBlock<Circuit> _circuitDataBlock;
+	/// @brief The circuit breaker that stops non-essential reads if the device responds with too many errors
+	CircuitBreaker _circuitBreaker;
+	/// @brief The configuration of the circuit breaker, or std::nullopt if the circuit breaker is disabled
+	std::optional<CircuitBreaker::Options> _circuitBreakerOptions;
+
+	/// @brief The arena for the handlers and point states of the data points
+	Arena _arena;
+
+	/// @brief The clock used to time stamp values read from the device
+	SampleClock _sampleClock;
+
+	/// @brief The lane for outputs with pending values
+	WriteLane _writeLane;
+	/// @brief Whether to write pending values immediately using a dedicated thread, rather than waiting for a task
+	bool _immediateWrites { false };
+
+	/// @brief The scheduling options for the threads of the component. If this is set, the point ranges are read by a
+	/// dedicated I/O thread instead of the "read" task.
+	std::optional<ThreadOptions> _threadOptions;
+	/// @brief The doorbell of the I/O thread. This is a counter that is incremented each time a read cycle is started.
+	std::atomic<std::uint32_t> _ioDoorbell { 0 };
+	/// @brief The scheduled time of the read cycle the I/O thread should perform
+	std::atomic<std::chrono::system_clock::time_point> _ioScheduledTime;
+	/// @brief The time the read cycle the I/O thread should perform was started
+	std::atomic<std::chrono::steady_clock::time_point> _ioStartTime;
+	/// @brief How long the write dispatcher thread holds back the first pending value, so that values scheduled together are
+	/// written together. This is the maximum latency added by coalescing.
+	std::chrono::microseconds _writeCoalescingWindow { 1 };
+	/// @brief The number of pending values at which the write dispatcher thread stops waiting for more
+	std::size_t _writeCoalescingLimit { std::numeric_limits<std::size_t>::max() };
+
+	/// @brief The queue holding output values while the component is down
+	ForwardQueue _forwardQueue;
+	/// @brief The file backing the forward queue, or an empty path to write values directly even if the component is down
+	std::filesystem::path _forwardQueueFile;
+	/// @brief The size of the forward queue, in bytes
+	std::size_t _forwardQueueSize { 1024 * 1024 };
+	/// @brief What to do if the forward queue is full
+	ForwardQueue::OverflowPolicy _forwardQueueOverflow { ForwardQueue::OverflowPolicy::DropOldest };
+
+	/// @brief The snapshot of the last known values
+	Snapshot _snapshot;
+
+	/// @brief The file to write the trace to, or an empty path if tracing is disabled
+	std::filesystem::path _traceFile;
+	/// @brief The number of spans to keep for each thread
+	std::size_t _traceBufferSize { 64 * 1024 };
+	/// @brief Whether the trace should be written by the next "reconnect" task
+	std::atomic<bool> _traceDumpRequested { false };
+	/// @brief The index of the ages of the values, used to mark values as stale
+	StalenessIndex _stalenessIndex;
+
+	/// @brief The number of timeouts in a row after which a session is considered disconnected
+	std::size_t _timeoutsBeforeDisconnect { 3 };
+	/// @brief How long to wait before retrying after the first failed connection attempt, or zero to retry on every reconnect task
+	std::chrono::milliseconds _reconnectBackoff { 0 };
+	/// @brief The maximum time to wait between connection attempts. The wait doubles after each failed attempt up to this limit.
+	std::chrono::milliseconds _maxReconnectBackoff { 30s };
+
+	/// @brief The reactor that performs the device requests of transactions
+	Reactor _reactor;
+
+	/// @brief The rate limiter for the requests sent to the device
+	RateLimiter _rateLimiter;
+
+	/// @brief The packed words containing boolean inputs, by address. The words are allocated in _arena.
+	std::unordered_map<std::uint64_t, std::reference_wrapper<PackedInputWord>> _packedInputWords;
+	/// @brief The packed words containing boolean outputs, by address. The words are allocated in _arena.
+	std::unordered_map<std::uint64_t, std::reference_wrapper<PackedOutputWord>> _packedOutputWords;
+
+	/// @brief The point ranges declared in the configuration, in configuration order. The ranges are allocated in _arena.
+	std::vector<std::reference_wrapper<AbstractPointRange>> _pointRanges;
+	/// @brief The indices of the point ranges to read in the current read cycle, in the order they are read. This is only accessed
+	/// by the thread performing the read cycles.
+	std::vector<std::size_t> _cycleRanges;
+	/// @brief The index of the point range to start the next read cycle with. This is only accessed by the thread performing the read cycles.
+	std::size_t _nextRange { 0 };
+
+	/// @brief The dedicated I/O thread, if thread options are configured.
+	/// @note This must be one of the last members, so that the thread is stopped and joined before any of the other members are destroyed.
+	std::jthread _ioThread;
+	/// @brief The write dispatcher thread, if immediate writes are enabled.
+	/// @note This must be one of the last members, so that the thread is stopped and joined before any of the other members are destroyed.
+	std::jthread _writeDispatcher;
 };
 
 inline TemplateIoComponent::ErrorSink::~ErrorSink() = default;
@@ -2,6 +2,8 @@
 #include "TemplateOutput.hpp"
 
 #include "AbstractTemplateOutputHandler.hpp"
+#include "BitAddress.hpp"
+#include "PackedBitOutputHandler.hpp"
 #include "Tasks.hpp"
 #include "TemplateOutputHandler.hpp"
 
@@ -22,13 +24,55 @@ using namespace std::literals;
 
 auto TemplateOutput::load(utils::json::decoder::Object &jsonObject, config::Context &context) -> void
 {
+	std::optional<std::chrono::milliseconds> maxAge;
+	bool writeOnChange = false;
+	std::chrono::milliseconds rewriteInterval = 10s;
+
 	// Go through all the members of the JSON object that represents this object
 	for (auto && [name, value] : jsonObject)
     {
-		if (name == "dataType"sv)
+		if (name == "dataType"sv || name == "bit"sv)
 		{
+			// Make sure that only one of the two was specified
+			if (_handler)
+			{
+				/// @todo replace "template output" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value,
+					std::runtime_error("template output must specify either a data type or a bit address, but not both"));
+			}
+
 			// Create the handler
-			_handler = createHandler(value);
+			_handler = name == "bit"sv ? createBitHandler(value) : createHandler(value);
+		}
+		else if (name == "connectionEvents"sv)
+		{
+			_connectionEvents = value.asBool();
+		}
+		else if (name == "essential"sv)
+		{
+			_essential = value.asBool();
+		}
+		else if (name == "maxAge"sv)
+		{
+			maxAge = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (*maxAge <= std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template output" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("maxAge of template output must be positive"));
+			}
+		}
+		else if (name == "writeOnChange"sv)
+		{
+			writeOnChange = value.asBool();
+		}
+		else if (name == "rewriteInterval"sv)
+		{
+			rewriteInterval = std::chrono::milliseconds(value.asNumber<std::chrono::milliseconds::rep>());
+			if (rewriteInterval <= std::chrono::milliseconds::zero())
+			{
+				/// @todo replace "template output" with a more descriptive name
+				utils::json::decoder::throwWithLocation(value, std::runtime_error("rewriteInterval of template output must be positive"));
+			}
 		}
 		/// @todo load custom configuration parameters
 		else if (name == "TODO"sv)
@@ -55,7 +99,17 @@ auto TemplateOutput::load(utils::json::decoder::Object &jsonObject, config::Cont
 	if (!_handler)
 	{
 		/// @todo replace "template output" with a more descriptive name
-		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("Missing data type in template output"));
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("Missing data type or bit address in template output"));
+	}
+	// Keep the last known value in the snapshot of the I/O component
+	_handler->enableSnapshot(_ioComponent.get().snapshot());
+	// Detect values that are not updated for too long
+	_handler->enableStaleness(_ioComponent.get().arena(), _ioComponent.get().stalenessIndex(), maxAge);
+	// Skip writing values the device already has, if requested
+	if (writeOnChange && !_handler->enableWriteOnChange(rewriteInterval))
+	{
+		/// @todo replace "template output" with a more descriptive name
+		utils::json::decoder::throwWithLocation(jsonObject, std::runtime_error("writeOnChange is not supported for bit addresses in template output"));
 	}
 	/// @todo perform consistency and completeness checks
 	if (!"TODO")
@@ -65,59 +119,65 @@ auto TemplateOutput::load(utils::json::decoder::Object &jsonObject, config::Cont
 	}
 }
 
-auto TemplateOutput::createHandler(utils::json::decoder::Value &value) -> std::unique_ptr<AbstractTemplateOutputHandler>
+auto TemplateOutput::createHandler(utils::json::decoder::Value &value) -> AbstractTemplateOutputHandler *
 {
 	// Get the keyword from the value
 	auto keyword = value.asString<std::string>();
+
+	// Handlers are allocated in the arena of the I/O component, and add this output to the write lane of the component
+	// whenever a value is scheduled. While the component is down, the values are held in its forward queue instead.
+	auto &arena = _ioComponent.get().arena();
+	auto &writeLane = _ioComponent.get().writeLane();
+	auto &forwardQueue = _ioComponent.get().forwardQueue();
 	
 	/// @todo use keywords that are appropriate to the I/O component
 	if (keyword == "bool"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<bool>>();
+		return &arena.make<TemplateOutputHandler<bool>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "uint8"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::uint8_t>>();
+		return &arena.make<TemplateOutputHandler<std::uint8_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "uint16"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::uint16_t>>();
+		return &arena.make<TemplateOutputHandler<std::uint16_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "uint32"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::uint32_t>>();
+		return &arena.make<TemplateOutputHandler<std::uint32_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "uint64"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::uint64_t>>();
+		return &arena.make<TemplateOutputHandler<std::uint64_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "int8"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::int8_t>>();
+		return &arena.make<TemplateOutputHandler<std::int8_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "int16"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::int16_t>>();
+		return &arena.make<TemplateOutputHandler<std::int16_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "int32"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::int32_t>>();
+		return &arena.make<TemplateOutputHandler<std::int32_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "int64"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::int64_t>>();
+		return &arena.make<TemplateOutputHandler<std::int64_t>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "float32"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<float>>();
+		return &arena.make<TemplateOutputHandler<float>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "float64"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<double>>();
+		return &arena.make<TemplateOutputHandler<double>>(writeLane, *this, forwardQueue);
 	}
 	else if (keyword == "string"sv)
 	{
-		return std::make_unique<TemplateOutputHandler<std::string>>();
+		return &arena.make<TemplateOutputHandler<std::string>>(writeLane, *this, forwardQueue);
 	}
 
 	// The keyword is not known
@@ -127,7 +187,35 @@ auto TemplateOutput::createHandler(utils::json::decoder::Value &value) -> std::u
 		utils::json::decoder::throwWithLocation(value, std::runtime_error("unknown data type in template output"));
 	}
 
-	return std::unique_ptr<AbstractTemplateOutputHandler>();
+	return nullptr;
+}
+
+auto TemplateOutput::createBitHandler(utils::json::decoder::Value &value) -> AbstractTemplateOutputHandler *
+{
+	// Parse the address, which has the form "word.bit"
+	const auto address = BitAddress::parse(value.asString<std::string>());
+	if (!address)
+	{
+		/// @todo replace "template output" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("malformed bit address in template output"));
+	}
+	if (address->_bit >= PackedOutputWord::kBitsPerWord)
+	{
+		/// @todo replace "template output" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("bit index of template output is out of range"));
+	}
+
+	// Create the handler in the arena and attach it to the shared word. The word adds itself to the write lane of the
+	// component whenever a value is scheduled.
+	auto &ioComponent = _ioComponent.get();
+	auto &handler = ioComponent.arena().make<PackedBitOutputHandler>(ioComponent.packedOutputWord(address->_word), *this);
+	if (!handler.attach(address->_bit))
+	{
+		/// @todo replace "template output" with a more descriptive name
+		utils::json::decoder::throwWithLocation(value, std::runtime_error("bit address is used by more than one template output"));
+	}
+
+	return &handler;
 }
 
 auto TemplateOutput::performReadTask(const process::ExecutionContext &context) -> void
@@ -139,14 +227,50 @@ auto TemplateOutput::performReadTask(const process::ExecutionContext &context) -
 		throw std::logic_error("internal error: \"read\" task of xentara::plugins::templateDriver::TemplateOutput executed before configuration has been loaded");
 	}
 
-	// Only perform the read only if the I/O component is connected
-	if (!_ioComponent.get().connected())
+	// Only perform the read if the I/O component is connected. The lease keeps the connection from being torn down
+	// while we are using it.
+	const auto lease = _ioComponent.get().lease();
+	if (!lease)
+	{
+		return;
+	}
+
+	// Send any pending writes of the I/O component first, because writes take priority over reads
+	if (auto &writeLane = _ioComponent.get().writeLane(); !writeLane.empty())
+	{
+		writeLane.drain(lease, context.scheduledTime());
+	}
+
+	// Skip the read if the circuit breaker of the I/O component is open, unless the value is essential or this is a probe
+	auto &circuitBreaker = _ioComponent.get().circuitBreaker();
+	auto &rateLimiter = lease.session().rateLimiter();
+	const auto admission = circuitBreaker.admit(_essential);
+	if (admission == CircuitBreaker::Admission::Rejected)
 	{
+		// Don't hold up the other data points if it is our turn to read
+		rateLimiter.skipTurn(_rateLimitTicket);
+		return;
+	}
+
+	// Respect the rate limit of the device. We never wait for the limit, because that would hold up the thread of the task. Instead,
+	// data points that had to skip a read take turns, so that data points whose tasks happen to run last don't starve.
+	if (!rateLimiter.tryAcquireInTurn(1, _rateLimitTicket))
+	{
+		if (admission == CircuitBreaker::Admission::Probe)
+		{
+			circuitBreaker.finishProbe(false);
+		}
 		return;
 	}
 
 	// Ask the handler to read the data
-	_handler->read(context.scheduledTime(), *this);
+	_handler->read(lease, context.scheduledTime(), *this);
+
+	// If the read was a probe, the circuit breaker closes again unless the read reported an error
+	if (admission == CircuitBreaker::Admission::Probe)
+	{
+		circuitBreaker.finishProbe(true);
+	}
 }
 
 auto TemplateOutput::performWriteTask(const process::ExecutionContext &context) -> void
@@ -158,14 +282,82 @@ auto TemplateOutput::performWriteTask(const process::ExecutionContext &context)
 		throw std::logic_error("internal error: \"write\" task of xentara::plugins::templateDriver::TemplateOutput executed before configuration has been loaded");
 	}
 
-	// Only perform the read only if the I/O component is connected
-	if (!_ioComponent.get().connected())
+	// Only perform the write if the I/O component is connected. The lease keeps the connection from being torn down
+	// while we are using it.
+	const auto lease = _ioComponent.get().lease();
+	if (!lease)
 	{
 		return;
 	}
 
-	// Ask the handler to write the data
-	_handler->write(context.scheduledTime(), *this);
+	// Write any pending value. The write lane of the I/O component may have done so already.
+	performPendingWrite(lease, context.scheduledTime());
+}
+
+auto TemplateOutput::performPendingWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Only one thread may write at a time, or the values might reach the device out of order. If another thread is busy writing,
+	// we leave our request to it, so that it writes any value scheduled in the meantime once it is done. Handing the output back
+	// to the write lane instead would make the write dispatcher spin until the other thread is finished.
+	if (_writeRequests.fetch_add(1, std::memory_order_acq_rel) != 0)
+	{
+		return;
+	}
+
+	// Ask the handler to write the data, and make another pass if other threads have made requests in the meantime. A single pass
+	// handles any number of requests, because only the last value scheduled is written.
+	for (std::size_t handled = 1;; )
+	{
+		_handler->write(lease, timeStamp, *this);
+
+		const auto remaining = _writeRequests.fetch_sub(handled, std::memory_order_acq_rel) - handled;
+		if (remaining == 0)
+		{
+			break;
+		}
+		handled = remaining;
+	}
+}
+
+auto TemplateOutput::queueWrite(const Session::Lease &lease, Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp) -> bool
+{
+	// If another thread is busy writing, we cannot take part in the batch. We are written separately instead, which leaves our
+	// request to the other thread.
+	if (_writeRequests.fetch_add(1, std::memory_order_acq_rel) != 0)
+	{
+		return false;
+	}
+
+	// Let the handler add its request. If it cannot write in batches, we give up the write again, and are written separately
+	// once the batch is done. That also handles any requests made by other threads in the meantime.
+	if (!_handler->queueWrite(lease, batch, timeStamp, *this))
+	{
+		_writeRequests.store(0, std::memory_order_release);
+		return false;
+	}
+
+	return true;
+}
+
+auto TemplateOutput::finishWrite(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp)
+	-> void
+{
+	_handler->finishWrite(lease, batch, timeStamp, *this);
+	releaseBatchWrite();
+}
+
+auto TemplateOutput::abortWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+{
+	_handler->abortWrite(lease, timeStamp, error, *this);
+	releaseBatchWrite();
+}
+
+auto TemplateOutput::releaseBatchWrite() noexcept -> void
+{
+	if (_writeRequests.exchange(0, std::memory_order_acq_rel) > 1)
+	{
+		_ioComponent.get().writeLane().push(*this);
+	}
 }
 
 auto TemplateOutput::dataType() const -> const data::DataType &
@@ -298,21 +490,22 @@ auto TemplateOutput::ioComponentStateChanged(std::chrono::system_clock::time_poi
 	// Ask the handler to update its read state. We do not notify the I/O component, because that is who this message comes from in the first place.
 	// Note: the write state is not updated, because the write state simply contains the last write error, which is unaffected
 	// by I/O component errors.
-	_handler->updateReadState(timeStamp, effectiveError);
+	_handler->updateReadState(timeStamp, effectiveError, _connectionEvents);
 }
 
-auto TemplateOutput::handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error)
+auto TemplateOutput::handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error)
 	-> void
 {
 	// Just notify the I/O component. The handler will have updated its state already, before calling this function.
-	_ioComponent.get().handleError(timeStamp, error, this);
+	_ioComponent.get().circuitBreaker().recordError();
+	_ioComponent.get().handleError(lease, timeStamp, error, this);
 }
 
-auto TemplateOutput::handleWriteError(std::chrono::system_clock::time_point timeStamp, std::error_code error)
+auto TemplateOutput::handleWriteError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error)
 	-> void
 {
 	// Just notify the I/O component. The handler will have updated its state already, before calling this function.
-	_ioComponent.get().handleError(timeStamp, error, this);
+	_ioComponent.get().handleError(lease, timeStamp, error, this);
 }
 
 } // namespace xentara::plugins::templateDriver
\ No newline at end of file
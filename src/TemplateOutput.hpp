@@ -2,10 +2,12 @@
 #pragma once
 
 #include "TemplateIoComponent.hpp"
+#include "RateLimiter.hpp"
 #include "ReadState.hpp"
 #include "WriteState.hpp"
 #include "ReadTask.hpp"
 #include "SingleValueQueue.hpp"
+#include "WriteLane.hpp"
 #include "WriteTask.hpp"
 #include "AbstractTemplateOutputHandler.hpp"
 
@@ -14,6 +16,7 @@
 #include <xentara/skill/EnableSharedFromThis.hpp>
 #include <xentara/utils/json/decoder/Value.hpp>
 
+#include <atomic>
 #include <functional>
 #include <string_view>
 
@@ -28,6 +31,7 @@ class TemplateOutput final :
 	public skill::DataPoint,
 	public TemplateIoComponent::ErrorSink,
 	public AbstractTemplateOutputHandler::ErrorSink,
+	public WriteLane::Entry,
 	public skill::EnableSharedFromThis<TemplateOutput>
 {
 public:
@@ -74,9 +78,23 @@ public:
 	/// @name Virtual Overrides for AbstractTemplateOutputHandler::ErrorSink
 	/// @{
 
-	auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+	auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
 
-	auto handleWriteError(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+	auto handleWriteError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+
+	/// @}
+
+	/// @name Virtual Overrides for WriteLane::Entry
+	/// @{
+
+	auto performPendingWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void final;
+
+	auto queueWrite(const Session::Lease &lease, Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp) -> bool final;
+
+	auto finishWrite(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp)
+		-> void final;
+
+	auto abortWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
 
 	/// @}
 
@@ -85,8 +103,19 @@ private:
 	friend class ReadTask<TemplateOutput>;
 	friend class WriteTask<TemplateOutput>;
 
+	/// @brief Ends a write that was part of a batch of the write lane.
+	///
+	/// Requests to write made by other threads in the meantime are handed to the next pass of the write lane, because the
+	/// transport may still be locked by the batch.
+	auto releaseBatchWrite() noexcept -> void;
+
 	/// @brief Creates an output handler based on a configuration value
-	auto createHandler(utils::json::decoder::Value &value) -> std::unique_ptr<AbstractTemplateOutputHandler>;
+	/// @return The handler, which is allocated in the arena of the I/O component
+	auto createHandler(utils::json::decoder::Value &value) -> AbstractTemplateOutputHandler *;
+	/// @brief Creates a handler for a boolean output that refers to a bit of a word on the device
+	/// @param value The configuration value containing the bit address, in the form "word.bit"
+	/// @return The handler, which is allocated in the arena of the I/O component
+	auto createBitHandler(utils::json::decoder::Value &value) -> AbstractTemplateOutputHandler *;
 
 	/// @brief This function is forwarded to the I/O component.
 	auto requestConnect(std::chrono::system_clock::time_point timeStamp) noexcept -> void
@@ -125,8 +154,30 @@ private:
 	/// @todo give this a more descriptive name, e.g. "_device"
 	std::reference_wrapper<TemplateIoComponent> _ioComponent;
 
-	/// @brief The handler for data type specific functionality, or nullptr, if the data type hans not been loaded yet
-	std::unique_ptr<AbstractTemplateOutputHandler> _handler;
+	/// @brief The handler for data type specific functionality, or nullptr, if the data type hans not been loaded yet.
+	///
+	/// The handler is allocated in the arena of the I/O component, so that the handlers of all the data points of the
+	/// component lie close together in memory, in configuration order.
+	AbstractTemplateOutputHandler *_handler { nullptr };
+
+	/// @brief Whether to raise the *changed* event when the data is invalidated because the state of the I/O component changed.
+	///
+	/// This is false by default, so that losing the connection to a device with many data points does not cause a burst of
+	/// events. Clients that are not interested in individual data points can use the *connected* and *disconnected* events of the
+	/// I/O component instead.
+	bool _connectionEvents { false };
+
+	/// @brief Whether the value is read even while the circuit breaker of the I/O component is open
+	bool _essential { false };
+	/// @brief Our place in the queue of data points waiting for the rate limit of the I/O component, if we had to skip a read.
+	/// This is only accessed by the "read" task.
+	RateLimiter::Ticket _rateLimitTicket;
+
+	/// @brief The number of requests to write the pending value that have not been handled yet.
+	///
+	/// The thread that raises this from zero does the writing, either from the "write" task or from the write lane, and keeps
+	/// writing until all the requests made in the meantime by other threads have been handled.
+	std::atomic<std::size_t> _writeRequests { 0 };
 
 	/// @brief The "read" task
 	ReadTask<TemplateOutput> _readTask { *this };
@@ -2,6 +2,7 @@
 #include "TemplateOutputHandler.hpp"
 
 #include "Attributes.hpp"
+#include "RateLimiter.hpp"
 
 #include <xentara/data/DataType.hpp>
 #include <xentara/data/ReadHandle.hpp>
@@ -10,6 +11,10 @@
 #include <xentara/utils/eh/currentErrorCode.hpp>
 #include <xentara/utils/tools/Concepts.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 namespace xentara::plugins::templateDriver
 {
 	
@@ -19,40 +24,45 @@ template <typename ValueType>
 const model::Attribute TemplateOutputHandler<ValueType>::kValueAttribute { model::Attribute::kValue, model::Attribute::Access::ReadWrite, staticDataType() };
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+auto TemplateOutputHandler<ValueType>::read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
 {
 	try
 	{
 		// Call the other read function, but catch exceptions.
-		doRead(timeStamp);
+		doRead(lease, timeStamp);
 	}
 	catch (const std::exception &)
 	{
 		// Get the error from the current exception using this special utility function
 		const auto error = utils::eh::currentErrorCode();
 		// Handle the error
-		handleReadError(timeStamp, error, errorSink);
+		handleReadError(lease, timeStamp, error, errorSink);
 	}
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error)
+auto TemplateOutputHandler<ValueType>::updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents)
 	-> void
 {
-	_readState.update(timeStamp, utils::eh::unexpected(error));
+	// The state of the I/O component has changed, so the device may no longer have the value we wrote, for example if it was restarted
+	forgetWrittenValue();
+	_readState.update(timeStamp, utils::eh::unexpected(error), raiseEvents);
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::doRead(std::chrono::system_clock::time_point timeStamp) -> void
+auto TemplateOutputHandler<ValueType>::doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
 {
-	/// @todo read the value
+	/// @todo read the value using a Transport::Batch on lease.handle().transport(), decoding the value directly from
+	/// batch.response(), and fill in the sample time provided by the device and/or the receive time provided by the transport,
+	/// if available.
 	ValueType value = {};
+	SampleClock::ResponseTimes responseTimes;
 
 	/// @todo if the read function does not throw errors, but uses return types or internal handle state,
 	// throw an std::system_error here on failure, or call handleReadError() directly.
 
-	// The read was successful
-	_readState.update(timeStamp, value);
+	// The read was successful. Stamp the value using the configured time stamp source.
+	_readState.update(lease.session().sampleClock().timeStamp(timeStamp, responseTimes), value);
 
 	/// @todo it may be advantageous to split this function up according to value type, either using explicit 
 	/// template specialization, or using if constexpr().
@@ -82,13 +92,13 @@ auto TemplateOutputHandler<ValueType>::doRead(std::chrono::system_clock::time_po
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
+auto TemplateOutputHandler<ValueType>::handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
 	-> void
 {
 	// Update our own state
 	_readState.update(timeStamp, utils::eh::unexpected(error));
 	// Notify the error sink
-	errorSink.handleReadError(timeStamp, error);
+	errorSink.handleReadError(lease, timeStamp, error);
 }
 
 template <typename ValueType>
@@ -116,30 +126,138 @@ constexpr auto TemplateOutputHandler<ValueType>::staticDataType() -> const data:
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::write(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+auto TemplateOutputHandler<ValueType>::write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
 {
-	// Get the value
-	auto pendingValue = _pendingOutputValue.dequeue();
-	// If there was no pending value, just bail
+	// Get the value. If there is nothing to write, just bail.
+	auto pendingValue = takePendingValue(lease, timeStamp);
 	if (!pendingValue)
 	{
 		return;
 	}
 
+	// Get the time the value was scheduled. This was stored before the value was enqueued.
+	const auto scheduledTime = _scheduledTime.load(std::memory_order_relaxed);
+
 	try
 	{
 		// Call the other write function, but catch exceptions.
-		doWrite(*pendingValue, timeStamp);
+		doWrite(lease, *pendingValue, timeStamp, scheduledTime);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		const auto error = utils::eh::currentErrorCode();
+		// Handle the error
+		handleWriteError(lease, timeStamp, error, errorSink);
+	}
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::queueWrite(const Session::Lease &lease, Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+	ErrorSink &errorSink) -> bool
+{
+	// Get the value. If there is nothing to write, we don't add a request.
+	auto pendingValue = takePendingValue(lease, timeStamp);
+	if (!pendingValue)
+	{
+		return true;
+	}
+
+	try
+	{
+		// Add the request, and remember the value for finishWrite()
+		_batchRequest = batch.size();
+		encodeWrite(batch, *pendingValue);
+		_batchValue = std::move(pendingValue);
+		_batchScheduledTime = _scheduledTime.load(std::memory_order_relaxed);
+	}
+	catch (const std::exception &)
+	{
+		// Get the error from the current exception using this special utility function
+		const auto error = utils::eh::currentErrorCode();
+		// Handle the error
+		handleWriteError(lease, timeStamp, error, errorSink);
+	}
+
+	return true;
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::finishWrite(const Session::Lease &lease, const Transport::Batch &batch,
+	std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void
+{
+	// Nothing to do if we did not add a request
+	auto value = std::exchange(_batchValue, std::nullopt);
+	if (!value)
+	{
+		return;
+	}
+
+	try
+	{
+		// Decode the response directly from the receive buffer
+		decodeWrite(batch, _batchRequest);
+		written(*value, timeStamp, _batchScheduledTime);
 	}
 	catch (const std::exception &)
 	{
 		// Get the error from the current exception using this special utility function
 		const auto error = utils::eh::currentErrorCode();
 		// Handle the error
-		handleWriteError(timeStamp, error, errorSink);
+		handleWriteError(lease, timeStamp, error, errorSink);
 	}
 }
 
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::abortWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp,
+	std::error_code error, ErrorSink &errorSink) -> void
+{
+	// Nothing to do if we did not add a request
+	if (!std::exchange(_batchValue, std::nullopt))
+	{
+		return;
+	}
+
+	handleWriteError(lease, timeStamp, error, errorSink);
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::takePendingValue(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp)
+	-> std::optional<ValueType>
+{
+	// Get the value. A value that was held back by the rate limit is only written if no newer value was scheduled since.
+	auto pendingValue = _pendingOutputValue.dequeue();
+	if (auto deferredValue = _deferredOutputValue.dequeue(); !pendingValue)
+	{
+		pendingValue = std::move(deferredValue);
+	}
+	// If there was no pending value, just bail
+	if (!pendingValue)
+	{
+		return std::nullopt;
+	}
+
+	// Skip the round trip if the device already has the value. The write state is still updated, so that the write time
+	// reflects that the value was handled. The latency is left alone, because no request was sent.
+	if (_writeOnChange && alreadyWritten(*pendingValue))
+	{
+		_writeState.update(timeStamp, std::error_code());
+		return std::nullopt;
+	}
+
+	// Respect the rate limit of the device. We never wait for the limit, because that would hold up the calling thread. Instead,
+	// we keep the value, and put the output back into the write lane, which retries it once the limit allows.
+	auto &rateLimiter = lease.session().rateLimiter();
+	if (!rateLimiter.tryAcquire(1))
+	{
+		_deferredOutputValue.enqueue(std::move(*pendingValue));
+		_writeLane.get().defer(_writeLaneEntry, rateLimiter.delay(1));
+		return std::nullopt;
+	}
+
+	return pendingValue;
+}
+
 template <typename ValueType>
 auto TemplateOutputHandler<ValueType>::updateWriteState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
 {
@@ -147,37 +265,94 @@ auto TemplateOutputHandler<ValueType>::updateWriteState(std::chrono::system_cloc
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::doWrite(ValueType value, std::chrono::system_clock::time_point timeStamp) -> void
+auto TemplateOutputHandler<ValueType>::alreadyWritten(const ValueType &value) -> bool
 {
-	/// @todo write the value
+	std::scoped_lock lock { _writtenValueMutex };
+	return _writtenValue == value && !_rewriteDeadline.passed();
+}
 
-	/// @todo if the write function does not throw errors, but uses return types or internal handle state,
-	// throw an std::system_error here on failure, or call _writeState.update() directly.
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::acknowledge(const ValueType &value) noexcept -> void
+{
+	if (!_writeOnChange)
+	{
+		return;
+	}
+
+	std::scoped_lock lock { _writtenValueMutex };
+	try
+	{
+		_writtenValue = value;
+		_rewriteDeadline.arm(TimingWheel::shared(), _rewriteInterval);
+	}
+	catch (...)
+	{
+		// If we cannot track the value, we just write the next one regardless
+		_writtenValue.reset();
+	}
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::forgetWrittenValue() noexcept -> void
+{
+	if (!_writeOnChange)
+	{
+		return;
+	}
+
+	std::scoped_lock lock { _writtenValueMutex };
+	_writtenValue.reset();
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::doWrite(const Session::Lease &lease, ValueType value, std::chrono::system_clock::time_point timeStamp,
+	std::chrono::steady_clock::time_point scheduledTime) -> void
+{
+	// Operations that need several round trips, like a read-modify-write cycle, should be written as a coroutine returning
+	// Transaction<> instead, so that they don't block the calling thread. Pass a new lease from lease.session().lease() to the
+	// coroutine by value, perform each step using co_await lease.session().reactor().exchange(), and start the transaction
+	// using detach(). The coroutine must then update _writeState itself. Such values cannot be written as part of a batch, so
+	// queueWrite() must then return false.
+
+	// Send the request on its own
+	{
+		Transport::Batch batch(lease.handle().transport());
+		const auto index = batch.size();
+		encodeWrite(batch, value);
+		batch.submit();
+		decodeWrite(batch, index);
+	}
 
 	// The write was successful
-	_writeState.update(timeStamp, std::error_code());
+	written(value, timeStamp, scheduledTime);
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::encodeWrite(Transport::Batch & /*batch*/, const ValueType & /*value*/) -> void
+{
+	/// @todo add the request for writing the value to the batch, encoding it directly into the buffer returned by batch.queue()
 
 	/// @todo it may be advantageous to split this function up according to value type, either using explicit 
 	/// template specialization, or using if constexpr().
 	//
-	// For example, this function could be split into doWriteBoolean(), doWriteInteger(), doWriteFloatingPoint(),
-	// and doWriteString() functions. These functions could then be called like this:
+	// For example, this function could be split into encodeBoolean(), encodeInteger(), encodeFloatingPoint(),
+	// and encodeString() functions. These functions could then be called like this:
 	//
 	// if constexpr (std::same_as<ValueType, bool>)
 	// {
-	//     doWriteBoolean(value, timeStamp);
+	//     encodeBoolean(batch, value);
 	// }
 	// else if constexpr (utils::Tools::Integral<ValueType>)
 	// {
-	//     doWriteInteger(value, timeStamp);
+	//     encodeInteger(batch, value);
 	// }
 	// else if constexpr (std::floating_point<ValueType>)
 	// {
-	//     doWriteFloatingPoint(value, timeStamp);
+	//     encodeFloatingPoint(batch, value);
 	// }
 	// else if constexpr (utils::tools::StringType<ValueType>)
 	// {
-	//     doWriteString(value, timeStamp);
+	//     encodeString(batch, value);
 	// }
 	//
 	// To determine if a type is an integer type, you should use xentara::utils::Tools::Integral instead of std::integral,
@@ -185,13 +360,95 @@ auto TemplateOutputHandler<ValueType>::doWrite(ValueType value, std::chrono::sys
 }
 
 template <typename ValueType>
-auto TemplateOutputHandler<ValueType>::handleWriteError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
+auto TemplateOutputHandler<ValueType>::decodeWrite(const Transport::Batch & /*batch*/, std::size_t /*index*/) -> void
+{
+	/// @todo check the response, which can be gotten using batch.response(index). If the response contains an error,
+	/// throw an std::system_error.
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::written(const ValueType &value, std::chrono::system_clock::time_point timeStamp,
+	std::chrono::steady_clock::time_point scheduledTime) -> void
+{
+	// The device has acknowledged the value, so this is the end of the write latency.
+	_writeState.update(timeStamp, std::error_code(), std::chrono::steady_clock::now() - scheduledTime);
+	// Remember the value, so that writing it again can be skipped
+	acknowledge(value);
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::forwardValue(const ValueType &value) noexcept -> bool
+{
+	auto &forwardQueue = _forwardQueue.get();
+
+	// Values are stored using their raw bytes, or the characters for strings
+	const auto bytes = [](const ValueType &forwarded) {
+		if constexpr (utils::tools::StringType<ValueType>)
+		{
+			return std::as_bytes(std::span(forwarded));
+		}
+		else
+		{
+			return std::as_bytes(std::span(&forwarded, 1));
+		}
+	};
+
+	// A value that was scheduled before the queue started holding, but never written, must go first, so that the order of the values
+	// is kept. If the queue has stopped holding in the meantime, the new value replaces the old one as usual. A value held back
+	// by the rate limit is even older, unless it has been replaced by a pending value.
+	auto pendingValue = _pendingOutputValue.dequeue();
+	if (auto deferredValue = _deferredOutputValue.dequeue(); !pendingValue)
+	{
+		pendingValue = std::move(deferredValue);
+	}
+	if (pendingValue)
+	{
+		forwardQueue.tryPush(_forwardQueueIndex, bytes(*pendingValue));
+	}
+
+	return forwardQueue.tryPush(_forwardQueueIndex, bytes(value));
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::replay(
+	const Session::Lease &lease, std::span<const std::byte> record, std::chrono::system_clock::time_point timeStamp) -> std::error_code
+{
+	// Decode the value
+	ValueType value {};
+	if constexpr (utils::tools::StringType<ValueType>)
+	{
+		value.assign(reinterpret_cast<const typename ValueType::value_type *>(record.data()), record.size() / sizeof(typename ValueType::value_type));
+	}
+	else
+	{
+		std::memcpy(&value, record.data(), std::min(record.size(), sizeof(value)));
+	}
+
+	try
+	{
+		// The time the value was originally scheduled is not stored, so the write latency only covers the write itself
+		doWrite(lease, value, timeStamp, std::chrono::steady_clock::now());
+		return {};
+	}
+	catch (const std::exception &)
+	{
+		// Update our own state. The caller takes care of notifying the I/O component.
+		const auto error = utils::eh::currentErrorCode();
+		forgetWrittenValue();
+		_writeState.update(timeStamp, error);
+		return error;
+	}
+}
+
+template <typename ValueType>
+auto TemplateOutputHandler<ValueType>::handleWriteError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink)
 	-> void
 {
-	// Update our own state
+	// Update our own state. We don't know whether the device took the value, so the next value must be written in any case.
+	forgetWrittenValue();
 	_writeState.update(timeStamp, error);
 	// Notify the error sink
-	errorSink.handleWriteError(timeStamp, error);
+	errorSink.handleWriteError(lease, timeStamp, error);
 }
 
 template <typename ValueType>
@@ -2,12 +2,24 @@
 #pragma once
 
 #include "AbstractTemplateOutputHandler.hpp"
+#include "ForwardQueue.hpp"
 #include "ReadState.hpp"
 #include "WriteState.hpp"
 #include "SingleValueQueue.hpp"
+#include "TimingWheel.hpp"
+#include "WriteLane.hpp"
 
 #include <xentara/model/Attribute.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 
 namespace xentara::plugins::templateDriver
@@ -23,9 +35,21 @@ using namespace std::literals;
 /// For example, this class could be split into TemplateBooleanOutputHandler, TemplateIntegerOutputHandler,
 /// and TemplateFloatingPointOutputHandler classes.
 template <typename ValueType>
-class TemplateOutputHandler final : public AbstractTemplateOutputHandler
+class TemplateOutputHandler final : public AbstractTemplateOutputHandler, private ForwardQueue::Entry
 {
 public:
+	/// @brief Constructor
+	/// @param writeLane The write lane of the I/O component
+	/// @param writeLaneEntry The entry to add to the write lane when a value is scheduled
+	/// @param forwardQueue The forward queue of the I/O component that holds values while the component is down
+	TemplateOutputHandler(WriteLane &writeLane, WriteLane::Entry &writeLaneEntry, ForwardQueue &forwardQueue) :
+		_writeLane(writeLane),
+		_writeLaneEntry(writeLaneEntry),
+		_forwardQueue(forwardQueue),
+		_forwardQueueIndex(forwardQueue.attach(*this, forwardQueueType()))
+	{
+	}
+
 	/// @name Virtual Overrides for AbstractTemplateOutputHandler
 	/// @{
 
@@ -40,12 +64,38 @@ public:
 	auto makeWriteHandle(const model::Attribute &attribute, std::shared_ptr<void> parent) noexcept -> std::optional<data::WriteHandle> final;
 
 	auto realize() -> void final;
+
+	auto enableSnapshot(Snapshot &snapshot) -> void final
+	{
+		_readState.enableSnapshot(snapshot);
+	}
+
+	auto enableStaleness(Arena &arena, StalenessIndex &index, std::optional<std::chrono::milliseconds> maxAge) -> void final
+	{
+		_readState.enableStaleness(arena, index, maxAge);
+	}
+
+	auto enableWriteOnChange(std::chrono::milliseconds rewriteInterval) -> bool final
+	{
+		_writeOnChange = true;
+		_rewriteInterval = rewriteInterval;
+		return true;
+	}
 		
-	auto read(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
+	auto read(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;
 	
-	auto updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
+	auto updateReadState(std::chrono::system_clock::time_point timeStamp, std::error_code error, bool raiseEvents) -> void final;
+
+	auto write(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;	
 
-	auto write(std::chrono::system_clock::time_point timeStamp, ErrorSink &errorSink) -> void final;	
+	auto queueWrite(const Session::Lease &lease, Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		ErrorSink &errorSink) -> bool final;
+
+	auto finishWrite(const Session::Lease &lease, const Transport::Batch &batch, std::chrono::system_clock::time_point timeStamp,
+		ErrorSink &errorSink) -> void final;
+
+	auto abortWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error,
+		ErrorSink &errorSink) -> void final;
 
 	auto updateWriteState(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void final;
 
@@ -58,14 +108,82 @@ public:
 
 private:
 	/// @brief The actual implementation of read(), which may throw exceptions on error.
-	auto doRead(std::chrono::system_clock::time_point timeStamp) -> void;
+	auto doRead(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
 	/// @brief Handles a read error
-	auto handleReadError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
+	auto handleReadError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
+
+	/// @brief Takes the value to write next, if there is one
+	/// @param lease A lease on the session to use
+	/// @param timeStamp The time stamp to use if the value is skipped
+	/// @return The value, or std::nullopt if there is no value, or if it was skipped or held back by the rate limit
+	auto takePendingValue(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> std::optional<ValueType>;
 
 	/// @brief The actual implementation of write(), which may throw exceptions on error.
-	auto doWrite(ValueType value, std::chrono::system_clock::time_point timeStamp) -> void;	
+	/// @param scheduledTime The time the value was scheduled, used to measure the write latency
+	auto doWrite(const Session::Lease &lease, ValueType value, std::chrono::system_clock::time_point timeStamp,
+		std::chrono::steady_clock::time_point scheduledTime) -> void;	
+	/// @brief Adds the request for writing a value to a batch
+	/// @param batch The batch
+	/// @param value The value
+	auto encodeWrite(Transport::Batch &batch, const ValueType &value) -> void;
+	/// @brief Decodes the response to a write request
+	/// @param batch The batch. This must have been submitted successfully.
+	/// @param index The index of the request in the batch
+	/// @throw std::system_error if the device reported an error
+	auto decodeWrite(const Transport::Batch &batch, std::size_t index) -> void;
+	/// @brief Updates the state after the device has acknowledged a value
+	/// @param scheduledTime The time the value was scheduled, used to measure the write latency
+	auto written(const ValueType &value, std::chrono::system_clock::time_point timeStamp, std::chrono::steady_clock::time_point scheduledTime)
+		-> void;
+	/// @brief Checks whether a value can be skipped because the device has already acknowledged it, and it is not due to be
+	/// written again yet.
+	auto alreadyWritten(const ValueType &value) -> bool;
+	/// @brief Records a value acknowledged by the device, if write-on-change is enabled
+	auto acknowledge(const ValueType &value) noexcept -> void;
+	/// @brief Forgets the last acknowledged value, so that the next value is written in any case
+	auto forgetWrittenValue() noexcept -> void;
+
 	/// @brief Handles a write error
-	auto handleWriteError(std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
+	auto handleWriteError(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp, std::error_code error, ErrorSink &errorSink) -> void;
+
+	/// @name Virtual Overrides for ForwardQueue::Entry
+	/// @{
+
+	auto replay(const Session::Lease &lease, std::span<const std::byte> record, std::chrono::system_clock::time_point timeStamp)
+		-> std::error_code final;
+
+	///@}
+
+	/// @brief Returns a value identifying how values are stored in the forward queue
+	///
+	/// Values are stored using their raw bytes, so the type consists of the kind of type and its size.
+	static constexpr auto forwardQueueType() noexcept -> std::uint32_t
+	{
+		if constexpr (std::same_as<ValueType, bool>)
+		{
+			return 'b';
+		}
+		else if constexpr (std::signed_integral<ValueType>)
+		{
+			return 'i' << 8 | sizeof(ValueType);
+		}
+		else if constexpr (std::unsigned_integral<ValueType>)
+		{
+			return 'u' << 8 | sizeof(ValueType);
+		}
+		else if constexpr (std::floating_point<ValueType>)
+		{
+			return 'f' << 8 | sizeof(ValueType);
+		}
+		else
+		{
+			return 's';
+		}
+	}
+
+	/// @brief Appends a value to the forward queue, together with any value that is still pending from before the queue started holding.
+	/// @return true if the queue took over the value, or false if the queue has stopped holding in the meantime.
+	auto forwardValue(const ValueType &value) noexcept -> bool;
 
 	/// @brief Determines the correct data type based on the *ValueType* template parameter
 	///
@@ -74,10 +192,21 @@ private:
 
 	/// @brief Schedules a value to be written.
 	///
-	/// This function is called by the value write handle.
+	/// This function is called by the value write handle. The value is written by the next pass of the write lane of the
+	/// I/O component, or by the next "write" task, whichever comes first.
 	auto scheduleOutputValue(ValueType value) noexcept
 	{
+		// Store the time before enqueuing the value, so that whoever dequeues the value sees the time as well
+		_scheduledTime.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+
+		// While the I/O component is down, the value is held in the forward queue instead
+		if (_forwardQueue.get().holding() && forwardValue(value)) [[unlikely]]
+		{
+			return;
+		}
+
 		_pendingOutputValue.enqueue(value);
+		_writeLane.get().push(_writeLaneEntry);
 	}
 
 	/// @brief The read state
@@ -87,6 +216,38 @@ private:
 
 	/// @brief The queue for the pending output value
 	SingleValueQueue<ValueType> _pendingOutputValue;
+	/// @brief A value that was held back by the rate limit of the I/O component. A newer pending value replaces it.
+	SingleValueQueue<ValueType> _deferredOutputValue;
+	/// @brief The time the last value was scheduled
+	std::atomic<std::chrono::steady_clock::time_point> _scheduledTime;
+
+	/// @brief The value added to the current batch by queueWrite(), or std::nullopt if none was added
+	std::optional<ValueType> _batchValue;
+	/// @brief The time the value in the current batch was scheduled
+	std::chrono::steady_clock::time_point _batchScheduledTime;
+	/// @brief The index of the request added to the current batch by queueWrite()
+	std::size_t _batchRequest { 0 };
+
+	/// @brief Whether to skip writes of values the device has already acknowledged
+	bool _writeOnChange { false };
+	/// @brief The time after which an unchanged value is written again anyway
+	std::chrono::milliseconds _rewriteInterval { 0 };
+	/// @brief A mutex protecting the last acknowledged value
+	std::mutex _writtenValueMutex;
+	/// @brief The last value acknowledged by the device, or std::nullopt if it is unknown
+	std::optional<ValueType> _writtenValue;
+	/// @brief The deadline after which the acknowledged value must be written again
+	TimingWheel::Deadline _rewriteDeadline;
+
+	/// @brief The write lane of the I/O component
+	std::reference_wrapper<WriteLane> _writeLane;
+	/// @brief The entry to add to the write lane
+	std::reference_wrapper<WriteLane::Entry> _writeLaneEntry;
+
+	/// @brief The forward queue of the I/O component
+	std::reference_wrapper<ForwardQueue> _forwardQueue;
+	/// @brief Our index in the forward queue
+	std::uint32_t _forwardQueueIndex;
 };
 
 /// @class xentara::plugins::templateDriver::TemplateOutputHandler
@@ -0,0 +1,84 @@
+// Copyright (c) embedded ocean GmbH
+#include "ThreadOptions.hpp"
+
+#include <system_error>
+
+#ifndef _WIN32
+#	include <errno.h>
+#	include <pthread.h>
+#	include <sched.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace xentara::plugins::templateDriver
+{
+
+#ifndef _WIN32
+
+auto ThreadOptions::cpuLimit() noexcept -> unsigned
+{
+	// CPU_SET() silently ignores CPUs that don't fit into the mask
+	const auto configured = ::sysconf(_SC_NPROCESSORS_CONF);
+	return configured > 0 ? unsigned(std::min<long>(configured, CPU_SETSIZE)) : unsigned(CPU_SETSIZE);
+}
+
+auto ThreadOptions::apply(std::jthread &thread) const -> void
+{
+	const auto handle = thread.native_handle();
+
+	// Pin the thread to the CPUs
+	if (!_cpus.empty())
+	{
+		::cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		for (auto cpu : _cpus)
+		{
+			CPU_SET(cpu, &cpus);
+		}
+		if (const auto error = ::pthread_setaffinity_np(handle, sizeof(cpus), &cpus))
+		{
+			throw std::system_error(error, std::system_category(), "could not set the CPU affinity of an I/O thread");
+		}
+	}
+
+	// Use the real-time scheduling policy. This requires CAP_SYS_NICE or a suitable RLIMIT_RTPRIO.
+	if (_priority > 0)
+	{
+		::sched_param parameters {};
+		parameters.sched_priority = _priority;
+		if (const auto error = ::pthread_setschedparam(handle, SCHED_FIFO, &parameters))
+		{
+			throw std::system_error(error, std::system_category(), "could not set the real-time priority of an I/O thread");
+		}
+	}
+
+	// Lock the memory. This affects the whole process, including memory allocated later.
+	if (_lockMemory && ::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+	{
+		throw std::system_error(errno, std::system_category(), "could not lock the memory of the process");
+	}
+}
+
+#else // _WIN32
+
+auto ThreadOptions::cpuLimit() noexcept -> unsigned
+{
+	// SetThreadAffinityMask() takes a pointer-sized mask with one bit per CPU
+	return unsigned(sizeof(void *) * 8);
+}
+
+auto ThreadOptions::apply(std::jthread &thread) const -> void
+{
+	/// @todo implement using SetThreadAffinityMask(), SetThreadPriority(), and VirtualLock()
+	if (!_cpus.empty() || _priority > 0 || _lockMemory)
+	{
+		throw std::system_error(std::make_error_code(std::errc::function_not_supported), "thread options are not supported on this platform");
+	}
+}
+
+#endif // _WIN32
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
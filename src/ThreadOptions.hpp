@@ -0,0 +1,31 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <thread>
+#include <vector>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Scheduling options for the threads of an I/O component
+struct ThreadOptions final
+{
+	/// @brief The CPUs the thread may run on, or an empty list to let the thread run on any CPU
+	std::vector<unsigned> _cpus;
+	/// @brief The real-time priority of the thread, or zero to use the normal scheduling policy
+	int _priority { 0 };
+	/// @brief Whether to lock the memory of the process, so that the thread never waits for a page fault
+	bool _lockMemory { false };
+
+	/// @brief Returns the number of CPUs that can be used in the CPU list.
+	///
+	/// This is the number of CPUs configured in the system, limited to the number of CPUs the affinity mask can hold.
+	static auto cpuLimit() noexcept -> unsigned;
+
+	/// @brief Applies the options to a thread
+	/// @param thread The thread. The thread must be running.
+	/// @throw std::system_error if the options could not be applied, e.g. due to missing privileges
+	auto apply(std::jthread &thread) const -> void;
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
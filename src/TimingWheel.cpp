@@ -0,0 +1,170 @@
+// Copyright (c) embedded ocean GmbH
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+
+namespace xentara::plugins::templateDriver
+{
+
+TimingWheel::TimingWheel() :
+	_epoch(Clock::now()),
+	_thread([this](std::stop_token stopToken) { run(stopToken); })
+{
+}
+
+auto TimingWheel::shared() -> TimingWheel &
+{
+	static TimingWheel kWheel;
+	return kWheel;
+}
+
+auto TimingWheel::schedule(Timer &timer, Clock::duration delay) -> void
+{
+	// Round the delay up to whole ticks
+	const auto ticks = std::chrono::ceil<std::chrono::milliseconds>(delay) / kResolution;
+	const auto clampedTicks = std::uint64_t(std::clamp<decltype(ticks)>(ticks, 0, kMaxDelay - 1));
+
+	// Count from the end of the current tick, so that the timer never expires early
+	const auto currentTick = std::uint64_t((Clock::now() - _epoch) / kResolution);
+
+	std::scoped_lock lock(_mutex);
+
+	// Remove the timer if it is already scheduled
+	if (timer._link)
+	{
+		unlink(timer);
+		--_timerCount;
+	}
+	// If the wheel is idle, the thread has stopped advancing it, so bring it up to date first. This is safe because there are no
+	// timers that could be skipped.
+	else if (_timerCount == 0)
+	{
+		_now = std::max(_now, currentTick);
+	}
+
+	timer._expiry = std::max(_now, currentTick) + clampedTicks + 1;
+	insert(timer);
+
+	// Wake up the thread if it is idle
+	if (_timerCount++ == 0)
+	{
+		_changed.notify_all();
+	}
+}
+
+auto TimingWheel::cancel(Timer &timer) noexcept -> bool
+{
+	std::unique_lock lock(_mutex);
+
+	// Remove the timer if it is still scheduled
+	if (timer._link)
+	{
+		unlink(timer);
+		--_timerCount;
+		return true;
+	}
+
+	// Wait for the timer to finish expiring, so that the caller can safely destroy it
+	_changed.wait(lock, [&]() { return _expiring != &timer; });
+	return false;
+}
+
+auto TimingWheel::insert(Timer &timer) noexcept -> void
+{
+	// Find the lowest level whose range covers the delay. Each level covers kSlotCount times the range of the level below.
+	const auto delay = timer._expiry - _now;
+	std::size_t level = 0;
+	while (level < kLevelCount - 1 && delay >= (std::uint64_t(1) << (kSlotBits * (level + 1))))
+	{
+		++level;
+	}
+
+	// Link the timer into the slot of its expiry tick at that level
+	auto &head = _slots[level][(timer._expiry >> (kSlotBits * level)) & (kSlotCount - 1)];
+	timer._next = head;
+	if (head)
+	{
+		head->_link = &timer._next;
+	}
+	head = &timer;
+	timer._link = &head;
+}
+
+auto TimingWheel::unlink(Timer &timer) noexcept -> void
+{
+	*timer._link = timer._next;
+	if (timer._next)
+	{
+		timer._next->_link = timer._link;
+	}
+	timer._next = nullptr;
+	timer._link = nullptr;
+}
+
+auto TimingWheel::tick(std::unique_lock<std::mutex> &lock) -> void
+{
+	++_now;
+
+	// Whenever a level wraps around, move the timers of the next slot of the level above down, so that they end up in the
+	// slots for their exact expiry ticks as they get closer.
+	for (std::size_t level = 1; level < kLevelCount; ++level)
+	{
+		// Stop if the level below has not wrapped around
+		if ((_now & ((std::uint64_t(1) << (kSlotBits * level)) - 1)) != 0)
+		{
+			break;
+		}
+
+		auto &slot = _slots[level][(_now >> (kSlotBits * level)) & (kSlotCount - 1)];
+		while (auto timer = slot)
+		{
+			unlink(*timer);
+			insert(*timer);
+		}
+	}
+
+	// Fire the timers that expire on this tick, one at a time, so that cancel() can remove the others while we are not holding the lock
+	auto &slot = _slots[0][_now & (kSlotCount - 1)];
+	while (auto timer = slot)
+	{
+		unlink(*timer);
+		--_timerCount;
+
+		_expiring = timer;
+		lock.unlock();
+		timer->expired();
+		lock.lock();
+		_expiring = nullptr;
+		_changed.notify_all();
+	}
+}
+
+auto TimingWheel::run(std::stop_token stopToken) -> void
+{
+	std::unique_lock lock(_mutex);
+	while (!stopToken.stop_requested())
+	{
+		// Sleep until a timer is scheduled
+		if (!_changed.wait(lock, stopToken, [this]() { return _timerCount != 0; }))
+		{
+			break;
+		}
+
+		// Sleep until the next tick
+		const auto nextTick = _epoch + (_now + 1) * kResolution;
+		if (_changed.wait_until(lock, stopToken, nextTick, []() { return false; }); stopToken.stop_requested())
+		{
+			break;
+		}
+
+		// Catch up with all the ticks that have elapsed. This also fires timers that were scheduled while we were sleeping.
+		const auto currentTick = std::uint64_t((Clock::now() - _epoch) / kResolution);
+		while (_now < currentTick && _timerCount != 0)
+		{
+			tick(lock);
+		}
+		_now = std::max(_now, currentTick);
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,182 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief A hierarchical timing wheel for timeouts and deadlines.
+///
+/// Timers are kept in intrusive lists in a fixed number of slots, so scheduling and cancelling a timer takes constant time,
+/// regardless of how many timers are outstanding. Each level of the wheel covers a range of time 64 times as large as the one
+/// below it. Timers in the upper levels are moved down a level whenever the level below wraps around.
+///
+/// The wheel has its own thread, which advances it once per tick and calls the timers that have expired. A single wheel is
+/// shared by all the I/O components of the driver.
+class TimingWheel final : private utils::tools::Unique
+{
+public:
+	/// @brief The clock used by the wheel
+	using Clock = std::chrono::steady_clock;
+
+	/// @brief The duration of a tick. Timers never expire early, but may expire up to about one tick late.
+	static constexpr std::chrono::milliseconds kResolution = 1ms;
+
+	/// @brief Base class for timers
+	class Timer
+	{
+	public:
+		/// @brief Virtual destructor
+		/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+		/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+		/// instantiable by accident as a result of refactoring.
+		///
+		/// Derived classes must make sure the timer is cancelled before the derived object is destroyed.
+		virtual ~Timer() = 0;
+
+	private:
+		/// @brief Called on the thread of the wheel when the timer expires.
+		///
+		/// This must return quickly, because it holds up all the other timers.
+		virtual auto expired() noexcept -> void = 0;
+
+		/// @brief The wheel manages the timer
+		friend class TimingWheel;
+
+		/// @brief The tick the timer expires at
+		std::uint64_t _expiry { 0 };
+		/// @brief The next timer in the same slot
+		Timer *_next { nullptr };
+		/// @brief The pointer that points to this timer, or nullptr if the timer is not scheduled
+		Timer **_link { nullptr };
+	};
+
+	/// @brief A timer that simply records whether a deadline has passed.
+	///
+	/// The deadline is cancelled automatically when it is destroyed.
+	class Deadline final : public Timer
+	{
+	public:
+		/// @brief Destructor. Cancels the deadline if it is armed.
+		~Deadline()
+		{
+			disarm();
+		}
+
+		/// @brief Arms the deadline
+		/// @param wheel The wheel to use
+		/// @param delay The time from now after which the deadline has passed
+		auto arm(TimingWheel &wheel, Clock::duration delay) -> void
+		{
+			// Disarm the deadline first, so that it cannot expire on the old schedule after we have reset it
+			disarm();
+			_passed.store(false, std::memory_order_relaxed);
+			_wheel = &wheel;
+			wheel.schedule(*this, delay);
+		}
+
+		/// @brief Disarms the deadline, if it is armed.
+		///
+		/// After this function returns, passed() no longer changes until the deadline is armed again.
+		auto disarm() noexcept -> void
+		{
+			if (_wheel)
+			{
+				_wheel->cancel(*this);
+			}
+		}
+
+		/// @brief Checks whether the deadline has passed. Deadlines that were never armed count as passed.
+		auto passed() const noexcept -> bool
+		{
+			return _passed.load(std::memory_order_acquire);
+		}
+
+	private:
+		auto expired() noexcept -> void final
+		{
+			_passed.store(true, std::memory_order_release);
+		}
+
+		/// @brief The wheel the deadline was last armed with
+		TimingWheel *_wheel { nullptr };
+		/// @brief Whether the deadline has passed
+		std::atomic<bool> _passed { true };
+	};
+
+	/// @brief Returns the wheel shared by all I/O components. The thread of the wheel is started on first use.
+	static auto shared() -> TimingWheel &;
+
+	/// @brief Schedules a timer, or reschedules it if it is already scheduled
+	/// @param timer The timer
+	/// @param delay The time from now after which the timer expires. This is clamped to the range of the wheel.
+	auto schedule(Timer &timer, Clock::duration delay) -> void;
+
+	/// @brief Cancels a timer.
+	///
+	/// If the timer is expiring on the thread of the wheel at the same time, this function waits until it is finished.
+	/// @return true if the timer was cancelled, or false if it was not scheduled, or has already expired
+	auto cancel(Timer &timer) noexcept -> bool;
+
+private:
+	/// @brief The number of bits of a tick count used for the slot index of each level
+	static constexpr unsigned kSlotBits = 6;
+	/// @brief The number of slots per level
+	static constexpr std::size_t kSlotCount = 1 << kSlotBits;
+	/// @brief The number of levels
+	static constexpr std::size_t kLevelCount = 4;
+	/// @brief The longest delay the wheel can handle, in ticks
+	static constexpr std::uint64_t kMaxDelay = (std::uint64_t(1) << (kSlotBits * kLevelCount)) - 1;
+
+	/// @brief Private constructor. Use shared().
+	TimingWheel();
+
+	/// @brief Adds a timer to the slot it belongs in. The caller must hold _mutex.
+	auto insert(Timer &timer) noexcept -> void;
+
+	/// @brief Removes a timer from its slot. The caller must hold _mutex.
+	static auto unlink(Timer &timer) noexcept -> void;
+
+	/// @brief Advances the wheel by one tick, and fires the expired timers. The caller must hold the lock.
+	auto tick(std::unique_lock<std::mutex> &lock) -> void;
+
+	/// @brief The function executed by the thread of the wheel
+	auto run(std::stop_token stopToken) -> void;
+
+	/// @brief The time of tick 0
+	Clock::time_point _epoch;
+	/// @brief The current tick
+	std::uint64_t _now { 0 };
+	/// @brief The number of scheduled timers
+	std::size_t _timerCount { 0 };
+	/// @brief The slots of all the levels
+	std::array<std::array<Timer *, kSlotCount>, kLevelCount> _slots {};
+
+	/// @brief The timer that is currently expiring, or nullptr
+	Timer *_expiring { nullptr };
+
+	/// @brief Protects all the data of the wheel
+	std::mutex _mutex;
+	/// @brief Used to wake the thread when the first timer is scheduled, and to wait for expiring timers
+	std::condition_variable_any _changed;
+
+	/// @brief The thread. This must be the last member, so the thread is stopped before anything else is destroyed.
+	std::jthread _thread;
+};
+
+inline TimingWheel::Timer::~Timer() = default;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,219 @@
+// Copyright (c) embedded ocean GmbH
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace xentara::plugins::templateDriver
+{
+
+namespace
+{
+
+	/// @brief A span in the buffer of a thread.
+	///
+	/// The members are atomic, because the buffer may be read while the thread overwrites old spans. Relaxed atomic loads and
+	/// stores compile to plain memory accesses.
+	struct Event final
+	{
+		/// @brief The name
+		std::atomic<const char *> _name { nullptr };
+		/// @brief The category
+		std::atomic<const char *> _category { nullptr };
+		/// @brief The start time
+		std::atomic<Trace::Clock::rep> _start { 0 };
+		/// @brief The end time
+		std::atomic<Trace::Clock::rep> _end { 0 };
+	};
+
+	/// @brief A copy of an event taken while exporting the trace
+	struct Sample final
+	{
+		/// @brief The number of the event
+		std::uint64_t _number;
+		/// @brief The name
+		const char *_name;
+		/// @brief The category
+		const char *_category;
+		/// @brief The start time
+		Trace::Clock::rep _start;
+		/// @brief The end time
+		Trace::Clock::rep _end;
+	};
+
+	/// @brief The ring buffer of a thread
+	struct Buffer final
+	{
+		/// @brief Constructor
+		Buffer(std::size_t threadId, std::size_t capacity) :
+			_threadId(threadId), _capacity(capacity), _events(std::make_unique<Event[]>(capacity))
+		{
+		}
+
+		/// @brief The number used to identify the thread in the trace
+		std::size_t _threadId;
+		/// @brief The number of events the buffer holds
+		std::size_t _capacity;
+		/// @brief The events. Event number n is stored at index n % _capacity.
+		std::unique_ptr<Event[]> _events;
+		/// @brief The number of events recorded so far. Only the last _capacity events are still in the buffer.
+		std::atomic<std::uint64_t> _count { 0 };
+	};
+
+	/// @brief The buffers of all threads
+	struct Registry final
+	{
+		/// @brief A mutex protecting the registry
+		std::mutex _mutex;
+		/// @brief The buffers. Buffers are kept after their thread has exited, so that its spans are still exported.
+		std::vector<std::shared_ptr<Buffer>> _buffers;
+		/// @brief The size of new buffers
+		std::size_t _capacity { 0 };
+		/// @brief The time all time stamps in the trace are relative to
+		Trace::Clock::time_point _origin { Trace::Clock::now() };
+	};
+
+	/// @brief Returns the registry
+	auto registry() -> Registry &
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	/// @brief Returns the buffer of the calling thread, creating it if necessary
+	auto threadBuffer() -> Buffer &
+	{
+		thread_local std::shared_ptr<Buffer> buffer;
+		if (!buffer) [[unlikely]]
+		{
+			auto &registry = templateDriver::registry();
+			std::scoped_lock lock { registry._mutex };
+			buffer = std::make_shared<Buffer>(registry._buffers.size() + 1, registry._capacity);
+			registry._buffers.push_back(buffer);
+		}
+		return *buffer;
+	}
+
+	/// @brief Writes a duration in microseconds with three decimal places, as used by the Chrome trace event format
+	auto writeMicroseconds(std::ostream &stream, Trace::Clock::duration duration) -> void
+	{
+		const auto nanoseconds = std::max<std::chrono::nanoseconds::rep>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), 0);
+		stream << nanoseconds / 1000 << '.'
+			<< char('0' + nanoseconds / 100 % 10) << char('0' + nanoseconds / 10 % 10) << char('0' + nanoseconds % 10);
+	}
+
+} // namespace
+
+auto Trace::enable(std::size_t bufferSize) -> void
+{
+	auto &registry = templateDriver::registry();
+	{
+		std::scoped_lock lock { registry._mutex };
+		registry._capacity = std::max(registry._capacity, bufferSize);
+	}
+
+	_enabled.store(true, std::memory_order_relaxed);
+}
+
+auto Trace::record(const char *name, const char *category, Clock::time_point start, Clock::time_point end) noexcept -> void
+{
+	try
+	{
+		auto &buffer = threadBuffer();
+
+		// Only this thread writes to the buffer, so we can simply overwrite the oldest event, and then publish it
+		const auto count = buffer._count.load(std::memory_order_relaxed);
+		auto &event = buffer._events[count % buffer._capacity];
+		event._name.store(name, std::memory_order_relaxed);
+		event._category.store(category, std::memory_order_relaxed);
+		event._start.store(start.time_since_epoch().count(), std::memory_order_relaxed);
+		event._end.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+		buffer._count.store(count + 1, std::memory_order_release);
+	}
+	catch (...)
+	{
+		// If the buffer could not be allocated, the span is simply lost
+	}
+}
+
+auto Trace::write(std::ostream &stream) -> void
+{
+	auto &registry = templateDriver::registry();
+
+	// Copy the list of buffers, so that new threads are not held up while we write
+	std::vector<std::shared_ptr<Buffer>> buffers;
+	{
+		std::scoped_lock lock { registry._mutex };
+		buffers = registry._buffers;
+	}
+
+	stream << R"({"displayTimeUnit":"ns","traceEvents":[)";
+	bool first = true;
+	for (auto &&buffer : buffers)
+	{
+		// Copy the events that are still in the buffer
+		const auto count = buffer->_count.load(std::memory_order_acquire);
+		auto begin = count > buffer->_capacity ? count - buffer->_capacity : 0;
+		std::vector<Sample> samples;
+		samples.reserve(std::size_t(count - begin));
+		for (auto number = begin; number < count; ++number)
+		{
+			const auto &event = buffer->_events[number % buffer->_capacity];
+			samples.push_back({ number,
+				event._name.load(std::memory_order_relaxed),
+				event._category.load(std::memory_order_relaxed),
+				event._start.load(std::memory_order_relaxed),
+				event._end.load(std::memory_order_relaxed) });
+		}
+
+		// Discard the events the thread may have overwritten while we were copying them. The thread may also be busy
+		// overwriting the event after the last one it has published.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const auto current = buffer->_count.load(std::memory_order_relaxed);
+		const auto valid = current >= buffer->_capacity ? current - buffer->_capacity + 1 : 0;
+
+		for (auto &&sample : samples)
+		{
+			if (sample._number < valid)
+			{
+				continue;
+			}
+
+			const auto start = Clock::time_point(Clock::duration(sample._start));
+			const auto end = Clock::time_point(Clock::duration(sample._end));
+			stream << (first ? "" : ",")
+				<< R"({"name":")" << sample._name
+				<< R"(","cat":")" << sample._category
+				<< R"(","ph":"X","pid":1,"tid":)" << buffer->_threadId
+				<< R"(,"ts":)";
+			writeMicroseconds(stream, start - registry._origin);
+			stream << R"(,"dur":)";
+			writeMicroseconds(stream, end - start);
+			stream << "}";
+			first = false;
+		}
+	}
+	stream << "]}\n";
+}
+
+auto Trace::dump(const std::filesystem::path &path) -> void
+{
+	// Write to a temporary file first, and then replace the actual file
+	auto temporaryPath = path;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream stream;
+		stream.exceptions(std::ios::failbit | std::ios::badbit);
+		stream.open(temporaryPath, std::ios::out | std::ios::trunc);
+		write(stream);
+	}
+	std::filesystem::rename(temporaryPath, path);
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
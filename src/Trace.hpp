@@ -0,0 +1,94 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief Records the time spent in tasks, I/O operations, and commits, for analysis of overrunning cycles.
+///
+/// Each thread records its spans into a ring buffer of its own, so recording needs no locks, and the most recent spans of
+/// each thread are kept. The spans of all threads can be exported in the Chrome trace event format, which can be viewed
+/// using chrome://tracing or the Perfetto UI.
+///
+/// Tracing is disabled by default. While it is disabled, a span costs a single predictable branch.
+class Trace final
+{
+public:
+	/// @brief The clock used for the spans
+	using Clock = std::chrono::steady_clock;
+
+	/// @brief Records the time between its construction and destruction as a span.
+	///
+	/// The name and category must be string literals, or otherwise live for the rest of the program, and must not contain
+	/// any characters that need escaping in JSON.
+	class Span final : private utils::tools::Unique
+	{
+	public:
+		/// @brief Starts the span, if tracing is enabled
+		/// @param name The name of the span
+		/// @param category The category of the span
+		Span(const char *name, const char *category) noexcept
+		{
+			if (enabled()) [[unlikely]]
+			{
+				_name = name;
+				_category = category;
+				_start = Clock::now();
+			}
+		}
+
+		/// @brief Ends the span, and records it if it was started
+		~Span()
+		{
+			if (_name) [[unlikely]]
+			{
+				record(_name, _category, _start, Clock::now());
+			}
+		}
+
+	private:
+		/// @brief The name, or nullptr if tracing was disabled when the span was started
+		const char *_name { nullptr };
+		/// @brief The category
+		const char *_category { nullptr };
+		/// @brief The time the span was started
+		Clock::time_point _start;
+	};
+
+	/// @brief Checks whether tracing is enabled
+	static auto enabled() noexcept -> bool
+	{
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Enables tracing.
+	///
+	/// If tracing is enabled several times, the largest buffer size is used for threads that have not recorded any spans yet.
+	/// @param bufferSize The number of spans to keep for each thread
+	static auto enable(std::size_t bufferSize) -> void;
+
+	/// @brief Writes the recorded spans of all threads in the Chrome trace event format
+	static auto write(std::ostream &stream) -> void;
+
+	/// @brief Writes the recorded spans of all threads to a file in the Chrome trace event format.
+	///
+	/// The file is replaced atomically, so that a reader never sees a partially written file.
+	static auto dump(const std::filesystem::path &path) -> void;
+
+private:
+	/// @brief Records a span in the buffer of the calling thread
+	static auto record(const char *name, const char *category, Clock::time_point start, Clock::time_point end) noexcept -> void;
+
+	/// @brief Whether tracing is enabled
+	static inline std::atomic<bool> _enabled { false };
+};
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,294 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "Reactor.hpp"
+#include "Session.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A coroutine that performs an operation on a device, like connecting, reading, or writing.
+///
+/// Transactions can await device requests using Reactor::exchange(), and other transactions using co_await. A transaction does not
+/// start running until it is either awaited, or detached using detach(). Whenever a transaction awaits a device request, it is
+/// suspended until the response arrives, and is then resumed on the reactor thread. This allows multi-step operations, like
+/// read-modify-write cycles, to overlap with other traffic without blocking any thread.
+///
+/// If one of the parameters of the coroutine is a Session::Lease, the coroutine frame is allocated from the frame pool of the
+/// reactor of the leased session, so that starting a transaction does not cost a heap allocation.
+///
+/// Transactions report errors by throwing exceptions, just like the synchronous functions.
+/// @tparam Result The type of the result of the transaction
+template <typename Result = void>
+class [[nodiscard]] Transaction final
+{
+public:
+	/// @brief The promise type of the coroutine
+	class promise_type;
+
+	/// @brief Move constructor
+	Transaction(Transaction &&other) noexcept : _coroutine(std::exchange(other._coroutine, nullptr))
+	{
+	}
+
+	/// @brief Transactions cannot be assigned
+	auto operator=(Transaction &&other) -> Transaction & = delete;
+
+	/// @brief Destructor. Destroys the transaction if it was never started.
+	~Transaction()
+	{
+		if (_coroutine)
+		{
+			_coroutine.destroy();
+		}
+	}
+
+	/// @brief Starts the transaction and waits for it to finish
+	/// @return An awaitable that returns the result of the transaction, or throws the exception the transaction exited with.
+	auto operator co_await() && noexcept;
+
+	/// @brief Starts the transaction without waiting for it.
+	///
+	/// The transaction destroys itself when it is finished. Detached transactions must catch and handle their own errors,
+	/// because there is no-one to report them to. An exception escaping a detached transaction is discarded.
+	auto detach() && -> void;
+
+private:
+	/// @brief Constructor for the promise
+	explicit Transaction(std::coroutine_handle<promise_type> coroutine) noexcept : _coroutine(coroutine)
+	{
+	}
+
+	/// @brief The coroutine, or nullptr if it has been started
+	std::coroutine_handle<promise_type> _coroutine;
+};
+
+/// @brief Base class for the promise types of transactions, which manages the coroutine frames.
+class TransactionPromiseBase
+{
+public:
+	/// @brief Allocates a coroutine frame.
+	///
+	/// This is used by the compiler, and is passed the parameters of the coroutine in addition to the size of the frame.
+	template <typename... Arguments>
+	static auto operator new(std::size_t size, const Arguments &...arguments) -> void *
+	{
+		// Find the frame pool of the first valid lease, if there is one
+		std::pmr::memory_resource *pool = nullptr;
+		((pool = pool ? pool : framePool(arguments)), ...);
+
+		// Allocate the frame with room for a header in front that remembers where the frame came from
+		void *memory = pool ? pool->allocate(size + sizeof(FrameHeader), alignof(FrameHeader)) : ::operator new(size + sizeof(FrameHeader));
+		auto header = ::new (memory) FrameHeader { pool };
+		return header + 1;
+	}
+
+	/// @brief Frees a coroutine frame allocated using operator new()
+	static auto operator delete(void *frame, std::size_t size) noexcept -> void
+	{
+		auto header = static_cast<FrameHeader *>(frame) - 1;
+		if (const auto pool = header->_pool)
+		{
+			pool->deallocate(header, size + sizeof(FrameHeader), alignof(FrameHeader));
+		}
+		else
+		{
+			::operator delete(header);
+		}
+	}
+
+	/// @brief Transactions do not start before they are awaited or detached
+	auto initial_suspend() noexcept -> std::suspend_always
+	{
+		return {};
+	}
+
+	/// @brief Stores the exception the transaction exited with
+	auto unhandled_exception() noexcept -> void
+	{
+		_exception = std::current_exception();
+	}
+
+protected:
+	/// @brief The awaitable used at the end of the transaction, which continues the awaiting coroutine
+	struct FinalAwaiter final
+	{
+		auto await_ready() const noexcept -> bool
+		{
+			return false;
+		}
+
+		template <typename Promise>
+		auto await_suspend(std::coroutine_handle<Promise> coroutine) noexcept -> std::coroutine_handle<>
+		{
+			auto &promise = coroutine.promise();
+
+			// Resume the awaiting coroutine, if there is one. Detached transactions destroy themselves instead.
+			if (promise._continuation)
+			{
+				return promise._continuation;
+			}
+			coroutine.destroy();
+			return std::noop_coroutine();
+		}
+
+		auto await_resume() const noexcept -> void
+		{
+		}
+	};
+
+	/// @brief Rethrows the exception the transaction exited with, if any
+	auto rethrow() const -> void
+	{
+		if (_exception)
+		{
+			std::rethrow_exception(_exception);
+		}
+	}
+
+private:
+	/// @brief Transactions set the continuation
+	template <typename>
+	friend class Transaction;
+
+	/// @brief The header in front of each coroutine frame
+	struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) FrameHeader final
+	{
+		/// @brief The pool the frame was allocated from, or nullptr if it was allocated from the heap
+		std::pmr::memory_resource *_pool;
+	};
+
+	/// @brief Gets the frame pool for a coroutine parameter
+	/// @return The pool of the reactor of the session, if the parameter is a valid lease, or nullptr otherwise.
+	template <typename Argument>
+	static auto framePool(const Argument &argument) noexcept -> std::pmr::memory_resource *
+	{
+		if constexpr (std::is_same_v<Argument, Session::Lease>)
+		{
+			return argument ? &argument.session().reactor().framePool() : nullptr;
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+
+	/// @brief The coroutine awaiting the transaction, or nullptr if the transaction was detached
+	std::coroutine_handle<> _continuation;
+	/// @brief The exception the transaction exited with, if any
+	std::exception_ptr _exception;
+};
+
+/// @brief The promise type of transactions that return a value
+template <typename Result>
+class Transaction<Result>::promise_type final : public TransactionPromiseBase
+{
+public:
+	/// @brief Creates the transaction object
+	auto get_return_object() noexcept -> Transaction
+	{
+		return Transaction(std::coroutine_handle<promise_type>::from_promise(*this));
+	}
+
+	/// @brief Finishes the transaction
+	auto final_suspend() noexcept -> FinalAwaiter
+	{
+		return {};
+	}
+
+	/// @brief Stores the result
+	template <typename Value>
+	auto return_value(Value &&value) -> void
+	{
+		_result.emplace(std::forward<Value>(value));
+	}
+
+	/// @brief Gets the result, or throws the exception the transaction exited with
+	auto result() -> Result
+	{
+		rethrow();
+		return std::move(*_result);
+	}
+
+private:
+	/// @brief The result
+	std::optional<Result> _result;
+};
+
+/// @brief The promise type of transactions that do not return a value
+template <>
+class Transaction<void>::promise_type final : public TransactionPromiseBase
+{
+public:
+	/// @brief Creates the transaction object
+	auto get_return_object() noexcept -> Transaction
+	{
+		return Transaction(std::coroutine_handle<promise_type>::from_promise(*this));
+	}
+
+	/// @brief Finishes the transaction
+	auto final_suspend() noexcept -> FinalAwaiter
+	{
+		return {};
+	}
+
+	/// @brief Finishes the transaction without a value
+	auto return_void() noexcept -> void
+	{
+	}
+
+	/// @brief Throws the exception the transaction exited with, if any
+	auto result() -> void
+	{
+		rethrow();
+	}
+};
+
+template <typename Result>
+auto Transaction<Result>::operator co_await() && noexcept
+{
+	// The awaitable owns the coroutine, so that the frame is destroyed when the awaiting expression is finished
+	struct Awaiter final
+	{
+		auto await_ready() const noexcept -> bool
+		{
+			return false;
+		}
+
+		auto await_suspend(std::coroutine_handle<> continuation) noexcept -> std::coroutine_handle<>
+		{
+			// Start the transaction, and have it resume the awaiting coroutine when it is finished
+			_coroutine.promise()._continuation = continuation;
+			return _coroutine;
+		}
+
+		auto await_resume() -> Result
+		{
+			return _coroutine.promise().result();
+		}
+
+		Transaction _transaction;
+		std::coroutine_handle<promise_type> _coroutine;
+	};
+
+	auto coroutine = _coroutine;
+	return Awaiter { std::move(*this), coroutine };
+}
+
+template <typename Result>
+auto Transaction<Result>::detach() && -> void
+{
+	// Release the coroutine, and start it. It destroys itself when it is done, because it has no continuation.
+	std::exchange(_coroutine, nullptr).resume();
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,78 @@
+// Copyright (c) embedded ocean GmbH
+#include "Transport.hpp"
+
+#include "CustomError.hpp"
+#include "EpollTransport.hpp"
+#include "IoUringTransport.hpp"
+#include "Trace.hpp"
+
+#include <stdexcept>
+#include <system_error>
+
+namespace xentara::plugins::templateDriver
+{
+
+Transport::Transport() : _buffers(std::make_unique<std::byte[]>(2 * kMaxBatchSize * kBufferSize))
+{
+}
+
+auto Transport::Batch::queue(std::size_t requestSize, std::size_t responseSize) -> std::span<std::byte>
+{
+	if (_size >= kMaxBatchSize)
+	{
+		throw std::length_error("too many requests in transport batch");
+	}
+	if (requestSize > kBufferSize || responseSize > kBufferSize)
+	{
+		throw std::length_error("request or response too large for transport buffer");
+	}
+
+	_exchanges[_size] = { requestSize, responseSize };
+	return _transport.requestBuffer(_size++).first(requestSize);
+}
+
+auto Transport::Batch::submit() -> void
+{
+	Trace::Span span { "exchange", "io" };
+
+	try
+	{
+		_transport.exchange(std::span(_exchanges).first(_size));
+	}
+	catch (const std::system_error &exception)
+	{
+		// Count the timeouts, so the I/O component can decide when a device that keeps timing out counts as disconnected
+		if (exception.code() == CustomError::Timeout)
+		{
+			_transport._consecutiveTimeouts.fetch_add(1, std::memory_order_relaxed);
+		}
+		throw;
+	}
+
+	// The device responded
+	_transport._consecutiveTimeouts.store(0, std::memory_order_relaxed);
+}
+
+auto Transport::create(int socket) -> std::unique_ptr<Transport>
+{
+#ifdef XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
+	// Try io_uring first. This fails on kernels that do not support it, or where it has been disabled.
+	try
+	{
+		return std::make_unique<IoUringTransport>(socket);
+	}
+	catch (const std::system_error &)
+	{
+		// Fall back to epoll
+	}
+#endif // XENTARA_TEMPLATE_DRIVER_HAVE_LIBURING
+
+#ifndef _WIN32
+	return std::make_unique<EpollTransport>(socket);
+#else // _WIN32
+	/// @todo implement a transport for Windows
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "no transport available");
+#endif // _WIN32
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
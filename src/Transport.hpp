@@ -0,0 +1,158 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace xentara::plugins::templateDriver
+{
+
+using namespace std::literals;
+
+/// @brief Base class for transports that exchange requests and responses with a device over a stream socket.
+///
+/// Requests are exchanged in batches. The requests of a batch are encoded directly into buffers owned by the transport, all sent
+/// together, and the responses are received directly into buffers owned by the transport as well. Handlers decode the responses
+/// straight from these buffers, so no data is copied anywhere along the way. Implementations can register the buffers with the
+/// kernel once, so that they need not be mapped again for each request.
+///
+/// A transport can only be used by one thread at a time. A Batch object locks the transport for as long as it exists.
+/// @todo adapt the buffer sizes and the timeout to the protocol used by the device
+/// @todo if a request times out, its response may still arrive later. If the protocol has transaction IDs, discard responses
+/// with unexpected IDs. Otherwise, a single timeout leaves the stream out of step, and timeoutsBeforeDisconnect should be set to 1.
+class Transport : private utils::tools::Unique
+{
+public:
+	/// @brief The size of the buffer for each request and each response
+	static constexpr std::size_t kBufferSize = 512;
+	/// @brief The maximum number of requests in a batch
+	static constexpr std::size_t kMaxBatchSize = 64;
+	/// @brief How long to wait for the responses of a batch
+	static constexpr std::chrono::milliseconds kTimeout = 1s;
+
+	/// @brief A request with the expected size of its response
+	struct Exchange final
+	{
+		/// @brief The size of the request
+		std::size_t _requestSize { 0 };
+		/// @brief The size of the response
+		std::size_t _responseSize { 0 };
+	};
+
+	/// @brief A batch of requests to be sent together.
+	///
+	/// Creating a batch locks the transport until the batch is destroyed.
+	class Batch final : private utils::tools::Unique
+	{
+	public:
+		/// @brief Creates an empty batch
+		explicit Batch(Transport &transport) : _transport(transport), _lock(transport._mutex)
+		{
+		}
+
+		/// @brief Adds a request to the batch
+		/// @param requestSize The size of the request
+		/// @param responseSize The size of the expected response
+		/// @return The buffer to encode the request into. The index of the request is size() - 1.
+		/// @throw std::length_error if the batch is full, or if the request or the response are too large
+		auto queue(std::size_t requestSize, std::size_t responseSize) -> std::span<std::byte>;
+
+		/// @brief Returns the number of requests in the batch
+		auto size() const noexcept -> std::size_t
+		{
+			return _size;
+		}
+
+		/// @brief Sends all the requests, and waits for all the responses
+		/// @throw std::system_error on error. If the device does not respond in time, the error code is CustomError::Timeout.
+		auto submit() -> void;
+
+		/// @brief Returns the response to a request. This must only be called after submit() has returned successfully.
+		/// @param index The index of the request
+		auto response(std::size_t index) const noexcept -> std::span<const std::byte>
+		{
+			return _transport.responseBuffer(index).first(_exchanges[index]._responseSize);
+		}
+
+	private:
+		/// @brief The transport
+		Transport &_transport;
+		/// @brief The lock on the transport
+		std::scoped_lock<std::mutex> _lock;
+		/// @brief The requests
+		std::array<Exchange, kMaxBatchSize> _exchanges;
+		/// @brief The number of requests
+		std::size_t _size { 0 };
+	};
+
+	/// @brief Creates the best transport available on this system
+	///
+	/// This uses io_uring if the plugin was built with io_uring support and the kernel supports it, and epoll otherwise.
+	/// @param socket A connected stream socket. The transport does not take ownership of the socket.
+	/// @throw std::system_error if no transport could be created
+	static auto create(int socket) -> std::unique_ptr<Transport>;
+
+	/// @brief Returns the number of batches in a row that have timed out
+	auto consecutiveTimeouts() const noexcept -> std::size_t
+	{
+		return _consecutiveTimeouts.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Virtual destructor
+	/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+	/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+	/// instantiable by accident as a result of refactoring.
+	virtual ~Transport() = 0;
+
+protected:
+	/// @brief Constructor. Allocates the buffers.
+	Transport();
+
+	/// @brief Sends all the requests, and receives all the responses.
+	///
+	/// The request for each exchange is in requestBuffer(), and the response must be placed in responseBuffer() at the same index.
+	/// If the responses do not arrive within kTimeout, any operations still in progress must be cancelled, so that the transport
+	/// can be used again.
+	/// @throw std::system_error on error. Timeouts must be reported using CustomError::Timeout.
+	virtual auto exchange(std::span<const Exchange> exchanges) -> void = 0;
+
+	/// @brief Returns the buffer for a request
+	auto requestBuffer(std::size_t index) const noexcept -> std::span<std::byte>
+	{
+		return { _buffers.get() + index * kBufferSize, kBufferSize };
+	}
+
+	/// @brief Returns the buffer for a response
+	auto responseBuffer(std::size_t index) const noexcept -> std::span<std::byte>
+	{
+		return { _buffers.get() + (kMaxBatchSize + index) * kBufferSize, kBufferSize };
+	}
+
+	/// @brief Returns all the buffers as a single block.
+	///
+	/// The block contains kMaxBatchSize request buffers, followed by kMaxBatchSize response buffers.
+	auto buffers() const noexcept -> std::span<std::byte>
+	{
+		return { _buffers.get(), 2 * kMaxBatchSize * kBufferSize };
+	}
+
+private:
+	/// @brief The request and response buffers
+	std::unique_ptr<std::byte[]> _buffers;
+	/// @brief The number of batches in a row that have timed out
+	std::atomic<std::size_t> _consecutiveTimeouts { 0 };
+
+	/// @brief The mutex that makes sure only one batch uses the transport at a time
+	std::mutex _mutex;
+};
+
+inline Transport::~Transport() = default;
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -0,0 +1,380 @@
+// Copyright (c) embedded ocean GmbH
+#pragma once
+
+#include "RateLimiter.hpp"
+#include "Session.hpp"
+#include "TimingWheel.hpp"
+#include "Transport.hpp"
+
+#include <xentara/utils/eh/currentErrorCode.hpp>
+#include <xentara/utils/tools/Unique.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+namespace xentara::plugins::templateDriver
+{
+
+/// @brief A lock-free priority lane for outputs that have values waiting to be written.
+///
+/// Outputs add themselves to the lane as soon as a value is scheduled. The I/O component drains the lane between the reads of
+/// a poll cycle, so that pending writes are sent to the device ahead of any reads that are still queued, instead of waiting for
+/// the whole cycle and the next tick of the "write" task.
+///
+/// The lane also has a doorbell that can be used to wake up a thread whenever an entry is added, so that values can be written
+/// immediately, without waiting for any task at all.
+///
+/// When the lane is drained, the values of all the entries are written using as few batches as possible, so that values scheduled
+/// together reach the device together.
+class WriteLane final : private utils::tools::Unique
+{
+public:
+	/// @brief Base class for objects that can be added to the lane
+	class Entry
+	{
+	public:
+		/// @brief Virtual destructor
+		/// @note The destructor is pure virtual (= 0) to ensure that this class will remain abstract, even if we should remove all
+		/// other pure virtual functions later. This is not necessary, of course, but prevents the abstract class from becoming
+		/// instantiable by accident as a result of refactoring.
+		virtual ~Entry() = 0;
+
+		/// @brief Called when the lane is drained to write the pending value, if there still is one
+		/// @param lease A lease on the session to use
+		/// @param timeStamp The time stamp to use for the write
+		virtual auto performPendingWrite(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void = 0;
+
+		/// @brief Called when the lane is drained to add the request needed to write the pending value to a batch.
+		///
+		/// The entry may add at most one request to the batch. If there is no pending value, it need not add any.
+		///
+		/// The default implementation returns false, so that performPendingWrite() is called instead.
+		/// @param lease A lease on the session the batch will be sent over
+		/// @param batch The batch
+		/// @param timeStamp The time stamp to use for the write
+		/// @return true if the entry takes part in the batch, in which case either finishWrite() or abortWrite() is called later.
+		/// false if the value must be written separately using performPendingWrite(), which is called once the batch is done.
+		virtual auto queueWrite(const Session::Lease & /*lease*/, Transport::Batch & /*batch*/,
+			std::chrono::system_clock::time_point /*timeStamp*/) -> bool
+		{
+			return false;
+		}
+
+		/// @brief Called after the batch was submitted successfully, if queueWrite() returned true
+		/// @param lease A lease on the session the batch was sent over
+		/// @param batch The batch, from which the response can be decoded
+		/// @param timeStamp The time stamp to use for the write
+		virtual auto finishWrite(const Session::Lease & /*lease*/, const Transport::Batch & /*batch*/,
+			std::chrono::system_clock::time_point /*timeStamp*/) -> void
+		{
+		}
+
+		/// @brief Called if the batch could not be submitted, if queueWrite() returned true
+		/// @param lease A lease on the session the batch was to be sent over
+		/// @param timeStamp The time stamp to use for the write
+		/// @param error The error that occurred
+		virtual auto abortWrite(const Session::Lease & /*lease*/, std::chrono::system_clock::time_point /*timeStamp*/,
+			std::error_code /*error*/) -> void
+		{
+		}
+
+	private:
+		/// @brief The lane links the entries
+		friend class WriteLane;
+
+		/// @brief Whether the entry is currently in a lane
+		std::atomic<bool> _queued { false };
+		/// @brief The next entry in the lane
+		Entry *_next { nullptr };
+	};
+
+	/// @brief Destructor. Cancels any pending retry.
+	~WriteLane()
+	{
+		if (const auto wheel = _retryWheel.load(std::memory_order_relaxed))
+		{
+			wheel->cancel(_retryTimer);
+		}
+	}
+
+	/// @brief Adds an entry to the lane, unless it is already in it.
+	///
+	/// This function is thread-safe and lock-free.
+	auto push(Entry &entry) noexcept -> void;
+
+	/// @brief Adds an entry back to the lane whose value could not be written yet because of the rate limit of the device.
+	///
+	/// The doorbell is not rung right away, because writing the value would only fail again. Instead, it is rung once the
+	/// delay has passed. Until then, the entry is also retried by any other drain of the lane.
+	/// @param entry The entry
+	/// @param delay The time after which the value can probably be written
+	auto defer(Entry &entry, TimingWheel::Clock::duration delay) -> void;
+
+	/// @brief Checks whether there are any entries in the lane
+	auto empty() const noexcept -> bool
+	{
+		return _head.load(std::memory_order_relaxed) == nullptr;
+	}
+
+	/// @brief Returns the number of entries in the lane.
+	///
+	/// The count may briefly include an entry that is just being added.
+	auto size() const noexcept -> std::size_t
+	{
+		return _size.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Returns the time the oldest entry now in the lane was added.
+	///
+	/// This is only tracked while the doorbell is enabled. It is only meaningful if the lane is not empty, and may be older than
+	/// the actual time if the lane was drained concurrently, but is never newer.
+	auto oldestTime() const noexcept -> std::chrono::steady_clock::time_point
+	{
+		return _oldestTime.load(std::memory_order_relaxed);
+	}
+
+	/// @brief Removes all entries from the lane, and writes their pending values in the order they were added.
+	///
+	/// The values are sent in batches of as many values as the rate limit of the device allows to be sent back to back. Entries
+	/// that cannot take part in a batch are written after the batch that would have contained them. Entries added while the lane
+	/// is being drained are left for the next call.
+	/// @param lease A lease on the session to use
+	/// @param timeStamp The time stamp to use for the writes
+	auto drain(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void;
+
+	/// @brief Enables or disables ringing the doorbell when an entry is added.
+	///
+	/// The doorbell is disabled by default, because ringing it costs a system call if a thread is waiting.
+	auto enableDoorbell(bool enabled = true) noexcept -> void
+	{
+		_doorbellEnabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	/// @brief Rings the doorbell, waking up any thread waiting in waitForDoorbell()
+	auto ringDoorbell() noexcept -> void
+	{
+		_doorbell.fetch_add(1, std::memory_order_release);
+		_doorbell.notify_one();
+	}
+
+	/// @brief Waits for the doorbell to be rung
+	/// @param ring The value returned by the last call, or 0 for the first call
+	/// @return A value to pass to the next call
+	auto waitForDoorbell(std::uint32_t ring) noexcept -> std::uint32_t
+	{
+		_doorbell.wait(ring, std::memory_order_acquire);
+		return _doorbell.load(std::memory_order_acquire);
+	}
+
+private:
+	/// @brief A timer that rings the doorbell when deferred entries should be retried
+	class RetryTimer final : public TimingWheel::Timer
+	{
+	public:
+		/// @brief Constructor
+		explicit RetryTimer(WriteLane &lane) noexcept : _lane(lane)
+		{
+		}
+
+	private:
+		auto expired() noexcept -> void final
+		{
+			_lane.ringDoorbell();
+		}
+
+		/// @brief The lane
+		WriteLane &_lane;
+	};
+
+	/// @brief Links an entry into the lane, unless it is already in it.
+	/// @return The entry that was at the head of the lane before, or nullptr if the lane was empty. If the entry was already in
+	/// the lane, the entry itself is returned.
+	auto link(Entry &entry) noexcept -> Entry *;
+
+	/// @brief The entry that was added last, or nullptr if the lane is empty
+	std::atomic<Entry *> _head { nullptr };
+	/// @brief The number of entries in the lane
+	std::atomic<std::size_t> _size { 0 };
+	/// @brief The time the first entry was added to the empty lane
+	std::atomic<std::chrono::steady_clock::time_point> _oldestTime;
+
+	/// @brief Whether to ring the doorbell when an entry is added
+	std::atomic<bool> _doorbellEnabled { false };
+	/// @brief The doorbell. This is a counter that is incremented each time the doorbell is rung.
+	std::atomic<std::uint32_t> _doorbell { 0 };
+
+	/// @brief The timer used to retry deferred entries
+	RetryTimer _retryTimer { *this };
+	/// @brief The wheel the retry timer was last scheduled with, or nullptr if it never was
+	std::atomic<TimingWheel *> _retryWheel { nullptr };
+};
+
+inline WriteLane::Entry::~Entry() = default;
+
+inline auto WriteLane::link(Entry &entry) noexcept -> Entry *
+{
+	// Don't add the entry twice. The pending value is only fetched when the entry is written, so one entry covers any number of values.
+	if (entry._queued.exchange(true, std::memory_order_acq_rel))
+	{
+		return &entry;
+	}
+
+	// Count the entry before it becomes visible, so that drain() never takes away more entries than were counted
+	_size.fetch_add(1, std::memory_order_relaxed);
+
+	// Push the entry onto the front of the list
+	auto head = _head.load(std::memory_order_relaxed);
+	do
+	{
+		entry._next = head;
+	}
+	while (!_head.compare_exchange_weak(head, &entry, std::memory_order_release, std::memory_order_relaxed));
+
+	return head;
+}
+
+inline auto WriteLane::push(Entry &entry) noexcept -> void
+{
+	const auto head = link(entry);
+	if (head == &entry)
+	{
+		return;
+	}
+
+	// Wake up the thread waiting for entries, if there is one
+	if (_doorbellEnabled.load(std::memory_order_relaxed))
+	{
+		// Record when the lane stopped being empty, so that the thread can bound the time entries are held back. This is stored
+		// before ringing the doorbell, which makes it visible to the thread.
+		if (!head)
+		{
+			_oldestTime.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+		}
+		ringDoorbell();
+	}
+}
+
+inline auto WriteLane::defer(Entry &entry, TimingWheel::Clock::duration delay) -> void
+{
+	link(entry);
+
+	// Wake up the thread waiting for entries once the value can be written. The time the lane stopped being empty is left alone,
+	// because the value has already been held back long enough.
+	if (_doorbellEnabled.load(std::memory_order_relaxed))
+	{
+		auto &wheel = TimingWheel::shared();
+		_retryWheel.store(&wheel, std::memory_order_relaxed);
+		wheel.schedule(_retryTimer, delay);
+	}
+}
+
+inline auto WriteLane::drain(const Session::Lease &lease, std::chrono::system_clock::time_point timeStamp) -> void
+{
+	// Take all the entries at once
+	auto entries = _head.exchange(nullptr, std::memory_order_acquire);
+
+	// The entries are linked in reverse order, so reverse the list to write them in the order they were scheduled
+	Entry *ordered = nullptr;
+	std::size_t count = 0;
+	while (entries)
+	{
+		auto next = entries->_next;
+		entries->_next = ordered;
+		ordered = entries;
+		entries = next;
+		++count;
+	}
+	_size.fetch_sub(count, std::memory_order_relaxed);
+
+	// Write the entries in batches
+	const auto batchLimit = std::clamp<std::size_t>(lease.session().rateLimiter().batchLimit(), 1, Transport::kMaxBatchSize);
+	while (ordered)
+	{
+		// Take the entries of this round out of the lane before creating the batch, so that the loop makes progress even if the
+		// batch cannot be created. Each entry adds at most one request, so taking no more entries than the limit keeps the batch
+		// within the limit. We cannot keep the entries linked, because an entry may be added to the lane again as soon as we have
+		// taken it out.
+		std::array<Entry *, Transport::kMaxBatchSize> round;
+		std::size_t roundSize = 0;
+		while (ordered && roundSize < batchLimit)
+		{
+			auto &entry = *ordered;
+			ordered = entry._next;
+
+			// Remove the entry from the lane before writing, so that a value scheduled during the write adds it again
+			entry._queued.store(false, std::memory_order_release);
+			round[roundSize++] = &entry;
+		}
+
+		// The entries that take part in the batch, and the ones that must be written separately
+		std::array<Entry *, Transport::kMaxBatchSize> batched;
+		std::size_t batchedCount = 0;
+		std::array<Entry *, Transport::kMaxBatchSize> separate;
+		std::size_t separateCount = 0;
+
+		std::error_code error;
+		// The number of entries in the round that were offered to the batch
+		std::size_t offered = 0;
+		try
+		{
+			Transport::Batch batch(lease.handle().transport());
+			for (; offered < roundSize; ++offered)
+			{
+				auto &entry = *round[offered];
+				if (entry.queueWrite(lease, batch, timeStamp))
+				{
+					batched[batchedCount++] = &entry;
+				}
+				else
+				{
+					separate[separateCount++] = &entry;
+				}
+			}
+
+			// Send all the values together, and let the entries decode the responses directly from the receive buffers
+			if (batch.size() != 0)
+			{
+				batch.submit();
+			}
+			for (auto &&entry : std::span(batched).first(batchedCount))
+			{
+				entry->finishWrite(lease, batch, timeStamp);
+			}
+		}
+		catch (...)
+		{
+			error = utils::eh::currentErrorCode();
+		}
+
+		// If the exchange failed, none of the values in the batch were written. This is done after the batch has released the
+		// transport, because the entries report the error to the I/O component.
+		if (error)
+		{
+			for (auto &&entry : std::span(batched).first(batchedCount))
+			{
+				entry->abortWrite(lease, timeStamp, error);
+			}
+		}
+
+		// The entries that were never offered to the batch because it failed before still have their values, so they are written
+		// separately as well, and report any error themselves
+		for (auto &&entry : std::span(round).first(roundSize).subspan(offered))
+		{
+			separate[separateCount++] = entry;
+		}
+
+		// Write the entries that could not take part in the batch
+		for (auto &&entry : std::span(separate).first(separateCount))
+		{
+			entry->performPendingWrite(lease, timeStamp);
+		}
+	}
+}
+
+} // namespace xentara::plugins::templateDriver
\ No newline at end of file
@@ -3,11 +3,13 @@
 
 #include "Attributes.hpp"
 #include "Events.hpp"
+#include "Trace.hpp"
 
 #include <xentara/memory/memoryResources.hpp>
 #include <xentara/memory/WriteSentinel.hpp>
 #include <xentara/process/EventList.hpp>
 
+#include <algorithm>
 #include <string_view>
 
 namespace xentara::plugins::templateDriver
@@ -20,7 +22,9 @@ auto WriteState::forEachAttribute(const model::ForEachAttributeFunction &functio
 	// Handle all the attributes we support
 	return
 		function(model::Attribute::kWriteTime) ||
-		function(attributes::kWriteError);
+		function(attributes::kWriteError) ||
+		function(attributes::kWriteLatency) ||
+		function(attributes::kMaxWriteLatency);
 }
 
 auto WriteState::forEachEvent(const model::ForEachEventFunction &function, std::shared_ptr<void> parent) -> bool
@@ -42,6 +46,14 @@ auto WriteState::makeReadHandle(const model::Attribute &attribute) const noexcep
 	{
 		return _dataBlock.member(&State::_writeError);
 	}
+	else if (attribute == attributes::kWriteLatency)
+	{
+		return _dataBlock.member(&State::_writeLatency);
+	}
+	else if (attribute == attributes::kMaxWriteLatency)
+	{
+		return _dataBlock.member(&State::_maxWriteLatency);
+	}
 
 	return std::nullopt;
 }
@@ -52,19 +64,26 @@ auto WriteState::realize() -> void
 	_dataBlock.create(memory::memoryResources::data());
 }
 
-auto WriteState::update(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void
+auto WriteState::update(std::chrono::system_clock::time_point timeStamp, std::error_code error,
+	std::optional<std::chrono::steady_clock::duration> latency) -> void
 {
 	// Make a write sentinel
 	memory::WriteSentinel sentinel { _dataBlock };
 	auto &state = *sentinel;
+	const auto &oldState = sentinel.oldValue();
 
 	// Update the state
 	state._writeTime = timeStamp;
 	state._writeError = error;
 
+	// Update the latencies. We always need to write the latencies, even if they are the same as before, because memory resources use swap-in.
+	state._writeLatency = latency ? std::chrono::duration<double>(*latency).count() : oldState._writeLatency;
+	state._maxWriteLatency = std::max(oldState._maxWriteLatency, state._writeLatency);
+
 	// Determine the correct event
 	const auto &event = error ? _writeErrorEvent : _writtenEvent;
 	// Commit the data and raise the event
+	Trace::Span span { "commit", "commit" };
 	sentinel.commit(timeStamp, event);
 }
 
@@ -49,7 +49,10 @@ public:
 	/// @brief Updates the data and sends events
 	/// @param timeStamp The update time stamp
 	/// @param error The error code, or a default constructed std::error_code object if no error occurred
-	auto update(std::chrono::system_clock::time_point timeStamp, std::error_code error) -> void;
+	/// @param latency The time between scheduling the value and the acknowledgement by the device, or std::nullopt
+	/// to keep the previous latency
+	auto update(std::chrono::system_clock::time_point timeStamp, std::error_code error,
+		std::optional<std::chrono::steady_clock::duration> latency = std::nullopt) -> void;
 
 private:
 	/// @brief This structure is used to represent the state inside the memory block
@@ -60,6 +63,10 @@ private:
 		/// @brief The error code when writing the value, or a default constructed std::error_code object for none.
 		/// @note The error is default initialized, because it is not an error if the value was never written.
 		std::error_code _writeError;
+		/// @brief The time between scheduling the last successfully written value and its acknowledgement by the device, in seconds
+		double _writeLatency { 0.0 };
+		/// @brief The highest latency of any successfully written value so far, in seconds
+		double _maxWriteLatency { 0.0 };
 	};
 
 	/// @brief A Xentara event that is raised when the value was successfully written
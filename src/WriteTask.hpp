@@ -1,6 +1,8 @@
 // Copyright (c) embedded ocean GmbH
 #pragma once
 
+#include "Trace.hpp"
+
 #include <xentara/process/Task.hpp>
 #include <xentara/process/ExecutionContext.hpp>
 
@@ -68,6 +70,7 @@ auto WriteTask<Target>::preOperational(const process::ExecutionContext &context)
 template <typename Target>
 auto WriteTask<Target>::operational(const process::ExecutionContext &context) -> void
 {
+	Trace::Span span { "write task", "task" };
 	_target.get().performWriteTask(context);
 }
 